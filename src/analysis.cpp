@@ -0,0 +1,543 @@
+#include "analysis.h"
+
+#include <algorithm> // For std::sort
+#include <cstdio>    // For snprintf
+
+std::string disassemble(uint16_t instruction, Chip8Variant variant, uint16_t long_address) {
+    char text[32];
+    unsigned x = (instruction & 0x0F00) >> 8;
+    unsigned y = (instruction & 0x00F0) >> 4;
+    unsigned n = instruction & 0x000F;
+    unsigned nn = instruction & 0x00FF;
+    unsigned nnn = instruction & 0x0FFF;
+    switch (decode_operation(instruction, variant)) {
+        case OP_NOP:
+            if ((instruction & 0xF000) == 0) {
+                snprintf(text, sizeof(text), "SYS 0x%03X", nnn);
+            } else {
+                snprintf(text, sizeof(text), "DW 0x%04X", instruction);
+            }
+            break;
+        case OP_CLS: return "CLS";
+        case OP_RET: return "RET";
+        case OP_JP: snprintf(text, sizeof(text), "JP 0x%03X", nnn); break;
+        case OP_CALL: snprintf(text, sizeof(text), "CALL 0x%03X", nnn); break;
+        case OP_SE_VX_NN: snprintf(text, sizeof(text), "SE V%X, 0x%02X", x, nn); break;
+        case OP_SNE_VX_NN: snprintf(text, sizeof(text), "SNE V%X, 0x%02X", x, nn); break;
+        case OP_SE_VX_VY: snprintf(text, sizeof(text), "SE V%X, V%X", x, y); break;
+        case OP_LD_VX_NN: snprintf(text, sizeof(text), "LD V%X, 0x%02X", x, nn); break;
+        case OP_ADD_VX_NN: snprintf(text, sizeof(text), "ADD V%X, 0x%02X", x, nn); break;
+        case OP_LD_VX_VY: snprintf(text, sizeof(text), "LD V%X, V%X", x, y); break;
+        case OP_AND_VX_VY: snprintf(text, sizeof(text), "AND V%X, V%X", x, y); break;
+        case OP_XOR_VX_VY: snprintf(text, sizeof(text), "XOR V%X, V%X", x, y); break;
+        case OP_ADD_VX_VY: snprintf(text, sizeof(text), "ADD V%X, V%X", x, y); break;
+        case OP_SUB_VX_VY: snprintf(text, sizeof(text), "SUB V%X, V%X", x, y); break;
+        case OP_SHR_VX_VY: snprintf(text, sizeof(text), "SHR V%X, V%X", x, y); break;
+        case OP_SUBN_VX_VY: snprintf(text, sizeof(text), "SUBN V%X, V%X", x, y); break;
+        case OP_SHL_VX_VY: snprintf(text, sizeof(text), "SHL V%X, V%X", x, y); break;
+        case OP_SNE_VX_VY: snprintf(text, sizeof(text), "SNE V%X, V%X", x, y); break;
+        case OP_LD_I_NNN: snprintf(text, sizeof(text), "LD I, 0x%03X", nnn); break;
+        case OP_JP_V0_NNN: snprintf(text, sizeof(text), "JP V0, 0x%03X", nnn); break;
+        case OP_RND_VX_NN: snprintf(text, sizeof(text), "RND V%X, 0x%02X", x, nn); break;
+        case OP_DRW_VX_VY_N: snprintf(text, sizeof(text), "DRW V%X, V%X, %u", x, y, n); break;
+        case OP_SKP_VX: snprintf(text, sizeof(text), "SKP V%X", x); break;
+        case OP_SKNP_VX: snprintf(text, sizeof(text), "SKNP V%X", x); break;
+        case OP_LD_VX_DT: snprintf(text, sizeof(text), "LD V%X, DT", x); break;
+        case OP_LD_VX_K: snprintf(text, sizeof(text), "LD V%X, K", x); break;
+        case OP_LD_DT_VX: snprintf(text, sizeof(text), "LD DT, V%X", x); break;
+        case OP_LD_ST_VX: snprintf(text, sizeof(text), "LD ST, V%X", x); break;
+        case OP_ADD_I_VX: snprintf(text, sizeof(text), "ADD I, V%X", x); break;
+        case OP_LD_F_VX: snprintf(text, sizeof(text), "LD F, V%X", x); break;
+        case OP_LD_B_VX: snprintf(text, sizeof(text), "LD B, V%X", x); break;
+        case OP_LD_I_VX: snprintf(text, sizeof(text), "LD [I], V%X", x); break;
+        case OP_LD_VX_I: snprintf(text, sizeof(text), "LD V%X, [I]", x); break;
+        case OP_SCD_N: snprintf(text, sizeof(text), "SCD %u", n); break;
+        case OP_SCR: return "SCR";
+        case OP_SCL: return "SCL";
+        case OP_EXIT: return "EXIT";
+        case OP_LOW: return "LOW";
+        case OP_HIGH: return "HIGH";
+        case OP_DRW_VX_VY_16: snprintf(text, sizeof(text), "DRW V%X, V%X, 0", x, y); break;
+        case OP_LD_HF_VX: snprintf(text, sizeof(text), "LD HF, V%X", x); break;
+        case OP_LD_R_VX: snprintf(text, sizeof(text), "LD R, V%X", x); break;
+        case OP_LD_VX_R: snprintf(text, sizeof(text), "LD V%X, R", x); break;
+        case OP_SCU_N: snprintf(text, sizeof(text), "SCU %u", n); break;
+        case OP_SAVE_VX_VY: snprintf(text, sizeof(text), "SAVE V%X - V%X", x, y); break;
+        case OP_LOAD_VX_VY: snprintf(text, sizeof(text), "LOAD V%X - V%X", x, y); break;
+        case OP_LD_I_LONG: snprintf(text, sizeof(text), "LD I, 0x%04X", long_address); break;
+        case OP_PLANE_N: snprintf(text, sizeof(text), "PLANE %u", x); break;
+        case OP_AUDIO: return "AUDIO";
+        case OP_PITCH_VX: snprintf(text, sizeof(text), "PITCH V%X", x); break;
+        default: snprintf(text, sizeof(text), "DW 0x%04X", instruction); break;
+    }
+    return text;
+}
+
+const char* block_exit_name(BlockExit exit) {
+    switch (exit) {
+        case BlockExit::Fallthrough: return "fallthrough";
+        case BlockExit::Jump: return "jump";
+        case BlockExit::IndirectJump: return "indirect_jump";
+        case BlockExit::Call: return "call";
+        case BlockExit::Skip: return "skip";
+        case BlockExit::Return: return "return";
+        case BlockExit::Exit: return "exit";
+        case BlockExit::End: return "end";
+    }
+    return "unknown";
+}
+
+const char* edge_kind_name(EdgeKind kind) {
+    switch (kind) {
+        case EdgeKind::Next: return "next";
+        case EdgeKind::Jump: return "jump";
+        case EdgeKind::Call: return "call";
+        case EdgeKind::Skip: return "skip";
+    }
+    return "unknown";
+}
+
+static uint16_t word_at(const std::vector<uint8_t>& memory, int address) {
+    return (memory[address] << 8) | memory[address + 1];
+}
+
+// Bytes the instruction at address occupies: XO-CHIP's F000 NNNN carries a second word
+static int instruction_size(const std::vector<uint8_t>& memory, int address, Chip8Variant variant) {
+    return variant == Chip8Variant::XoChip && word_at(memory, address) == 0xF000 ? 4 : 2;
+}
+
+// Where control can go after a single instruction
+static BlockExit exit_of(Operation operation) {
+    switch (operation) {
+        case OP_JP: return BlockExit::Jump;
+        case OP_JP_V0_NNN: return BlockExit::IndirectJump;
+        case OP_CALL: return BlockExit::Call;
+        case OP_SE_VX_NN: case OP_SNE_VX_NN: case OP_SE_VX_VY: case OP_SNE_VX_VY:
+        case OP_SKP_VX: case OP_SKNP_VX:
+            return BlockExit::Skip;
+        case OP_RET: return BlockExit::Return;
+        case OP_EXIT: return BlockExit::Exit;
+        default: return BlockExit::Fallthrough;
+    }
+}
+
+// Walk every path from the entry point, marking instruction starts, code bytes and the
+// addresses where blocks must begin
+static void trace_reachable(RomAnalysis& analysis, std::vector<bool>& is_instruction, std::vector<bool>& is_leader) {
+    const std::vector<uint8_t>& memory = analysis.memory;
+    int memory_size = static_cast<int>(memory.size());
+    std::vector<int> pending = {analysis.program_start};
+    is_leader[analysis.program_start] = true;
+    auto add_target = [&](int target) {
+        if (target + 1 < memory_size) {
+            is_leader[target] = true;
+            pending.push_back(target);
+        }
+    };
+
+    while (!pending.empty()) {
+        int address = pending.back();
+        pending.pop_back();
+        while (address + 1 < memory_size && !is_instruction[address]) {
+            is_instruction[address] = true;
+            uint16_t instruction = word_at(memory, address);
+            int size = instruction_size(memory, address, analysis.variant);
+            for (int i = 0; i < size && address + i < memory_size; i++) {
+                analysis.byte_kinds[address + i] = BYTE_CODE;
+            }
+
+            int next = address + size;
+            BlockExit exit = exit_of(decode_operation(instruction, analysis.variant));
+            if (exit == BlockExit::Jump) {
+                add_target(instruction & 0x0FFF);
+                break;
+            }
+            if (exit == BlockExit::IndirectJump || exit == BlockExit::Return || exit == BlockExit::Exit) {
+                break;
+            }
+            if (exit == BlockExit::Call) {
+                add_target(instruction & 0x0FFF);
+                if (next < memory_size) {
+                    is_leader[next] = true;
+                }
+            } else if (exit == BlockExit::Skip && next + 1 < memory_size) {
+                is_leader[next] = true;
+                add_target(next + instruction_size(memory, next, analysis.variant));
+            }
+            address = next;
+        }
+    }
+}
+
+static void build_blocks(RomAnalysis& analysis, const std::vector<bool>& is_instruction, const std::vector<bool>& is_leader) {
+    const std::vector<uint8_t>& memory = analysis.memory;
+    int memory_size = static_cast<int>(memory.size());
+    for (int start = 0; start < memory_size; start++) {
+        if (!is_instruction[start]) {
+            continue;
+        }
+        analysis.instructions.push_back(static_cast<uint16_t>(start));
+        if (!is_leader[start]) {
+            continue;
+        }
+
+        BasicBlock block = {static_cast<uint16_t>(start), 0, 0, 0, BlockExit::End};
+        int address = start;
+        while (true) {
+            block.instruction_count += 1;
+            int next = address + instruction_size(memory, address, analysis.variant);
+            BlockExit exit = exit_of(decode_operation(word_at(memory, address), analysis.variant));
+            if (exit != BlockExit::Fallthrough || next + 1 >= memory_size || is_leader[next]) {
+                block.exit = exit == BlockExit::Fallthrough && next + 1 >= memory_size ? BlockExit::End : exit;
+                block.end = next;
+                block.last = static_cast<uint16_t>(address);
+                break;
+            }
+            address = next;
+        }
+        analysis.blocks.push_back(block);
+    }
+}
+
+static void build_edges(RomAnalysis& analysis, const std::vector<bool>& is_instruction) {
+    const std::vector<uint8_t>& memory = analysis.memory;
+    int memory_size = static_cast<int>(memory.size());
+    for (const BasicBlock& block : analysis.blocks) {
+        auto add = [&](int target, EdgeKind kind) {
+            if (target + 1 < memory_size && is_instruction[target]) {
+                analysis.edges.push_back({block.start, static_cast<uint16_t>(target), kind});
+            }
+        };
+        uint16_t instruction = word_at(memory, block.last);
+        switch (block.exit) {
+            case BlockExit::Fallthrough: add(block.end, EdgeKind::Next); break;
+            case BlockExit::Jump: add(instruction & 0x0FFF, EdgeKind::Jump); break;
+            case BlockExit::Call:
+                add(instruction & 0x0FFF, EdgeKind::Call);
+                add(block.end, EdgeKind::Next);
+                break;
+            case BlockExit::Skip:
+                add(block.end, EdgeKind::Next);
+                if (block.end + 1 < memory_size) {
+                    add(block.end + instruction_size(memory, block.end, analysis.variant), EdgeKind::Skip);
+                }
+                break;
+            default: break;
+        }
+    }
+}
+
+static void find_subroutines(RomAnalysis& analysis) {
+    std::vector<int> block_at(analysis.memory.size(), -1);
+    for (size_t b = 0; b < analysis.blocks.size(); b++) {
+        block_at[analysis.blocks[b].start] = static_cast<int>(b);
+    }
+
+    for (const CfgEdge& edge : analysis.edges) {
+        if (edge.kind != EdgeKind::Call) {
+            continue;
+        }
+        auto found = std::find_if(analysis.subroutines.begin(), analysis.subroutines.end(),
+                                  [&edge](const Subroutine& s) { return s.entry == edge.to; });
+        if (found == analysis.subroutines.end()) {
+            analysis.subroutines.push_back({edge.to, {}, 0});
+            found = analysis.subroutines.end() - 1;
+        }
+        found->call_sites.push_back(analysis.blocks[block_at[edge.from]].last);
+    }
+    std::sort(analysis.subroutines.begin(), analysis.subroutines.end(),
+              [](const Subroutine& a, const Subroutine& b) { return a.entry < b.entry; });
+
+    // Body: everything reachable from the entry without descending into further calls
+    std::vector<std::vector<int>> successors(analysis.blocks.size());
+    for (const CfgEdge& edge : analysis.edges) {
+        if (edge.kind != EdgeKind::Call) {
+            successors[block_at[edge.from]].push_back(block_at[edge.to]);
+        }
+    }
+    for (Subroutine& subroutine : analysis.subroutines) {
+        std::vector<bool> seen(analysis.blocks.size(), false);
+        std::vector<int> pending = {block_at[subroutine.entry]};
+        seen[pending[0]] = true;
+        while (!pending.empty()) {
+            int b = pending.back();
+            pending.pop_back();
+            subroutine.block_count += 1;
+            for (int target : successors[b]) {
+                if (!seen[target]) {
+                    seen[target] = true;
+                    pending.push_back(target);
+                }
+            }
+        }
+    }
+}
+
+// Follow I through each block from the ANNN that sets it to the instructions that use it
+static void find_data(RomAnalysis& analysis) {
+    const std::vector<uint8_t>& memory = analysis.memory;
+    int memory_size = static_cast<int>(memory.size());
+    std::vector<DataRegion> found;
+    auto add_region = [&](int start, int length, uint8_t uses) {
+        if (length > 0 && start < memory_size) {
+            found.push_back({static_cast<uint16_t>(start), start + length <= memory_size ? length : memory_size - start, uses});
+        }
+    };
+
+    for (const BasicBlock& block : analysis.blocks) {
+        int index = -1;       // Value of I if known
+        bool index_used = false;
+        auto forget_index = [&]() {
+            if (index >= 0 && !index_used) {
+                add_region(index, 1, DATA_POINTER);
+            }
+            index = -1;
+        };
+        auto store = [&](int pc, int length) {
+            if (index < 0) {
+                analysis.unresolved_writes += 1;
+                return;
+            }
+            index_used = true;
+            add_region(index, length, DATA_STORE);
+            for (int i = 0; i < length && index + i < memory_size; i++) {
+                if (analysis.byte_kinds[index + i] == BYTE_CODE) {
+                    analysis.code_writes.push_back({static_cast<uint16_t>(pc), static_cast<uint16_t>(index), length});
+                    break;
+                }
+            }
+        };
+        auto load = [&](int length, uint8_t use) {
+            if (index >= 0) {
+                index_used = true;
+                add_region(index, length, use);
+            }
+        };
+
+        for (int address = block.start; address < block.end; address += instruction_size(memory, address, analysis.variant)) {
+            uint16_t instruction = word_at(memory, address);
+            int x = (instruction & 0x0F00) >> 8;
+            int y = (instruction & 0x00F0) >> 4;
+            switch (decode_operation(instruction, analysis.variant)) {
+                case OP_LD_I_NNN:
+                    forget_index();
+                    index = instruction & 0x0FFF;
+                    index_used = false;
+                    break;
+                case OP_LD_I_LONG:
+                    forget_index();
+                    index = address + 3 < memory_size ? word_at(memory, address + 2) : -1;
+                    index_used = false;
+                    break;
+                // XO-CHIP may draw into both planes; one plane's sprite is the safe guess
+                case OP_DRW_VX_VY_N: load(instruction & 0x000F, DATA_SPRITE); break;
+                case OP_DRW_VX_VY_16: load(32, DATA_SPRITE); break;
+                case OP_LOAD_VX_VY: load((x <= y ? y - x : x - y) + 1, DATA_LOAD); break;
+                case OP_AUDIO: load(AUDIO_PATTERN_SIZE, DATA_LOAD); break;
+                case OP_LD_VX_I:
+                    load(x + 1, DATA_LOAD);
+                    forget_index(); // Moves I under the original quirks
+                    break;
+                case OP_LD_B_VX: store(address, 3); break;
+                case OP_SAVE_VX_VY: store(address, (x <= y ? y - x : x - y) + 1); break;
+                case OP_LD_I_VX:
+                    store(address, x + 1);
+                    forget_index();
+                    break;
+                case OP_ADD_I_VX: case OP_LD_F_VX: case OP_LD_HF_VX:
+                    forget_index();
+                    break;
+                default:
+                    break;
+            }
+        }
+        forget_index();
+    }
+
+    // Merge overlapping references into regions
+    std::sort(found.begin(), found.end(), [](const DataRegion& a, const DataRegion& b) { return a.start < b.start; });
+    for (const DataRegion& region : found) {
+        if (!analysis.data.empty()) {
+            DataRegion& last = analysis.data.back();
+            if (region.start < last.start + last.length) {
+                int end = region.start + region.length;
+                if (end > last.start + last.length) {
+                    last.length = end - last.start;
+                }
+                last.uses |= region.uses;
+                continue;
+            }
+        }
+        analysis.data.push_back(region);
+    }
+    for (const DataRegion& region : analysis.data) {
+        for (int i = 0; i < region.length; i++) {
+            if (analysis.byte_kinds[region.start + i] == BYTE_UNKNOWN) {
+                analysis.byte_kinds[region.start + i] = BYTE_DATA;
+            }
+        }
+    }
+}
+
+static RomAnalysis analyze_image(std::vector<uint8_t> memory, int program_size, Chip8Variant variant) {
+    RomAnalysis analysis;
+    analysis.variant = variant;
+    analysis.program_start = PROGRAM_BUFFER;
+    int program_end = PROGRAM_BUFFER + (program_size > 0 ? program_size : 0);
+    analysis.program_end = static_cast<uint16_t>(program_end < static_cast<int>(memory.size()) ? program_end : memory.size() - 1);
+    analysis.byte_kinds.assign(memory.size(), BYTE_UNKNOWN);
+    analysis.unresolved_writes = 0;
+    analysis.indirect_jumps = 0;
+    analysis.memory = std::move(memory);
+
+    std::vector<bool> is_instruction(analysis.memory.size(), false);
+    std::vector<bool> is_leader(analysis.memory.size(), false);
+    trace_reachable(analysis, is_instruction, is_leader);
+    build_blocks(analysis, is_instruction, is_leader);
+    build_edges(analysis, is_instruction);
+    for (const BasicBlock& block : analysis.blocks) {
+        analysis.indirect_jumps += block.exit == BlockExit::IndirectJump;
+    }
+    find_subroutines(analysis);
+    find_data(analysis);
+    return analysis;
+}
+
+RomAnalysis analyze_program(const uint8_t program[], int size, Chip8Variant variant) {
+    int memory_size = variant == Chip8Variant::XoChip ? MEMORY_COUNT : CHIP8_MEMORY_SIZE;
+    std::vector<uint8_t> memory(memory_size, 0);
+    for (int i = 0; i < FONT_COUNT; i++) {
+        memory[i] = CHIP8_FONT[i];
+    }
+    if (variant != Chip8Variant::Chip8) {
+        for (int i = 0; i < BIG_FONT_COUNT; i++) {
+            memory[FONT_COUNT + i] = CHIP8_BIG_FONT[i];
+        }
+    }
+    int copied = size < memory_size - PROGRAM_BUFFER ? size : memory_size - PROGRAM_BUFFER;
+    for (int i = 0; i < copied; i++) {
+        memory[PROGRAM_BUFFER + i] = program[i];
+    }
+    return analyze_image(std::move(memory), copied, variant);
+}
+
+RomAnalysis analyze_memory(const CPU& cpu, int program_size) {
+    int memory_size = cpu.get_variant() == Chip8Variant::XoChip ? MEMORY_COUNT : CHIP8_MEMORY_SIZE;
+    std::vector<uint8_t> memory(memory_size);
+    for (int i = 0; i < memory_size; i++) {
+        memory[i] = cpu.read_memory(static_cast<uint16_t>(i));
+    }
+    return analyze_image(std::move(memory), program_size, cpu.get_variant());
+}
+
+bool is_self_modifying(const RomAnalysis& analysis) { return !analysis.code_writes.empty(); }
+
+int find_block(const RomAnalysis& analysis, uint16_t address) {
+    auto after = std::upper_bound(analysis.blocks.begin(), analysis.blocks.end(), address,
+                                  [](uint16_t value, const BasicBlock& block) { return value < block.start; });
+    if (after == analysis.blocks.begin()) {
+        return -1;
+    }
+    int index = static_cast<int>(after - analysis.blocks.begin()) - 1;
+    return address < analysis.blocks[index].end ? index : -1;
+}
+
+// Instruction text at address, reading the long address of F000 NNNN when present
+static std::string disassemble_at(const RomAnalysis& analysis, int address) {
+    uint16_t instruction = word_at(analysis.memory, address);
+    bool long_form = instruction_size(analysis.memory, address, analysis.variant) == 4 &&
+                     address + 3 < static_cast<int>(analysis.memory.size());
+    return disassemble(instruction, analysis.variant, long_form ? word_at(analysis.memory, address + 2) : 0);
+}
+
+void write_analysis_json(const RomAnalysis& analysis, std::ostream& out) {
+    const std::vector<uint8_t>& memory = analysis.memory;
+    out << "{\n  \"variant\": \"" << variant_name(analysis.variant) << "\",\n"
+        << "  \"program_start\": " << analysis.program_start << ",\n"
+        << "  \"program_end\": " << analysis.program_end << ",\n"
+        << "  \"self_modifying\": " << (is_self_modifying(analysis) ? "true" : "false") << ",\n"
+        << "  \"unresolved_writes\": " << analysis.unresolved_writes << ",\n"
+        << "  \"indirect_jumps\": " << analysis.indirect_jumps << ",\n";
+
+    out << "  \"blocks\": [";
+    for (size_t b = 0; b < analysis.blocks.size(); b++) {
+        const BasicBlock& block = analysis.blocks[b];
+        out << (b > 0 ? "," : "") << "\n    {\"start\": " << block.start << ", \"end\": " << block.end
+            << ", \"exit\": \"" << block_exit_name(block.exit) << "\", \"instructions\": [";
+        int address = block.start;
+        for (int i = 0; i < block.instruction_count; i++) {
+            out << (i > 0 ? ", " : "") << "{\"address\": " << address << ", \"opcode\": " << word_at(memory, address)
+                << ", \"text\": \"" << disassemble_at(analysis, address) << "\"}";
+            address += instruction_size(memory, address, analysis.variant);
+        }
+        out << "]}";
+    }
+    out << "\n  ],\n  \"edges\": [";
+    for (size_t e = 0; e < analysis.edges.size(); e++) {
+        const CfgEdge& edge = analysis.edges[e];
+        out << (e > 0 ? "," : "") << "\n    {\"from\": " << edge.from << ", \"to\": " << edge.to
+            << ", \"kind\": \"" << edge_kind_name(edge.kind) << "\"}";
+    }
+    out << "\n  ],\n  \"subroutines\": [";
+    for (size_t s = 0; s < analysis.subroutines.size(); s++) {
+        const Subroutine& subroutine = analysis.subroutines[s];
+        out << (s > 0 ? "," : "") << "\n    {\"entry\": " << subroutine.entry << ", \"blocks\": " << subroutine.block_count
+            << ", \"call_sites\": [";
+        for (size_t c = 0; c < subroutine.call_sites.size(); c++) {
+            out << (c > 0 ? ", " : "") << subroutine.call_sites[c];
+        }
+        out << "]}";
+    }
+    out << "\n  ],\n  \"data\": [";
+    for (size_t d = 0; d < analysis.data.size(); d++) {
+        const DataRegion& region = analysis.data[d];
+        out << (d > 0 ? "," : "") << "\n    {\"start\": " << region.start << ", \"length\": " << region.length << ", \"uses\": [";
+        const char* separator = "";
+        const char* NAMES[] = {"sprite", "load", "store", "pointer"};
+        for (int bit = 0; bit < 4; bit++) {
+            if (region.uses & (1 << bit)) {
+                out << separator << "\"" << NAMES[bit] << "\"";
+                separator = ", ";
+            }
+        }
+        out << "]}";
+    }
+    out << "\n  ],\n  \"code_writes\": [";
+    for (size_t w = 0; w < analysis.code_writes.size(); w++) {
+        const CodeWrite& write = analysis.code_writes[w];
+        out << (w > 0 ? "," : "") << "\n    {\"pc\": " << write.pc << ", \"address\": " << write.address
+            << ", \"length\": " << write.length << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void write_analysis_dot(const RomAnalysis& analysis, std::ostream& out) {
+    char name[16];
+    out << "digraph rom {\n  node [shape=box, fontname=\"monospace\"];\n";
+    for (const BasicBlock& block : analysis.blocks) {
+        bool entry = std::any_of(analysis.subroutines.begin(), analysis.subroutines.end(),
+                                 [&block](const Subroutine& s) { return s.entry == block.start; });
+        snprintf(name, sizeof(name), "b%04X", block.start);
+        out << "  " << name << " [label=\"";
+        int address = block.start;
+        for (int i = 0; i < block.instruction_count; i++) {
+            snprintf(name, sizeof(name), "%03X  ", address);
+            out << name << disassemble_at(analysis, address) << "\\l";
+            address += instruction_size(analysis.memory, address, analysis.variant);
+        }
+        out << "\"" << (entry ? ", peripheries=2" : "") << "];\n";
+    }
+    for (const CfgEdge& edge : analysis.edges) {
+        snprintf(name, sizeof(name), "b%04X", edge.from);
+        out << "  " << name << " -> ";
+        snprintf(name, sizeof(name), "b%04X", edge.to);
+        out << name;
+        if (edge.kind == EdgeKind::Call) {
+            out << " [style=dashed]";
+        } else if (edge.kind == EdgeKind::Skip) {
+            out << " [label=\"skip\"]";
+        }
+        out << ";\n";
+    }
+    out << "}\n";
+}
@@ -0,0 +1,120 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <cstdint> // For uint8_t and uint16_t
+#include <ostream> // For the JSON and DOT writers
+#include <string>  // For disassembly
+#include <vector>  // For blocks, edges and regions
+#include "cpu.h"
+
+// Mnemonic for one instruction as this emulator runs it, e.g. "LD V1, 0x20". long_address is
+// the second word of XO-CHIP's F000 NNNN. Opcodes the variant does not run are shown as
+// "DW 0xXXXX" (0NNN machine routines as "SYS 0xNNN").
+std::string disassemble(uint16_t instruction, Chip8Variant variant, uint16_t long_address = 0);
+
+// How control leaves a basic block
+enum class BlockExit {
+    Fallthrough,  // Runs into the next block (its first instruction is a jump or call target)
+    Jump,         // 1NNN
+    IndirectJump, // BNNN; the targets are not known statically
+    Call,         // 2NNN, continuing after it when the subroutine returns
+    Skip,         // A conditional skip: the next instruction or the one after
+    Return,       // 00EE
+    Exit,         // 00FD
+    End           // The next instruction would be fetched past the end of memory
+};
+
+enum class EdgeKind {
+    Next, // Falls through, including after a call or a skip that is not taken
+    Jump,
+    Call,
+    Skip  // A taken skip
+};
+
+// Instructions from start up to (not including) end; only control flow leaves at the last one
+struct BasicBlock {
+    uint16_t start;
+    int end;
+    uint16_t last; // Address of the last instruction
+    int instruction_count;
+    BlockExit exit;
+};
+
+struct CfgEdge {
+    uint16_t from; // Start of the source block
+    uint16_t to;   // Start of the target block
+    EdgeKind kind;
+};
+
+// A 2NNN target: its call sites and the blocks reachable from it without following calls
+struct Subroutine {
+    uint16_t entry;
+    std::vector<uint16_t> call_sites;
+    int block_count;
+};
+
+// Ways code refers to a data region, as DATA_* bits
+const uint8_t DATA_SPRITE = 0x01;  // Drawn by DXYN / DXY0 with I set by ANNN
+const uint8_t DATA_LOAD = 0x02;    // Read by FX65, 5XY3 or F002
+const uint8_t DATA_STORE = 0x04;   // Written by FX33, FX55 or 5XY2
+const uint8_t DATA_POINTER = 0x08; // Loaded into I by ANNN, use not known
+
+struct DataRegion {
+    uint16_t start;
+    int length;
+    uint8_t uses;
+};
+
+// A store whose address is known and lands on reachable code
+struct CodeWrite {
+    uint16_t pc;      // The storing instruction
+    uint16_t address; // First byte written
+    int length;
+};
+
+// Per-address classification in RomAnalysis::byte_kinds
+const uint8_t BYTE_UNKNOWN = 0;
+const uint8_t BYTE_CODE = 1;
+const uint8_t BYTE_DATA = 2;
+
+// Static structure of a program: every instruction reachable from 0x200 along 1NNN, 2NNN,
+// 00EE and skip edges, grouped into basic blocks, plus the data the code points I at. I is
+// tracked only within a block (ANNN before its use), so tables walked with FX1E and other
+// computed addresses show up as unresolved instead of as data.
+struct RomAnalysis {
+    Chip8Variant variant;
+    uint16_t program_start;
+    uint16_t program_end;             // One past the last program byte
+    std::vector<uint8_t> byte_kinds;  // BYTE_* for every addressable byte
+    std::vector<uint16_t> instructions; // Reachable instruction addresses, ascending
+    std::vector<BasicBlock> blocks;   // Ascending by start
+    std::vector<CfgEdge> edges;
+    std::vector<Subroutine> subroutines; // Ascending by entry
+    std::vector<DataRegion> data;     // Ascending, non-overlapping
+    std::vector<CodeWrite> code_writes;
+    int unresolved_writes;            // Stores through an I not known statically
+    int indirect_jumps;
+    std::vector<uint8_t> memory;      // The image that was analysed
+};
+
+// Analyse a program as load_program() would place it, or whatever a CPU holds right now
+// (program_size bytes from 0x200 count as the program)
+RomAnalysis analyze_program(const uint8_t program[], int size, Chip8Variant variant = Chip8Variant::Chip8);
+RomAnalysis analyze_memory(const CPU& cpu, int program_size);
+
+// The analysis may write to code it also runs: true when a store with a known address hits
+// reachable code
+bool is_self_modifying(const RomAnalysis& analysis);
+
+// Index into analysis.blocks of the block containing address, or -1
+int find_block(const RomAnalysis& analysis, uint16_t address);
+
+const char* block_exit_name(BlockExit exit);
+const char* edge_kind_name(EdgeKind kind);
+
+// Machine-readable dumps: one JSON object, or a Graphviz digraph of the blocks with their
+// disassembly (calls dashed, taken skips labelled)
+void write_analysis_json(const RomAnalysis& analysis, std::ostream& out);
+void write_analysis_dot(const RomAnalysis& analysis, std::ostream& out);
+
+#endif // ANALYSIS_H
@@ -0,0 +1,102 @@
+// analyze.cpp
+//
+// Static analysis of a ROM without running it: basic blocks, the control-flow graph,
+// subroutines, the data the code points I at, and stores that land on code.
+// Usage: chip8-analyze [--variant=chip8|schip|xochip] [--format=text|json|dot] <rom>
+//   --format=text   Summary and a disassembly of every block (default)
+//   --format=json   The whole analysis as one JSON object
+//   --format=dot    Graphviz digraph of the blocks (render with: dot -Tsvg)
+// Exit status: 0 on success, 1 for bad arguments or an unreadable ROM.
+
+#include "analysis.h"
+#include "rom.h"
+
+#include <cstdio>   // For printf
+#include <cstring>  // For strncmp and strcmp
+#include <iostream> // For errors and the JSON / DOT output
+
+static void print_text(const RomAnalysis& analysis) {
+    printf("Variant:           %s\n", variant_name(analysis.variant));
+    printf("Program:           0x%03X-0x%03X\n", analysis.program_start, analysis.program_end);
+    printf("Instructions:      %zu\n", analysis.instructions.size());
+    printf("Basic blocks:      %zu\n", analysis.blocks.size());
+    printf("Subroutines:       %zu\n", analysis.subroutines.size());
+    printf("Data regions:      %zu\n", analysis.data.size());
+    printf("Indirect jumps:    %d\n", analysis.indirect_jumps);
+    printf("Unresolved writes: %d\n", analysis.unresolved_writes);
+    printf("Self-modifying:    %s\n", is_self_modifying(analysis) ? "yes" : "no");
+    for (const CodeWrite& write : analysis.code_writes) {
+        printf("  %03X writes %d byte(s) of code at %03X\n", write.pc, write.length, write.address);
+    }
+
+    for (const Subroutine& subroutine : analysis.subroutines) {
+        printf("\nsub_%03X: %d block(s), called from", subroutine.entry, subroutine.block_count);
+        for (uint16_t site : subroutine.call_sites) {
+            printf(" %03X", site);
+        }
+        printf("\n");
+    }
+
+    for (const BasicBlock& block : analysis.blocks) {
+        printf("\nblock %03X (%d instruction(s), exits by %s)\n", block.start, block.instruction_count,
+               block_exit_name(block.exit));
+        int address = block.start;
+        for (int i = 0; i < block.instruction_count; i++) {
+            uint16_t instruction = (analysis.memory[address] << 8) | analysis.memory[address + 1];
+            bool long_form = analysis.variant == Chip8Variant::XoChip && instruction == 0xF000 &&
+                             address + 3 < static_cast<int>(analysis.memory.size());
+            uint16_t long_address = long_form ? (analysis.memory[address + 2] << 8) | analysis.memory[address + 3] : 0;
+            printf("  %03X  %04X  %s\n", address, instruction,
+                   disassemble(instruction, analysis.variant, long_address).c_str());
+            address += long_form ? 4 : 2;
+        }
+    }
+
+    if (!analysis.data.empty()) {
+        printf("\n");
+    }
+    for (const DataRegion& region : analysis.data) {
+        printf("data %03X-%03X (%d byte(s))%s%s%s%s\n", region.start, region.start + region.length - 1, region.length,
+               region.uses & DATA_SPRITE ? " sprite" : "", region.uses & DATA_LOAD ? " load" : "",
+               region.uses & DATA_STORE ? " store" : "", region.uses & DATA_POINTER ? " pointer" : "");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Chip8Variant variant = Chip8Variant::Chip8;
+    const char* format = "text";
+    const char* rom_path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--variant=", 10) == 0) {
+            if (!parse_variant(argv[i] + 10, variant)) {
+                std::cerr << "Unknown variant: " << argv[i] + 10 << std::endl;
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--format=", 9) == 0) {
+            format = argv[i] + 9;
+        } else if (rom_path == nullptr) {
+            rom_path = argv[i];
+        }
+    }
+    bool known_format = strcmp(format, "text") == 0 || strcmp(format, "json") == 0 || strcmp(format, "dot") == 0;
+    if (rom_path == nullptr || !known_format) {
+        std::cerr << "Usage: " << argv[0] << " [--variant=chip8|schip|xochip] [--format=text|json|dot] <rom>" << std::endl;
+        return 1;
+    }
+
+    std::vector<uint8_t> rom;
+    if (!load_rom_file(rom_path, rom) || rom.empty()) {
+        std::cerr << "Error: Could not read ROM file: " << rom_path << std::endl;
+        return 1;
+    }
+
+    RomAnalysis analysis = analyze_program(rom.data(), static_cast<int>(rom.size()), variant);
+    if (strcmp(format, "json") == 0) {
+        write_analysis_json(analysis, std::cout);
+    } else if (strcmp(format, "dot") == 0) {
+        write_analysis_dot(analysis, std::cout);
+    } else {
+        print_text(analysis);
+    }
+    return 0;
+}
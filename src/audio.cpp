@@ -0,0 +1,172 @@
+#include "audio.h"
+#include "machine.h"
+
+#include <chrono>  // For latency timestamps
+#include <cmath>   // For pow
+#include <cstring> // For memcpy and memset
+
+static uint64_t now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+AudioRing::AudioRing(int capacity_frames) {
+    size_t capacity = 1;
+    while (capacity < static_cast<size_t>(capacity_frames > 0 ? capacity_frames : 1)) {
+        capacity <<= 1;
+    }
+    frames.resize(capacity);
+    mask = capacity - 1;
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+}
+
+bool AudioRing::push(const AudioFrame& frame) {
+    size_t write = head.load(std::memory_order_relaxed);
+    if (write - tail.load(std::memory_order_acquire) > mask) {
+        return false;
+    }
+    frames[write & mask] = frame;
+    head.store(write + 1, std::memory_order_release); // Publishes the slot to the consumer
+    return true;
+}
+
+bool AudioRing::pop(AudioFrame& frame) {
+    size_t read = tail.load(std::memory_order_relaxed);
+    if (read == head.load(std::memory_order_acquire)) {
+        return false;
+    }
+    frame = frames[read & mask];
+    tail.store(read + 1, std::memory_order_release); // Hands the slot back to the producer
+    return true;
+}
+
+size_t AudioRing::size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+}
+
+size_t AudioRing::capacity() const { return frames.size(); }
+
+AudioEngine::AudioEngine(const AudioConfig& config)
+    : config(config), ring(config.ring_frames) {
+    samples_per_frame = config.sample_rate / TIMER_HZ;
+    memset(&current, 0, sizeof(current));
+    current_samples_left = 0;
+    phase = 0;
+    frames_published = 0;
+    frames_dropped = 0;
+    frames_skipped = 0;
+    underruns = 0;
+    underrun_samples = 0;
+    latency_total_ns = 0;
+    latency_count = 0;
+    latency_max_ns = 0;
+}
+
+void AudioEngine::publish(const CPU& cpu) {
+    AudioFrame frame;
+    frame.tone = cpu.get_sound_timer() > 0;
+    frame.pattern = cpu.get_variant() == Chip8Variant::XoChip;
+    if (frame.pattern) {
+        // Phase counts pattern bits in its top 7 bits
+        double rate = AUDIO_PATTERN_BASE_HZ * pow(2.0, (cpu.get_audio_pitch() - 64) / 48.0);
+        frame.phase_step = static_cast<uint32_t>(rate * (1u << 25) / config.sample_rate);
+        memcpy(frame.pattern_bits, cpu.get_audio_pattern(), AUDIO_PATTERN_SIZE);
+    } else {
+        frame.phase_step = static_cast<uint32_t>(static_cast<double>(config.beeper_hz) * 4294967296.0 / config.sample_rate);
+    }
+    push_frame(frame);
+}
+
+void AudioEngine::publish_silence() {
+    AudioFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    push_frame(frame);
+}
+
+void AudioEngine::push_frame(AudioFrame& frame) {
+    frame.publish_ns = now_ns();
+    if (ring.push(frame)) {
+        frames_published.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        frames_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool AudioEngine::next_frame() {
+    if (!ring.pop(current)) {
+        return false;
+    }
+    // Anything queued beyond the target only adds latency
+    uint64_t skipped = 0;
+    while (ring.size() > static_cast<size_t>(config.target_frames) && ring.pop(current)) {
+        skipped += 1;
+    }
+    if (skipped > 0) {
+        frames_skipped.fetch_add(skipped, std::memory_order_relaxed);
+    }
+
+    uint64_t now = now_ns();
+    uint64_t latency = now > current.publish_ns ? now - current.publish_ns : 0;
+    latency_total_ns.fetch_add(latency, std::memory_order_relaxed);
+    latency_count.fetch_add(1, std::memory_order_relaxed);
+    if (latency > latency_max_ns.load(std::memory_order_relaxed)) {
+        latency_max_ns.store(latency, std::memory_order_relaxed);
+    }
+
+    current_samples_left = samples_per_frame;
+    return true;
+}
+
+void AudioEngine::mix(int16_t* samples, int count) {
+    int written = 0;
+    while (written < count) {
+        if (current_samples_left == 0 && !next_frame()) {
+            // Nothing to play: stay silent until the emulator catches up
+            underruns.fetch_add(1, std::memory_order_relaxed);
+            underrun_samples.fetch_add(count - written, std::memory_order_relaxed);
+            memset(samples + written, 0, (count - written) * sizeof(int16_t));
+            return;
+        }
+
+        int run = count - written < current_samples_left ? count - written : current_samples_left;
+        int16_t* out = samples + written;
+        if (!current.tone) {
+            memset(out, 0, run * sizeof(int16_t));
+        } else if (current.pattern) {
+            for (int i = 0; i < run; i++) {
+                uint32_t bit = phase >> 25;
+                bool high = (current.pattern_bits[bit >> 3] >> (7 - (bit & 7))) & 1;
+                out[i] = high ? AUDIO_AMPLITUDE : -AUDIO_AMPLITUDE;
+                phase += current.phase_step;
+            }
+        } else {
+            for (int i = 0; i < run; i++) {
+                out[i] = (phase & 0x80000000u) ? AUDIO_AMPLITUDE : -AUDIO_AMPLITUDE;
+                phase += current.phase_step;
+            }
+        }
+        written += run;
+        current_samples_left -= run;
+    }
+}
+
+const AudioConfig& AudioEngine::get_config() const { return config; }
+
+uint64_t AudioEngine::get_frames_published() const { return frames_published.load(std::memory_order_relaxed); }
+uint64_t AudioEngine::get_frames_dropped() const { return frames_dropped.load(std::memory_order_relaxed); }
+uint64_t AudioEngine::get_frames_skipped() const { return frames_skipped.load(std::memory_order_relaxed); }
+uint64_t AudioEngine::get_underruns() const { return underruns.load(std::memory_order_relaxed); }
+uint64_t AudioEngine::get_underrun_samples() const { return underrun_samples.load(std::memory_order_relaxed); }
+size_t AudioEngine::get_queued_frames() const { return ring.size(); }
+
+double AudioEngine::get_average_latency_us() const {
+    uint64_t count = latency_count.load(std::memory_order_relaxed);
+    return count > 0 ? latency_total_ns.load(std::memory_order_relaxed) / 1000.0 / count : 0.0;
+}
+
+double AudioEngine::get_max_latency_us() const { return latency_max_ns.load(std::memory_order_relaxed) / 1000.0; }
+
+double AudioEngine::get_device_latency_us() const {
+    return 1000000.0 * config.device_samples / config.sample_rate;
+}
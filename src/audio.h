@@ -0,0 +1,121 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <atomic>  // For the ring indices and the statistics
+#include <cstddef> // For size_t
+#include <cstdint> // For uint8_t, int16_t and uint64_t
+#include <vector>  // For the ring storage
+#include "cpu.h"
+
+// Output format and sizes, all overridable from the command line
+const int DEFAULT_AUDIO_SAMPLE_RATE = 48000;
+const int DEFAULT_AUDIO_DEVICE_SAMPLES = 512; // Samples per device callback (~11 ms at 48kHz)
+const int DEFAULT_AUDIO_RING_FRAMES = 8;      // Emulated frames the ring can hold
+const int DEFAULT_AUDIO_TARGET_FRAMES = 2;    // Queued frames kept; older ones are skipped
+const int DEFAULT_BEEPER_HZ = 440;            // CHIP-8 / SUPER-CHIP square wave tone
+const int16_t AUDIO_AMPLITUDE = 3000;
+
+// XO-CHIP plays its 128-sample pattern at 4000 * 2^((pitch - 64) / 48) samples per second
+const int AUDIO_PATTERN_BITS = AUDIO_PATTERN_SIZE * 8;
+const double AUDIO_PATTERN_BASE_HZ = 4000.0;
+
+struct AudioConfig {
+    int sample_rate = DEFAULT_AUDIO_SAMPLE_RATE;
+    int device_samples = DEFAULT_AUDIO_DEVICE_SAMPLES;
+    int ring_frames = DEFAULT_AUDIO_RING_FRAMES;     // Rounded up to a power of two
+    int target_frames = DEFAULT_AUDIO_TARGET_FRAMES;
+    int beeper_hz = DEFAULT_BEEPER_HZ;
+};
+
+// What one emulated frame sounds like, as published by the emulation thread
+struct AudioFrame {
+    bool tone;                 // sound_timer was non-zero
+    bool pattern;              // Play pattern_bits instead of the square wave
+    uint32_t phase_step;       // Phase advance per output sample (32-bit fixed point)
+    uint64_t publish_ns;       // steady_clock time of publishing, for latency measurement
+    uint8_t pattern_bits[AUDIO_PATTERN_SIZE];
+};
+
+// Single-producer single-consumer ring of frames with a power-of-two capacity. Storage is
+// allocated once up front; push and pop never block, lock or allocate, so the consumer can
+// run inside an audio callback.
+class AudioRing {
+public:
+    explicit AudioRing(int capacity_frames);
+
+    // Producer side. Returns false (and drops the frame) when the ring is full.
+    bool push(const AudioFrame& frame);
+
+    // Consumer side. Returns false when the ring is empty.
+    bool pop(AudioFrame& frame);
+
+    // Frames currently queued; exact on either side, approximate elsewhere
+    size_t size() const;
+    size_t capacity() const;
+
+private:
+    std::vector<AudioFrame> frames;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head; // Next slot to write, owned by the producer
+    alignas(64) std::atomic<size_t> tail; // Next slot to read, owned by the consumer
+};
+
+// Turns published frames into samples. publish() is called by the emulation thread once per
+// emulated frame; mix() is called by the audio device and consumes one frame per
+// sample_rate / TIMER_HZ samples. When the ring runs dry the output goes silent and the
+// underrun is counted; when it backs up past target_frames the oldest frames are skipped so
+// latency stays bounded.
+class AudioEngine {
+public:
+    explicit AudioEngine(const AudioConfig& config);
+
+    // Producer: queue the sound state at the end of a frame
+    void publish(const CPU& cpu);
+    void publish_silence();
+
+    // Consumer: write count mono samples
+    void mix(int16_t* samples, int count);
+
+    const AudioConfig& get_config() const;
+
+    // Statistics, safe to read from any thread
+    uint64_t get_frames_published() const;
+    uint64_t get_frames_dropped() const;   // Ring full when publishing
+    uint64_t get_frames_skipped() const;   // Discarded to get back to target_frames
+    uint64_t get_underruns() const;        // Frame slots that found the ring empty
+    uint64_t get_underrun_samples() const;
+    size_t get_queued_frames() const;
+
+    // Time from publish() until the frame's first sample was mixed, in microseconds. The
+    // device buffer adds get_device_latency_us() on top.
+    double get_average_latency_us() const;
+    double get_max_latency_us() const;
+    double get_device_latency_us() const;
+
+private:
+    AudioConfig config;
+    AudioRing ring;
+    int samples_per_frame;
+
+    // Consumer state, only touched inside mix()
+    AudioFrame current;
+    int current_samples_left;
+    uint32_t phase;
+
+    // Producer-side counters
+    std::atomic<uint64_t> frames_published;
+    std::atomic<uint64_t> frames_dropped;
+
+    // Consumer-side counters
+    std::atomic<uint64_t> frames_skipped;
+    std::atomic<uint64_t> underruns;
+    std::atomic<uint64_t> underrun_samples;
+    std::atomic<uint64_t> latency_total_ns;
+    std::atomic<uint64_t> latency_count;
+    std::atomic<uint64_t> latency_max_ns;
+
+    void push_frame(AudioFrame& frame);
+    bool next_frame();
+};
+
+#endif // AUDIO_H
@@ -0,0 +1,133 @@
+// batch.cpp
+//
+// Runs many ROMs / settings combinations in parallel and prints one CSV line per run.
+// Usage: chip8-batch [options] <rom>...
+//   --threads=N              Worker threads (default: all hardware threads)
+//   --frames=N               Frames to run each machine for (default 3600)
+//   --cycles-per-frame=A,B   Cycles-per-frame values to sweep (default 10)
+//   --quirks=old|new|both    CHIP-8 or CHIP-48 shift/jump/load behaviour (default old)
+//   --seeds=A,B              CXNN random seeds to sweep (default: one fixed seed)
+//   --variant=chip8|schip|xochip  Instruction set for every run (default chip8)
+//   --repeat=N               Run every combination N times (for scaling measurements)
+//   --library=DIR            Add every ROM found below DIR (duplicates by content are run once)
+
+#include "batch_runner.h"
+#include "rom_library.h"
+
+#include <chrono>   // For total wall time
+#include <cstdlib>  // For strtoull
+#include <cstring>  // For strncmp
+#include <iostream> // For CSV output
+#include <sstream>  // For parsing lists
+
+int main(int argc, char* argv[]) {
+    int thread_count = 0;
+    uint64_t frames = 60 * 60;
+    std::vector<int> cycle_settings;
+    std::vector<bool> quirk_settings = {false};
+    std::vector<uint64_t> seeds;
+    int repeat = 1;
+    std::vector<std::string> rom_paths;
+    RomLibrary library;
+    Chip8Variant variant = Chip8Variant::Chip8;
+    bool bad_option = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--threads=", 10) == 0) {
+            thread_count = atoi(argv[i] + 10);
+        } else if (strncmp(argv[i], "--frames=", 9) == 0) {
+            frames = strtoull(argv[i] + 9, nullptr, 10);
+        } else if (strncmp(argv[i], "--cycles-per-frame=", 19) == 0) {
+            std::istringstream list(argv[i] + 19);
+            std::string value;
+            while (std::getline(list, value, ',')) {
+                cycle_settings.push_back(atoi(value.c_str()));
+            }
+        } else if (strcmp(argv[i], "--quirks=old") == 0) {
+            quirk_settings = {false};
+        } else if (strcmp(argv[i], "--quirks=new") == 0) {
+            quirk_settings = {true};
+        } else if (strcmp(argv[i], "--quirks=both") == 0) {
+            quirk_settings = {false, true};
+        } else if (strncmp(argv[i], "--seeds=", 8) == 0) {
+            std::istringstream list(argv[i] + 8);
+            std::string value;
+            while (std::getline(list, value, ',')) {
+                seeds.push_back(strtoull(value.c_str(), nullptr, 10));
+            }
+        } else if (strncmp(argv[i], "--variant=", 10) == 0) {
+            if (!parse_variant(argv[i] + 10, variant)) {
+                std::cerr << "Unknown variant: " << argv[i] + 10 << std::endl;
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--repeat=", 9) == 0) {
+            repeat = atoi(argv[i] + 9);
+        } else if (strncmp(argv[i], "--library=", 10) == 0) {
+            library.index_directory(argv[i] + 10);
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            // A mistyped option must not be taken for a ROM path
+            std::cerr << "Unknown option: " << argv[i] << std::endl;
+            bad_option = true;
+        } else {
+            rom_paths.push_back(argv[i]);
+        }
+    }
+    if (cycle_settings.empty()) {
+        cycle_settings.push_back(10);
+    }
+    if (seeds.empty()) {
+        seeds.push_back(DEFAULT_RNG_SEED);
+    }
+    for (const RomEntry& entry : library.get_entries()) {
+        if (library.find(entry.hash) == &entry) {
+            rom_paths.push_back(entry.path);
+        }
+    }
+
+    if (bad_option || rom_paths.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--threads=N] [--frames=N] [--cycles-per-frame=A,B] "
+                  << "[--quirks=old|new|both] [--seeds=A,B] [--variant=chip8|schip|xochip] [--repeat=N] "
+                  << "[--library=DIR] <rom>..." << std::endl;
+        return 1;
+    }
+
+    // Build the job list: every ROM x cycles setting x quirk setting x seed
+    std::vector<BatchJob> jobs;
+    for (const std::string& path : rom_paths) {
+        MappedRom file;
+        if (!file.open(path)) {
+            std::cerr << "Skipping unreadable ROM: " << path << std::endl;
+            continue;
+        }
+        auto rom = std::make_shared<const std::vector<uint8_t>>(file.data(), file.data() + file.size());
+        for (int r = 0; r < repeat; r++) {
+            for (int cycles : cycle_settings) {
+                for (bool quirks : quirk_settings) {
+                    for (uint64_t seed : seeds) {
+                        jobs.push_back({path, rom, frames, cycles, quirks, DispatchMode::Threaded, seed, variant});
+                    }
+                }
+            }
+        }
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    std::vector<BatchResult> results = run_batch(jobs, thread_count);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+
+    uint64_t total_instructions = 0;
+    std::cout << "rom,cycles_per_frame,quirks,seed,framebuffer_hash,instructions,frames,fault,seconds\n";
+    for (const BatchResult& result : results) {
+        std::cout << result.name << "," << result.cycles_per_frame << ","
+                  << (result.new_functionality ? "new" : "old") << ","
+                  << result.seed << ","
+                  << std::hex << result.framebuffer_hash << std::dec << ","
+                  << result.instructions << "," << result.frames << ","
+                  << fault_name(result.fault) << "," << result.seconds << "\n";
+        total_instructions += result.instructions;
+    }
+
+    std::cerr << jobs.size() << " runs in " << elapsed.count() << "s, "
+              << static_cast<uint64_t>(total_instructions / elapsed.count()) << " instructions/sec" << std::endl;
+    return 0;
+}
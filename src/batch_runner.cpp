@@ -0,0 +1,80 @@
+#include "batch_runner.h"
+#include "input_source.h"
+#include "machine.h"
+#include "thread_pool.h"
+
+#include <chrono> // For timing jobs
+
+uint64_t hash_framebuffer(const Display& display) {
+    const uint64_t FNV_OFFSET = 0xCBF29CE484222325ULL;
+    const uint64_t FNV_PRIME = 0x100000001B3ULL;
+
+    // Rows of the visible area only. Plane 1 counts once anything is drawn into it, so
+    // CHIP-8 and SUPER-CHIP hashes do not depend on it.
+    int words = display.is_hires() ? DISPLAY_ROW_WORDS : 1;
+    uint64_t plane_1_bits = 0;
+    for (int y = 0; y < display.get_height(); y++) {
+        for (int w = 0; w < words; w++) {
+            plane_1_bits |= display.get_row(1, y)[w];
+        }
+    }
+    int plane_count = plane_1_bits != 0 ? 2 : 1;
+
+    uint64_t hash = FNV_OFFSET;
+    for (int plane = 0; plane < plane_count; plane++) {
+        for (int y = 0; y < display.get_height(); y++) {
+            for (int w = 0; w < words; w++) {
+                uint64_t row = display.get_row(plane, y)[w];
+                for (int i = 0; i < 8; i++) {
+                    hash ^= (row >> (i * 8)) & 0xFF;
+                    hash *= FNV_PRIME;
+                }
+            }
+        }
+    }
+    return hash;
+}
+
+BatchResult run_job(const BatchJob& job) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    // Machines are large (memory plus decode cache), so keep them off the worker stacks
+    ScriptedInput input;
+    std::unique_ptr<Machine> machine(new Machine(input));
+    machine->set_cycles_per_frame(job.cycles_per_frame);
+    machine->get_cpu().set_dispatch_mode(job.dispatch_mode);
+    machine->get_cpu().set_new_functionality(job.new_functionality);
+    machine->get_cpu().seed_random(job.seed);
+    machine->set_variant(job.variant);
+    if (job.rom) {
+        machine->load_program(job.rom->data(), job.rom->size());
+    }
+
+    machine->run_frames(job.frames);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    BatchResult result;
+    result.name = job.name;
+    result.cycles_per_frame = job.cycles_per_frame;
+    result.new_functionality = job.new_functionality;
+    result.seed = job.seed;
+    result.framebuffer_hash = hash_framebuffer(machine->get_display());
+    result.instructions = machine->get_total_instructions();
+    result.frames = machine->get_total_frames();
+    result.fault = machine->get_cpu().get_fault();
+    result.seconds = elapsed.count();
+    return result;
+}
+
+std::vector<BatchResult> run_batch(const std::vector<BatchJob>& jobs, int thread_count) {
+    std::vector<BatchResult> results(jobs.size());
+
+    WorkStealingPool pool(thread_count);
+    for (size_t i = 0; i < jobs.size(); i++) {
+        // Each task writes only its own result slot, so no locking is needed
+        pool.submit([&jobs, &results, i] { results[i] = run_job(jobs[i]); });
+    }
+    pool.wait_idle();
+
+    return results;
+}
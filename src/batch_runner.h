@@ -0,0 +1,46 @@
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <cstdint> // For uint64_t
+#include <memory>  // For std::shared_ptr
+#include <string>  // For job names
+#include <vector>  // For job and result lists
+#include "cpu.h"
+#include "display.h"
+
+// One independent machine run: a ROM plus the settings to run it with
+struct BatchJob {
+    std::string name;
+    std::shared_ptr<const std::vector<uint8_t>> rom; // Shared between jobs running the same ROM
+    uint64_t frames;
+    int cycles_per_frame;
+    bool new_functionality;
+    DispatchMode dispatch_mode;
+    uint64_t seed; // RNG seed for CXNN
+    Chip8Variant variant = Chip8Variant::Chip8;
+};
+
+// Summary of a finished job
+struct BatchResult {
+    std::string name;
+    int cycles_per_frame;
+    bool new_functionality;
+    uint64_t seed;
+    uint64_t framebuffer_hash; // FNV-1a of the final display rows
+    uint64_t instructions;
+    uint64_t frames;
+    CpuFault fault;
+    double seconds;
+};
+
+// 64-bit FNV-1a hash of the packed framebuffer
+uint64_t hash_framebuffer(const Display& display);
+
+// Run a single job on the calling thread
+BatchResult run_job(const BatchJob& job);
+
+// Run every job across a work-stealing pool (thread_count 0 = all hardware threads).
+// Results come back in the same order as the jobs.
+std::vector<BatchResult> run_batch(const std::vector<BatchJob>& jobs, int thread_count = 0);
+
+#endif // BATCH_RUNNER_H
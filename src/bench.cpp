@@ -0,0 +1,639 @@
+// bench.cpp
+//
+// Micro and end-to-end benchmarks for the emulator core. Prints one result per benchmark
+// (nanoseconds per operation, median of several samples) as CSV or JSON, optionally next to a
+// saved baseline so every performance change can be judged on numbers.
+// Usage: chip8-bench [options] [rom]...
+//   --format=csv|json      Output format (default csv)
+//   --filter=TEXT          Only run benchmarks whose name contains TEXT
+//   --min-time=MS          Minimum length of one sample in milliseconds (default 100)
+//   --samples=N            Samples per benchmark; the median is reported (default 5)
+//   --baseline=FILE        Earlier chip8-bench output (CSV or JSON) to compare against
+//   --max-regression=PCT   Exit with status 3 if any benchmark is PCT percent slower than the baseline
+// ROM files given on the command line are added to the built-in programs for the
+// full-ROM throughput benchmarks.
+
+#include "cpu.h"
+#include "debugger.h"
+#include "display.h"
+#include "input_source.h"
+#include "machine.h"
+#include "pixel_expand.h"
+#include "rom.h"
+
+#include <algorithm>  // For std::sort
+#include <chrono>     // For timing samples
+#include <cstdlib>    // For atoi and atof
+#include <cstring>    // For strcmp and strncmp
+#include <fstream>    // For reading the baseline
+#include <functional> // For benchmark bodies
+#include <iostream>   // For results
+#include <map>        // For baseline lookup
+#include <memory>     // For heap-allocated machines and states
+#include <sstream>    // For parsing the baseline
+#include <string>     // For benchmark names
+#include <vector>     // For results and ROM data
+
+// Small public-domain test programs, so the full-ROM benchmarks need no files
+struct BuiltinRom {
+    const char* name;
+    std::vector<uint8_t> program;
+    Chip8Variant variant = Chip8Variant::Chip8;
+};
+
+static const std::vector<BuiltinRom> BUILTIN_ROMS = {
+    // Register arithmetic in a tight loop
+    {"alu", {0x60, 0x01, 0x61, 0x03, 0x80, 0x14, 0x81, 0x13, 0x82, 0x06, 0x72, 0x0F,
+             0x42, 0x00, 0x62, 0x01, 0x12, 0x04}},
+    // Draws a 5-row sprite at a moving position every other instruction
+    {"draw", {0x60, 0x00, 0x61, 0x00, 0xA2, 0x0E, 0xD0, 0x15, 0x70, 0x03, 0x71, 0x02,
+              0x12, 0x06, 0xF0, 0x90, 0xF0, 0x90, 0xF0}},
+    // Position-and-draw and point-and-draw sequences inside a counting loop (the fused sequences)
+    {"sprites", {0x61, 0x00, 0x62, 0x02, 0xD1, 0x25, 0xA2, 0x16, 0xD3, 0x45, 0x70, 0x01,
+                 0x30, 0x00, 0x12, 0x00, 0x73, 0x01, 0x12, 0x00, 0x00, 0x00, 0xF0, 0x90,
+                 0xF0, 0x90, 0xF0}},
+    // Subroutine calls, font lookups, BCD, register stores/loads and timers
+    {"mixed", {0x60, 0x00, 0x22, 0x10, 0x70, 0x01, 0xF0, 0x29, 0xD1, 0x25, 0xF0, 0x15,
+               0x12, 0x02, 0x00, 0x00, 0xA3, 0x00, 0xF0, 0x33, 0xF3, 0x55, 0xF1, 0x65,
+               0x00, 0xEE}},
+    // SUPER-CHIP hi-res: a 16x16 sprite drawn, scrolled down a row and right 4 pixels every loop
+    {"hires", {0x00, 0xFF, 0xA2, 0x10, 0xD0, 0x10, 0x00, 0xC1, 0x00, 0xFB, 0x70, 0x05,
+               0x12, 0x04, 0x00, 0x00,
+               0xFF, 0xFF, 0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0x8F, 0xF1, 0x88, 0x11,
+               0x88, 0x11, 0x88, 0x11, 0x88, 0x11, 0x88, 0x11, 0x88, 0x11, 0x8F, 0xF1,
+               0x80, 0x01, 0x80, 0x01, 0x80, 0x01, 0xFF, 0xFF},
+     Chip8Variant::SuperChip},
+};
+
+struct BenchResult {
+    std::string name;
+    uint64_t operations;  // Operations timed in the reported sample
+    double ns_per_op;
+};
+
+// Keeps results the compiler could otherwise throw away
+static volatile uint64_t sink;
+
+class BenchSuite {
+public:
+    BenchSuite(const std::string& filter, double min_seconds, int samples)
+        : filter(filter), min_seconds(min_seconds), samples(samples) {}
+
+    // Time body, which performs the requested number of iterations and returns how many
+    // operations that was. The iteration count grows until a sample lasts min_seconds.
+    void run(const std::string& name, const std::function<uint64_t(uint64_t)>& body) {
+        if (!filter.empty() && name.find(filter) == std::string::npos) {
+            return;
+        }
+
+        uint64_t iterations = 1;
+        while (true) {
+            double seconds = 0;
+            if (time_body(body, iterations, seconds) == 0) {
+                return; // Not available on this host (e.g. the JIT)
+            }
+            if (seconds >= min_seconds) {
+                break;
+            }
+            // Aim a little past the target so the next sample is usually long enough
+            uint64_t scale = seconds > 0 ? (uint64_t) (min_seconds * 1.2 / seconds) : 100;
+            iterations *= scale < 2 ? 2 : (scale > 100 ? 100 : scale);
+        }
+
+        std::vector<BenchResult> taken;
+        for (int s = 0; s < samples; s++) {
+            double seconds = 0;
+            uint64_t operations = time_body(body, iterations, seconds);
+            taken.push_back({name, operations, operations > 0 ? seconds * 1e9 / operations : 0});
+        }
+        std::sort(taken.begin(), taken.end(),
+                  [](const BenchResult& a, const BenchResult& b) { return a.ns_per_op < b.ns_per_op; });
+        results.push_back(taken[taken.size() / 2]);
+    }
+
+    const std::vector<BenchResult>& get_results() const { return results; }
+
+private:
+    std::string filter;
+    double min_seconds;
+    int samples;
+    std::vector<BenchResult> results;
+
+    static uint64_t time_body(const std::function<uint64_t(uint64_t)>& body, uint64_t iterations, double& seconds) {
+        auto start_time = std::chrono::steady_clock::now();
+        uint64_t operations = body(iterations);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+        seconds = elapsed.count();
+        return operations;
+    }
+};
+
+// One CPU::execute_opcode family, run on a CPU prepared by the setup opcodes
+struct OpcodeBench {
+    const char* name;
+    std::vector<uint16_t> setup;
+    std::vector<uint16_t> loop; // Executed in order every iteration; must leave the CPU runnable
+};
+
+static const std::vector<OpcodeBench> OPCODE_BENCHES = {
+    {"00E0", {}, {0x00E0}},
+    {"1NNN", {}, {0x1200}},
+    {"2NNN+00EE", {}, {0x2300, 0x00EE}},
+    {"3XNN", {0x6012}, {0x3012, 0x3013}},
+    {"4XNN", {0x6012}, {0x4012, 0x4013}},
+    {"5XY0", {0x6012, 0x6112}, {0x5010}},
+    {"6XNN", {}, {0x6A5C}},
+    {"7XNN", {}, {0x7A01}},
+    {"8XY0", {0x6105}, {0x8010}},
+    {"8XY1", {0x6105}, {0x8011}},
+    {"8XY2", {0x6105}, {0x8012}},
+    {"8XY3", {0x6105}, {0x8013}},
+    {"8XY4", {0x6105}, {0x8014}},
+    {"8XY5", {0x6105}, {0x8015}},
+    {"8XY6", {0x6105}, {0x8016}},
+    {"8XY7", {0x6105}, {0x8017}},
+    {"8XYE", {0x6105}, {0x801E}},
+    {"9XY0", {0x6012, 0x6113}, {0x9010}},
+    {"ANNN", {}, {0xA300}},
+    {"BNNN", {}, {0xB300}},
+    {"CXNN", {}, {0xC0FF}},
+    {"DXYN", {0x6008, 0x6104, 0xA000}, {0xD015}},
+    {"EX9E", {}, {0xE09E}},
+    {"EXA1", {}, {0xE0A1}},
+    {"FX07", {}, {0xF007}},
+    {"FX15", {0x6020}, {0xF015}},
+    {"FX18", {0x6020}, {0xF018}},
+    {"FX1E", {0x6001, 0xA300}, {0xF01E, 0xA300}},
+    {"FX29", {0x6007}, {0xF029}},
+    {"FX33", {0x60FE, 0xA300}, {0xF033}},
+    {"FX55", {0xA300}, {0xFF55}},
+    {"FX65", {0xA300}, {0xFF65}},
+};
+
+static void bench_opcodes(BenchSuite& suite) {
+    for (const OpcodeBench& bench : OPCODE_BENCHES) {
+        suite.run(std::string("opcode/") + bench.name, [&bench](uint64_t iterations) {
+            CPU cpu;
+            Display display;
+            ScriptedInput input;
+            for (uint16_t instruction : bench.setup) {
+                cpu.execute_opcode(instruction, display, input);
+            }
+            for (uint64_t i = 0; i < iterations; i++) {
+                for (uint16_t instruction : bench.loop) {
+                    cpu.execute_opcode(instruction, display, input);
+                }
+            }
+            sink = cpu.get_program_counter();
+            return iterations * bench.loop.size();
+        });
+    }
+}
+
+// Display::draw_sprite placements: byte-aligned, unaligned, clipped at the right or bottom
+// edge, and with an origin that wraps around the screen
+struct SpriteBench {
+    const char* name;
+    uint8_t x;
+    uint8_t y;
+    uint8_t height;
+};
+
+static const std::vector<SpriteBench> SPRITE_BENCHES = {
+    {"aligned", 16, 8, 5},
+    {"unaligned", 13, 8, 5},
+    {"tall", 13, 8, 15},
+    {"clip_right", 60, 8, 5},
+    {"clip_bottom", 13, 28, 15},
+    {"wrap_origin", 77, 40, 5},
+};
+
+// The same placements in hi-res mode, plus 16x16 sprites and XO-CHIP's two planes
+struct HiresSpriteBench {
+    const char* name;
+    uint8_t x;
+    uint8_t y;
+    bool large;        // DXY0 instead of DXYN with 15 rows
+    uint8_t plane_mask;
+};
+
+static const std::vector<HiresSpriteBench> HIRES_SPRITE_BENCHES = {
+    {"hires_aligned", 16, 8, false, 1},
+    {"hires_word_boundary", 60, 8, false, 1},
+    {"hires_16x16", 61, 20, true, 1},
+    {"hires_16x16_clip", 120, 56, true, 1},
+    {"hires_16x16_two_planes", 61, 20, true, 3},
+};
+
+static void bench_display(BenchSuite& suite) {
+    static uint8_t sprite[15] = {0xF0, 0x90, 0xF0, 0x90, 0xF0, 0xFF, 0x81, 0x81, 0x81, 0xFF,
+                                 0x3C, 0x42, 0x81, 0x42, 0x3C};
+
+    for (const SpriteBench& bench : SPRITE_BENCHES) {
+        suite.run(std::string("sprite/") + bench.name, [&bench](uint64_t iterations) {
+            Display display;
+            uint64_t collisions = 0;
+            for (uint64_t i = 0; i < iterations; i++) {
+                collisions += display.draw_sprite(bench.x, bench.y, sprite, bench.height);
+            }
+            sink = collisions;
+            return iterations;
+        });
+    }
+
+    suite.run("display/clear", [](uint64_t iterations) {
+        Display display;
+        for (uint64_t i = 0; i < iterations; i++) {
+            display.draw_sprite(0, 0, sprite, 1);
+            display.clear_display();
+        }
+        sink = display.get_row(0, 0)[0];
+        return iterations;
+    });
+
+    static uint8_t large_sprite[64];
+    for (int i = 0; i < 64; i++) {
+        large_sprite[i] = (uint8_t) (i * 37 + 11);
+    }
+    for (const HiresSpriteBench& bench : HIRES_SPRITE_BENCHES) {
+        suite.run(std::string("sprite/") + bench.name, [&bench](uint64_t iterations) {
+            Display display;
+            display.set_hires(true);
+            display.set_plane_mask(bench.plane_mask);
+            uint64_t collisions = 0;
+            for (uint64_t i = 0; i < iterations; i++) {
+                collisions += bench.large ? display.draw_large_sprite(bench.x, bench.y, large_sprite)
+                                          : display.draw_sprite(bench.x, bench.y, large_sprite, 15);
+            }
+            sink = collisions;
+            return iterations;
+        });
+    }
+
+    // Scrolls of a full hi-res screen (and one lo-res one) with both planes selected
+    struct ScrollBench {
+        const char* name;
+        bool hires;
+        int kind; // 0 down, 1 up, 2 right, 3 left
+    };
+    static const ScrollBench SCROLL_BENCHES[] = {
+        {"display/scroll_down_hires", true, 0},
+        {"display/scroll_up_hires", true, 1},
+        {"display/scroll_right_hires", true, 2},
+        {"display/scroll_left_hires", true, 3},
+        {"display/scroll_left_lores", false, 3},
+    };
+    for (const ScrollBench& bench : SCROLL_BENCHES) {
+        suite.run(bench.name, [&bench](uint64_t iterations) {
+            Display display;
+            display.set_hires(bench.hires);
+            display.set_plane_mask(3);
+            for (int y = 0; y < display.get_height(); y += 4) {
+                display.draw_large_sprite(y * 3, y, large_sprite);
+            }
+            for (uint64_t i = 0; i < iterations; i++) {
+                switch (bench.kind) {
+                    case 0: display.scroll_down(1); break;
+                    case 1: display.scroll_up(1); break;
+                    case 2: display.scroll_right(); break;
+                    default: display.scroll_left(); break;
+                }
+            }
+            sink = display.get_row(0, 8)[0];
+            return iterations;
+        });
+    }
+}
+
+// The SDL-free part of presenting a frame: expanding the packed rows into 32-bit pixels
+static void bench_render(BenchSuite& suite) {
+    static uint32_t pixels[DISPLAY_HIRES_HEIGHT][DISPLAY_HIRES_WIDTH];
+    static uint8_t sprite[5] = {0xF0, 0x90, 0xF0, 0x90, 0xF0};
+
+    suite.run("render/expand_full_frame", [](uint64_t iterations) {
+        Display display;
+        display.draw_sprite(13, 3, sprite, 5);
+        for (uint64_t i = 0; i < iterations; i++) {
+            for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+                expand_row(display.get_row(0, y)[0], pixels[y], 0xFFFFFFFF, 0xFF000000);
+            }
+        }
+        sink = pixels[3][13];
+        return iterations;
+    });
+
+    // A full 128x64 frame with pixels in both planes
+    suite.run("render/expand_hires_planes", [](uint64_t iterations) {
+        static const uint32_t palette[4] = {0xFF000000, 0xFFFFFFFF, 0xFF606060, 0xFFB0B0B0};
+        Display display;
+        display.set_hires(true);
+        display.set_plane_mask(3);
+        for (int y = 0; y < DISPLAY_HIRES_HEIGHT; y += 4) {
+            display.draw_sprite(y * 2, y, sprite, 5);
+        }
+        for (uint64_t i = 0; i < iterations; i++) {
+            for (int y = 0; y < DISPLAY_HIRES_HEIGHT; y++) {
+                for (int w = 0; w < DISPLAY_ROW_WORDS; w++) {
+                    expand_row_planes(display.get_row(0, y)[w], display.get_row(1, y)[w], pixels[y] + w * 64, palette);
+                }
+            }
+        }
+        sink = pixels[3][13];
+        return iterations;
+    });
+
+    // A typical frame: one sprite drawn, then only its dirty rows re-expanded
+    suite.run("render/expand_dirty_rows", [](uint64_t iterations) {
+        Display display;
+        for (uint64_t i = 0; i < iterations; i++) {
+            display.draw_sprite((uint8_t) i, (uint8_t) (i >> 3), sprite, 5);
+            uint64_t dirty = display.get_dirty_rows();
+            for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+                if ((dirty >> y) & 1) {
+                    expand_row(display.get_row(0, y)[0], pixels[y], 0xFFFFFFFF, 0xFF000000);
+                }
+            }
+            display.clear_dirty_rows();
+        }
+        sink = pixels[0][0];
+        return iterations;
+    });
+}
+
+// Capturing and restoring a machine, as savestate images and as run-ahead snapshots. The
+// machine runs the "mixed" program, which writes memory every frame.
+static void bench_state(BenchSuite& suite) {
+    const std::vector<uint8_t>& program = BUILTIN_ROMS[2].program;
+    auto make_machine = [&program](ScriptedInput& input) {
+        std::unique_ptr<Machine> machine(new Machine(input));
+        machine->load_program(program.data(), program.size());
+        machine->run_frames(10);
+        return machine;
+    };
+
+    suite.run("state/savestate_save", [&make_machine](uint64_t iterations) {
+        ScriptedInput input;
+        std::unique_ptr<Machine> machine = make_machine(input);
+        std::unique_ptr<SaveState> state(new SaveState());
+        for (uint64_t i = 0; i < iterations; i++) {
+            machine->save_state(*state);
+        }
+        sink = (*state)[SAVESTATE_CPU_OFFSET];
+        return iterations;
+    });
+
+    suite.run("state/savestate_load", [&make_machine](uint64_t iterations) {
+        ScriptedInput input;
+        std::unique_ptr<Machine> machine = make_machine(input);
+        std::unique_ptr<SaveState> state(new SaveState());
+        machine->save_state(*state);
+        for (uint64_t i = 0; i < iterations; i++) {
+            machine->load_state(*state);
+        }
+        return iterations;
+    });
+
+    suite.run("state/snapshot_save", [&make_machine](uint64_t iterations) {
+        ScriptedInput input;
+        std::unique_ptr<Machine> machine = make_machine(input);
+        std::unique_ptr<MachineSnapshot> snapshot(new MachineSnapshot());
+        for (uint64_t i = 0; i < iterations; i++) {
+            machine->save_snapshot(*snapshot);
+        }
+        sink = snapshot->cpu.program_counter;
+        return iterations;
+    });
+
+    suite.run("state/snapshot_load", [&make_machine](uint64_t iterations) {
+        ScriptedInput input;
+        std::unique_ptr<Machine> machine = make_machine(input);
+        std::unique_ptr<MachineSnapshot> snapshot(new MachineSnapshot());
+        machine->save_snapshot(*snapshot);
+        for (uint64_t i = 0; i < iterations; i++) {
+            machine->load_snapshot(*snapshot);
+        }
+        return iterations;
+    });
+
+    // One host frame with run-ahead: the real frame, then snapshot, 2 speculative frames
+    // and roll back. Compare with rom/mixed for the cost of a plain frame.
+    suite.run("state/run_ahead_2", [&make_machine](uint64_t iterations) {
+        ScriptedInput input;
+        HeldInput held;
+        std::unique_ptr<Machine> machine = make_machine(input);
+        std::unique_ptr<MachineSnapshot> snapshot(new MachineSnapshot());
+        for (uint64_t i = 0; i < iterations; i++) {
+            machine->run_frame();
+            machine->save_snapshot(*snapshot);
+            held.hold(input);
+            machine->set_input(held);
+            machine->run_frame();
+            machine->run_frame();
+            machine->set_input(input);
+            machine->load_snapshot(*snapshot);
+        }
+        return iterations;
+    });
+}
+
+// The "mixed" program under a debugger that never stops, for the price of the checks; compare
+// with rom/mixed/threaded, which runs the same loop with the checks compiled out
+static void bench_debugger(BenchSuite& suite) {
+    const std::vector<uint8_t>& program = BUILTIN_ROMS[2].program;
+    auto run = [&program](uint64_t iterations, bool watch) {
+        ScriptedInput input;
+        Machine machine(input);
+        machine.get_cpu().set_dispatch_mode(DispatchMode::Threaded);
+        machine.set_cycles_per_frame(1000);
+        machine.load_program(program.data(), program.size());
+        std::unique_ptr<Debugger> debugger(new Debugger());
+        debugger->set_breakpoint(0xFFE);
+        if (watch) {
+            debugger->watch_memory(0xFF0, 8, true, true);
+        }
+        machine.debug_run(*debugger, iterations);
+        return machine.get_total_instructions();
+    };
+
+    suite.run("debug/breakpoint", [&run](uint64_t iterations) { return run(iterations, false); });
+    suite.run("debug/watchpoint", [&run](uint64_t iterations) { return run(iterations, true); });
+}
+
+// Whole programs through the Machine in every dispatch mode, one operation per instruction
+// (the recompiler only takes CHIP-8, so other variants skip the jit mode). "unfused" is the
+// cached mode without superinstructions.
+static void bench_rom(BenchSuite& suite, const std::string& name, const std::vector<uint8_t>& program,
+                      Chip8Variant variant = Chip8Variant::Chip8) {
+    struct Mode {
+        const char* name;
+        DispatchMode dispatch_mode;
+        bool jit;
+        bool fusion;
+    };
+    static const Mode MODES[] = {
+        {"switch", DispatchMode::Switch, false, true},
+        {"cached", DispatchMode::Cached, false, true},
+        {"unfused", DispatchMode::Cached, false, false},
+        {"threaded", DispatchMode::Threaded, false, true},
+        {"jit", DispatchMode::Cached, true, true},
+    };
+
+    for (const Mode& mode : MODES) {
+        suite.run("rom/" + name + "/" + mode.name, [&mode, &program, variant](uint64_t iterations) {
+            ScriptedInput input;
+            Machine machine(input);
+            machine.get_cpu().set_dispatch_mode(mode.dispatch_mode);
+            machine.get_cpu().set_fusion(mode.fusion);
+            machine.set_variant(variant);
+            machine.load_program(program.data(), program.size());
+            if (mode.jit && !machine.enable_jit(true)) {
+                return (uint64_t) 0;
+            }
+            // One iteration is one 60Hz frame's worth of cycles at 1000 cycles per frame
+            for (uint64_t i = 0; i < iterations && !machine.get_cpu().is_halted(); i++) {
+                machine.run_cycles(1000);
+                machine.tick_timers();
+            }
+            return machine.get_total_instructions();
+        });
+    }
+}
+
+// Read "name -> ns per op" from earlier output in either format
+static std::map<std::string, double> load_baseline(const std::string& filepath) {
+    std::map<std::string, double> baseline;
+    std::ifstream file(filepath);
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t name_pos = line.find("\"name\": \"");
+        if (name_pos != std::string::npos) {
+            // JSON: one object per line
+            size_t name_start = name_pos + 9;
+            size_t name_end = line.find('"', name_start);
+            size_t value_pos = line.find("\"ns_per_op\": ");
+            if (name_end != std::string::npos && value_pos != std::string::npos) {
+                baseline[line.substr(name_start, name_end - name_start)] = atof(line.c_str() + value_pos + 13);
+            }
+            continue;
+        }
+
+        // CSV: name,operations,ns_per_op,...
+        std::istringstream fields(line);
+        std::string name, operations, ns_per_op;
+        if (std::getline(fields, name, ',') && std::getline(fields, operations, ',') &&
+            std::getline(fields, ns_per_op, ',') && name != "name") {
+            baseline[name] = atof(ns_per_op.c_str());
+        }
+    }
+    return baseline;
+}
+
+int main(int argc, char* argv[]) {
+    bool json = false;
+    std::string filter;
+    double min_seconds = 0.1;
+    int samples = 5;
+    const char* baseline_path = nullptr;
+    double max_regression = -1;
+    std::vector<const char*> rom_paths;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format=json") == 0) {
+            json = true;
+        } else if (strcmp(argv[i], "--format=csv") == 0) {
+            json = false;
+        } else if (strncmp(argv[i], "--filter=", 9) == 0) {
+            filter = argv[i] + 9;
+        } else if (strncmp(argv[i], "--min-time=", 11) == 0) {
+            min_seconds = atoi(argv[i] + 11) / 1000.0;
+        } else if (strncmp(argv[i], "--samples=", 10) == 0) {
+            samples = atoi(argv[i] + 10);
+        } else if (strncmp(argv[i], "--baseline=", 11) == 0) {
+            baseline_path = argv[i] + 11;
+        } else if (strncmp(argv[i], "--max-regression=", 17) == 0) {
+            max_regression = atof(argv[i] + 17);
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            std::cerr << "Usage: " << argv[0] << " [--format=csv|json] [--filter=TEXT] [--min-time=MS] [--samples=N] "
+                      << "[--baseline=FILE] [--max-regression=PCT] [rom]..." << std::endl;
+            return 1;
+        } else {
+            rom_paths.push_back(argv[i]);
+        }
+    }
+    if (samples < 1) {
+        samples = 1;
+    }
+
+    std::map<std::string, double> baseline;
+    if (baseline_path != nullptr) {
+        baseline = load_baseline(baseline_path);
+        if (baseline.empty()) {
+            std::cerr << "Could not read baseline: " << baseline_path << std::endl;
+            return 1;
+        }
+    }
+
+    BenchSuite suite(filter, min_seconds, samples);
+    bench_opcodes(suite);
+    bench_display(suite);
+    bench_render(suite);
+    bench_state(suite);
+    bench_debugger(suite);
+    for (const BuiltinRom& rom : BUILTIN_ROMS) {
+        bench_rom(suite, rom.name, rom.program, rom.variant);
+    }
+    for (const char* path : rom_paths) {
+        std::vector<uint8_t> program;
+        if (!load_rom_file(path, program)) {
+            std::cerr << "Error: Could not read ROM file: " << path << std::endl;
+        } else if (!program.empty()) {
+            bench_rom(suite, path, program);
+        }
+    }
+
+    // Results, with the change against the baseline where it has the same benchmark
+    bool regressed = false;
+    if (json) {
+        std::cout << "[\n";
+    } else {
+        std::cout << "name,operations,ns_per_op" << (baseline.empty() ? "" : ",baseline_ns_per_op,change_pct") << "\n";
+    }
+    const std::vector<BenchResult>& results = suite.get_results();
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& result = results[i];
+        auto previous = baseline.find(result.name);
+        bool compared = previous != baseline.end() && previous->second > 0 && result.operations > 0;
+        double change = compared ? (result.ns_per_op / previous->second - 1) * 100 : 0;
+        if (compared && max_regression >= 0 && change > max_regression) {
+            regressed = true;
+        }
+
+        if (json) {
+            std::cout << "  {\"name\": \"" << result.name << "\", \"operations\": " << result.operations
+                      << ", \"ns_per_op\": " << result.ns_per_op;
+            if (compared) {
+                std::cout << ", \"baseline_ns_per_op\": " << previous->second << ", \"change_pct\": " << change;
+            }
+            std::cout << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        } else {
+            std::cout << result.name << "," << result.operations << "," << result.ns_per_op;
+            if (!baseline.empty()) {
+                if (compared) {
+                    std::cout << "," << previous->second << "," << change;
+                } else {
+                    std::cout << ",,";
+                }
+            }
+            std::cout << "\n";
+        }
+    }
+    if (json) {
+        std::cout << "]\n";
+    }
+    std::cout.flush();
+
+    if (regressed) {
+        std::cerr << "Slower than the baseline by more than " << max_regression << "%" << std::endl;
+        return 3;
+    }
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include "chip8.h"
+#include "input_source.h"
+#include "machine.h"
+#include "savestate.h"
+
+#include <cstring> // For memcpy
+
+static_assert(CHIP8_FAULT_PROGRAM_TOO_LARGE == static_cast<int>(CpuFault::ProgramTooLarge), "chip8_fault mirrors CpuFault");
+static_assert(CHIP8_VARIANT_XO_CHIP == static_cast<int>(Chip8Variant::XoChip), "chip8_variant mirrors Chip8Variant");
+static_assert(CHIP8_MAX_WIDTH == DISPLAY_HIRES_WIDTH && CHIP8_MAX_HEIGHT == DISPLAY_HIRES_HEIGHT, "Largest resolution");
+
+struct chip8_machine {
+    AtomicKeypad keypad;
+    mutable Machine machine; // Its accessors are not const, but the reads below change nothing
+    uint16_t keys;           // Mask from the previous chip8_set_keys, to find new presses
+    chip8_fault_callback fault_callback;
+    void* fault_context;
+    mutable SaveState state; // Scratch image, so savestates need no stack or heap space per call
+
+    chip8_machine() : machine(keypad), keys(0), fault_callback(nullptr), fault_context(nullptr) {}
+};
+
+static void forward_fault(void* context, CpuFault fault, uint16_t address) {
+    chip8_machine* machine = static_cast<chip8_machine*>(context);
+    machine->fault_callback(machine->fault_context, static_cast<chip8_fault>(fault), address);
+}
+
+chip8_machine* chip8_create(void) {
+    // Nothing may throw across the C boundary, including bad_alloc from the members' constructors
+    try {
+        return new chip8_machine();
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void chip8_destroy(chip8_machine* machine) {
+    delete machine;
+}
+
+chip8_status chip8_set_variant(chip8_machine* machine, chip8_variant variant) {
+    if (machine == nullptr || variant < CHIP8_VARIANT_CHIP8 || variant > CHIP8_VARIANT_XO_CHIP) {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+    machine->machine.set_variant(static_cast<Chip8Variant>(variant));
+    return CHIP8_OK;
+}
+
+chip8_status chip8_set_cycles_per_frame(chip8_machine* machine, int cycles) {
+    if (machine == nullptr || cycles <= 0) {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+    machine->machine.set_cycles_per_frame(cycles);
+    return CHIP8_OK;
+}
+
+chip8_status chip8_set_quirks(chip8_machine* machine, int quirks) {
+    if (machine == nullptr) {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+    machine->machine.get_cpu().set_new_functionality(quirks != 0);
+    return CHIP8_OK;
+}
+
+chip8_status chip8_seed_random(chip8_machine* machine, uint64_t seed) {
+    if (machine == nullptr) {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+    machine->machine.get_cpu().seed_random(seed);
+    return CHIP8_OK;
+}
+
+chip8_status chip8_set_fault_callback(chip8_machine* machine, chip8_fault_callback callback, void* context) {
+    if (machine == nullptr) {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+    machine->fault_callback = callback;
+    machine->fault_context = context;
+    machine->machine.get_cpu().set_fault_callback(callback != nullptr ? forward_fault : nullptr, machine);
+    return CHIP8_OK;
+}
+
+chip8_status chip8_load_program(chip8_machine* machine, const uint8_t* program, size_t size) {
+    if (machine == nullptr || (program == nullptr && size > 0)) {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+    CPU& cpu = machine->machine.get_cpu();
+    size_t memory_size = cpu.get_variant() == Chip8Variant::XoChip ? MEMORY_COUNT : CHIP8_MEMORY_SIZE;
+    if (size > memory_size - PROGRAM_BUFFER) {
+        // Let the CPU record the fault and halt, as it would for the front ends
+        machine->machine.load_program(program, static_cast<int>(memory_size));
+        return CHIP8_ERROR_PROGRAM_TOO_LARGE;
+    }
+    machine->machine.load_program(program, static_cast<int>(size));
+    return CHIP8_OK;
+}
+
+chip8_status chip8_run_frames(chip8_machine* machine, uint64_t frames) {
+    if (machine == nullptr) {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+    if (!machine->machine.get_cpu().is_halted()) {
+        machine->machine.run_frames(frames);
+    }
+    return machine->machine.get_cpu().is_halted() ? CHIP8_ERROR_HALTED : CHIP8_OK;
+}
+
+chip8_status chip8_set_keys(chip8_machine* machine, uint16_t key_mask) {
+    if (machine == nullptr) {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+    uint16_t presses = key_mask & ~machine->keys;
+    machine->keys = key_mask;
+    for (int key = 0; key < CHIP8_KEY_COUNT; key++) {
+        if (presses & (1u << key)) {
+            machine->keypad.update(key_mask, key);
+        }
+    }
+    machine->keypad.update(key_mask, -1);
+    return CHIP8_OK;
+}
+
+chip8_fault chip8_get_fault(const chip8_machine* machine) {
+    return machine != nullptr ? static_cast<chip8_fault>(machine->machine.get_cpu().get_fault()) : CHIP8_FAULT_NONE;
+}
+
+int chip8_sound_active(const chip8_machine* machine) {
+    return machine != nullptr && machine->machine.get_cpu().get_sound_timer() > 0;
+}
+
+uint64_t chip8_get_instructions(const chip8_machine* machine) {
+    return machine != nullptr ? machine->machine.get_total_instructions() : 0;
+}
+
+chip8_status chip8_get_resolution(const chip8_machine* machine, int* width, int* height) {
+    if (machine == nullptr || width == nullptr || height == nullptr) {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+    *width = machine->machine.get_display().get_width();
+    *height = machine->machine.get_display().get_height();
+    return CHIP8_OK;
+}
+
+chip8_status chip8_get_pixels(const chip8_machine* machine, uint8_t* pixels, size_t size) {
+    if (machine == nullptr || pixels == nullptr) {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+    const Display& display = machine->machine.get_display();
+    int width = display.get_width();
+    int height = display.get_height();
+    if (size < static_cast<size_t>(width) * height) {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            pixels[y * width + x] = display.get_pixel(x, y);
+        }
+    }
+    return CHIP8_OK;
+}
+
+size_t chip8_state_size(const chip8_machine* machine) {
+    return machine != nullptr ? savestate_size(machine->machine.get_cpu().get_variant()) : 0;
+}
+
+chip8_status chip8_save_state(const chip8_machine* machine, uint8_t* state, size_t size) {
+    if (machine == nullptr || state == nullptr || size < chip8_state_size(machine)) {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+    machine->machine.save_state(machine->state);
+    memcpy(state, machine->state.data(), chip8_state_size(machine));
+    return CHIP8_OK;
+}
+
+chip8_status chip8_load_state(chip8_machine* machine, const uint8_t* state, size_t size) {
+    if (machine == nullptr || state == nullptr || size < SAVESTATE_HEADER_SIZE) {
+        return CHIP8_ERROR_INVALID_ARGUMENT;
+    }
+    // The header names the variant and so the size; a state of another variant is refused
+    // by Machine::load_state, but only after checking the buffer holds all of it
+    size_t copied = size < (size_t) SAVESTATE_MAX_SIZE ? size : SAVESTATE_MAX_SIZE;
+    memcpy(machine->state.data(), state, copied);
+    if (!is_valid_savestate(machine->state) || (size_t) savestate_size(savestate_variant(machine->state)) > copied) {
+        return CHIP8_ERROR_BAD_STATE;
+    }
+    return machine->machine.load_state(machine->state) ? CHIP8_OK : CHIP8_ERROR_BAD_STATE;
+}
+
+const char* chip8_status_name(chip8_status status) {
+    switch (status) {
+        case CHIP8_OK: return "ok";
+        case CHIP8_ERROR_INVALID_ARGUMENT: return "invalid_argument";
+        case CHIP8_ERROR_PROGRAM_TOO_LARGE: return "program_too_large";
+        case CHIP8_ERROR_BAD_STATE: return "bad_state";
+        case CHIP8_ERROR_HALTED: return "halted";
+    }
+    return "unknown";
+}
+
+const char* chip8_fault_name(chip8_fault fault) {
+    return fault_name(static_cast<CpuFault>(fault));
+}
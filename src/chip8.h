@@ -0,0 +1,99 @@
+#ifndef CHIP8_H
+#define CHIP8_H
+
+// C API of libchip8: the emulator core (machine, cpu, display and friends) without SDL, for
+// embedding in other programs. Every chip8_machine is independent, so a process can run as
+// many as it likes, each on whichever thread it wants. Nothing here prints, exits or throws:
+// problems come back as a chip8_status, and CPU faults can also be delivered to a callback.
+// C++ hosts can use Machine (machine.h) directly instead; it behaves the same way.
+
+#include <stddef.h> // For size_t
+#include <stdint.h> // For uint8_t, uint16_t and uint64_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct chip8_machine chip8_machine;
+
+typedef enum chip8_status {
+    CHIP8_OK = 0,
+    CHIP8_ERROR_INVALID_ARGUMENT, // NULL machine or buffer, buffer too small, unknown variant
+    CHIP8_ERROR_PROGRAM_TOO_LARGE, // The program does not fit in the variant's memory
+    CHIP8_ERROR_BAD_STATE,        // Not a savestate of this version and the machine's variant
+    CHIP8_ERROR_HALTED            // The CPU stopped on a fatal fault (see chip8_get_fault)
+} chip8_status;
+
+// Same values and meaning as CpuFault in cpu.h
+typedef enum chip8_fault {
+    CHIP8_FAULT_NONE = 0,
+    CHIP8_FAULT_STACK_OVERFLOW,    // 2NNN with a full stack (the call is skipped)
+    CHIP8_FAULT_STACK_UNDERFLOW,   // 00EE with an empty stack (returns to 0x000)
+    CHIP8_FAULT_PC_OUT_OF_BOUNDS,  // Instruction fetch past the end of memory (halts)
+    CHIP8_FAULT_PROGRAM_TOO_LARGE  // chip8_load_program given too many bytes (halts)
+} chip8_fault;
+
+typedef enum chip8_variant {
+    CHIP8_VARIANT_CHIP8 = 0,
+    CHIP8_VARIANT_SUPER_CHIP,
+    CHIP8_VARIANT_XO_CHIP
+} chip8_variant;
+
+// Called on the thread running the machine for every fault as it happens, with the address
+// of the instruction involved. It must not call back into the same machine.
+typedef void (*chip8_fault_callback)(void* context, chip8_fault fault, uint16_t address);
+
+// Largest framebuffer chip8_get_pixels can fill (SUPER-CHIP / XO-CHIP hi-res)
+#define CHIP8_MAX_WIDTH 128
+#define CHIP8_MAX_HEIGHT 64
+
+// A new machine with CHIP-8 selected and nothing loaded, or NULL if memory ran out
+chip8_machine* chip8_create(void);
+void chip8_destroy(chip8_machine* machine);
+
+// Configuration: select the variant before loading a program. quirks non-zero selects the
+// CHIP-48 behaviour of 8XY6/8XYE/BNNN/FX55/FX65.
+chip8_status chip8_set_variant(chip8_machine* machine, chip8_variant variant);
+chip8_status chip8_set_cycles_per_frame(chip8_machine* machine, int cycles);
+chip8_status chip8_set_quirks(chip8_machine* machine, int quirks);
+chip8_status chip8_seed_random(chip8_machine* machine, uint64_t seed);
+chip8_status chip8_set_fault_callback(chip8_machine* machine, chip8_fault_callback callback, void* context);
+
+// Copy a program to 0x200. Machines are not reset in between, so run another program in a
+// new machine.
+chip8_status chip8_load_program(chip8_machine* machine, const uint8_t* program, size_t size);
+
+// Run whole 60Hz frames: poll the keys, run a frame's cycles, tick the timers. Returns
+// CHIP8_ERROR_HALTED once the CPU has halted; non-fatal faults only show in chip8_get_fault.
+chip8_status chip8_run_frames(chip8_machine* machine, uint64_t frames);
+
+// Keys held (bit n = key n). Keys that were up in the previous call count as presses for
+// FX0A. This may be called from another thread than the one running frames.
+chip8_status chip8_set_keys(chip8_machine* machine, uint16_t key_mask);
+
+// The first fault the machine ran into, CHIP8_FAULT_NONE if there was none
+chip8_fault chip8_get_fault(const chip8_machine* machine);
+int chip8_sound_active(const chip8_machine* machine); // Non-zero while the sound timer runs
+uint64_t chip8_get_instructions(const chip8_machine* machine);
+
+// Current resolution, and its pixels row by row: one byte each, bit 0 from plane 0 and bit 1
+// from plane 1. size must be at least width * height.
+chip8_status chip8_get_resolution(const chip8_machine* machine, int* width, int* height);
+chip8_status chip8_get_pixels(const chip8_machine* machine, uint8_t* pixels, size_t size);
+
+// Savestates in the same format as the front ends' files. A state takes chip8_state_size()
+// bytes for the machine's current variant (about 6 KB, or 66 KB on XO-CHIP), and only loads
+// into a machine running the variant it was saved from.
+size_t chip8_state_size(const chip8_machine* machine);
+chip8_status chip8_save_state(const chip8_machine* machine, uint8_t* state, size_t size);
+chip8_status chip8_load_state(chip8_machine* machine, const uint8_t* state, size_t size);
+
+// Short names for reports
+const char* chip8_status_name(chip8_status status);
+const char* chip8_fault_name(chip8_fault fault);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CHIP8_H
@@ -1,29 +1,89 @@
 #include <cstdlib>
 #include <cstdint>
-#include <iostream>
+#include <cstring>
+#include <type_traits>
 #include "cpu.h"
-#include "input.h"
+#include "input_source.h"
 #include "display.h"
+#include "opcodes.h"
+#include "jit.h"
+#include "debugger.h"
+#include "profile.h"
 
 CPU::CPU() {
     program_counter = PROGRAM_BUFFER;
     index_register = 0;
     paused = false;
+    paused_register = 0;
     delay_timer = 0;
     sound_timer = 0;
     stack_pointer = 0;
+    dispatch_mode = DispatchMode::Cached;
+    fusion = true;
+    variant = Chip8Variant::Chip8;
+    decode_table = &DECODE_TABLE;
+    memory_size = CHIP8_MEMORY_SIZE;
+    new_functionality = false;
+    jit = nullptr;
+    fault_callback = nullptr;
+    fault_context = nullptr;
     initialize_cpu();
 }
 
 void CPU::initialize_cpu() {
+    halted = false;
+    fault = CpuFault::None;
     clear_registers();
     clear_stack();
     clear_memory();
+    clear_decode_cache();
     load_font();
+    memset(rpl_flags, 0, sizeof(rpl_flags));
+    memset(audio_pattern, 0, sizeof(audio_pattern));
+    audio_pitch = DEFAULT_AUDIO_PITCH;
 }
 
 bool CPU::is_paused () const { return paused; }
 void CPU::unpause() { paused = false; }
+bool CPU::is_halted() const { return halted; }
+CpuFault CPU::get_fault() const { return fault; }
+
+const char* fault_name(CpuFault fault) {
+    switch (fault) {
+        case CpuFault::None: return "none";
+        case CpuFault::StackOverflow: return "stack_overflow";
+        case CpuFault::StackUnderflow: return "stack_underflow";
+        case CpuFault::PcOutOfBounds: return "pc_out_of_bounds";
+        case CpuFault::ProgramTooLarge: return "program_too_large";
+    }
+    return "unknown";
+}
+
+void CPU::raise_fault(CpuFault new_fault, uint16_t address) {
+    if (fault == CpuFault::None) {
+        fault = new_fault;
+    }
+    if (new_fault == CpuFault::PcOutOfBounds || new_fault == CpuFault::ProgramTooLarge) {
+        halted = true;
+    }
+    if (fault_callback != nullptr) {
+        fault_callback(fault_context, new_fault, address);
+    }
+}
+
+void CPU::set_fault_callback(FaultCallback callback, void* context) {
+    fault_callback = callback;
+    fault_context = context;
+}
+
+uint16_t CPU::get_program_counter() const { return program_counter; }
+uint16_t CPU::get_index_register() const { return index_register; }
+uint8_t CPU::get_register(uint8_t index) const { return registers[index & (REGISTER_COUNT - 1)]; }
+uint8_t CPU::get_stack_pointer() const { return stack_pointer; }
+void CPU::copy_registers(uint8_t out[REGISTER_COUNT]) const { memcpy(out, registers, REGISTER_COUNT); }
+uint8_t CPU::get_delay_timer() const { return delay_timer; }
+uint8_t CPU::get_sound_timer() const { return sound_timer; }
+uint8_t CPU::read_memory(uint16_t address) const { return memory[address & (memory_size - 1)]; }
 
 void CPU::decrement_timers() {
     // Update timers if they are above 0
@@ -38,6 +98,32 @@ void CPU::clear_memory() {
     }
 }
 
+void CPU::clear_decode_cache() {
+    for (int i = 0; i < CHIP8_MEMORY_SIZE; i++) {
+        decode_cache[i].handler = nullptr;
+    }
+    if (jit != nullptr) {
+        jit->flush();
+    }
+}
+
+void CPU::invalidate_decoded(uint16_t address) {
+    // Entries starting up to a fused sequence's length before the address overlap the write
+    int first = address - (2 * FUSED_MAX_LENGTH - 1);
+    for (int entry = first > 0 ? first : 0; entry <= address && entry < CHIP8_MEMORY_SIZE; entry++) {
+        decode_cache[entry].handler = nullptr;
+    }
+}
+
+void CPU::write_memory(uint16_t address, uint8_t value) {
+    address &= memory_size - 1;
+    memory[address] = value;
+    invalidate_decoded(address);
+    if (jit != nullptr) {
+        jit->invalidate(address);
+    }
+}
+
 void CPU::clear_stack() {
     // Iterate through all stack positions and set values to 0
     for (int i = 0; i < STACK_COUNT; i++) {
@@ -55,7 +141,7 @@ void CPU::clear_registers() {
 void CPU::push_to_stack(uint16_t value) {
     // Don't push to stack if stack is full
     if (stack_pointer >= STACK_COUNT) {
-        std::cerr << "Error: Pushing to a full stack" << std::endl;
+        raise_fault(CpuFault::StackOverflow, program_counter - 2);
         return;
     }
 
@@ -67,7 +153,7 @@ void CPU::push_to_stack(uint16_t value) {
 uint16_t CPU::pop_from_stack () {
     // Don't pop from stack if stack is empty
     if (stack_pointer == 0){
-        std::cerr << "Error: Popping from an empty stack" << std::endl;
+        raise_fault(CpuFault::StackUnderflow, program_counter - 2);
         return 0;
     }
 
@@ -81,25 +167,36 @@ void CPU::load_font() {
     for (int i = 0; i < FONT_COUNT; i++) {
         memory[i] = CHIP8_FONT[i];
     }
+
+    // The big font only exists on SUPER-CHIP and later; CHIP-8 sees zeroes there
+    bool big_font = variant != Chip8Variant::Chip8;
+    for (int i = 0; i < BIG_FONT_COUNT; i++) {
+        memory[FONT_COUNT + i] = big_font ? CHIP8_BIG_FONT[i] : 0;
+    }
 }
 
-void CPU::load_program(uint8_t program[], int size) {
-    if (PROGRAM_BUFFER + size >= MEMORY_COUNT) {
-        std::cerr << "Error: Program size too large to fit in memory\n"  << std::endl;
-        exit(1);
+void CPU::load_program(const uint8_t program[], int size) {
+    if (PROGRAM_BUFFER + size > memory_size) {
+        raise_fault(CpuFault::ProgramTooLarge, PROGRAM_BUFFER);
+        return;
     }
 
-    // Load a program into the CPU's memory
-    for (int i = 0; i < size; i++) {
-        memory[PROGRAM_BUFFER + i] = program[i];
+    // Load a program into the CPU's memory with one copy straight from the caller's buffer
+    // (e.g. a memory-mapped ROM file), then drop decoded instructions overlapping the old contents
+    memcpy(&memory[PROGRAM_BUFFER], program, size);
+    for (int address = PROGRAM_BUFFER - (2 * FUSED_MAX_LENGTH - 1); address < PROGRAM_BUFFER + size && address < CHIP8_MEMORY_SIZE; address++) {
+        decode_cache[address].handler = nullptr;
+    }
+    if (jit != nullptr) {
+        jit->flush();
     }
 }
 
 uint16_t CPU::fetch_opcode() {
-    if (program_counter + 1 >= MEMORY_COUNT) {
-        std::cerr << "Error: Attempted to fetch instruction beyond memory bounds at 0x"
-                    << std::hex << program_counter << "\n";
-        exit(1); // or throw an exception, or set a fatal error flag
+    if (program_counter + 1 >= memory_size) {
+        // Halt this CPU only; the host process keeps running
+        raise_fault(CpuFault::PcOutOfBounds, program_counter);
+        return 0x0000;
     }
 
 
@@ -113,7 +210,38 @@ uint16_t CPU::fetch_opcode() {
     return (instruction_1 << 8) | instruction_2;
 }
 
-void CPU::execute_opcode(uint16_t instruction, Display& display, Input& input, bool new_functionality) {
+const DecodedInstruction& CPU::fetch_decoded() {
+    if (program_counter + 1 >= memory_size) {
+        raise_fault(CpuFault::PcOutOfBounds, program_counter);
+        static const DecodedInstruction halted_nop = decode_instruction(0x0000);
+        return halted_nop;
+    }
+
+    if (program_counter >= CHIP8_MEMORY_SIZE) {
+        uncached_decoded = decode_instruction((memory[program_counter] << 8) | memory[program_counter + 1], *decode_table);
+        program_counter += 2;
+        return uncached_decoded;
+    }
+
+    // Decode on first use; later visits skip the fetch and operand extraction entirely
+    DecodedInstruction& decoded = decode_cache[program_counter];
+    if (decoded.handler == nullptr) {
+        decoded = decode_instruction((memory[program_counter] << 8) | memory[program_counter + 1], *decode_table);
+        decoded.fused = match_fused(program_counter);
+    }
+
+    program_counter += 2;
+    return decoded;
+}
+
+void CPU::execute_opcode(uint16_t instruction, Display& display, InputSource& input, bool new_functionality) {
+    // SUPER-CHIP and XO-CHIP additions have no cases below; run them through their handlers
+    if ((*decode_table)[instruction] > OP_LD_VX_I) {
+        DecodedInstruction decoded = decode_instruction(instruction, *decode_table);
+        decoded.handler(*this, decoded, display, input);
+        return;
+    }
+
     // Extract nibbles from the instructions
     uint16_t first = (instruction & 0xF000); // Get instruction type
     uint8_t x = (instruction & 0x0F00) >> 8;      // 2nd nibble
@@ -146,17 +274,17 @@ void CPU::execute_opcode(uint16_t instruction, Display& display, Input& input, b
             break;
         case 0x3000:
             if (registers[x] == nn) {
-                program_counter += 2;
+                skip_instruction();
             }
             break;
         case 0x4000:
             if (registers[x] != nn) {
-                program_counter += 2;
+                skip_instruction();
             }
             break;
         case 0x5000:
             if (registers[x] == registers[y]) {
-                program_counter += 2;
+                skip_instruction();
             }
             break;
         case 0x6000:
@@ -243,7 +371,7 @@ void CPU::execute_opcode(uint16_t instruction, Display& display, Input& input, b
         case 0x9000:
             // Skip to next instruction if x and y do not equal each other
             if (registers[x] != registers[y]) {
-                program_counter += 2;
+                skip_instruction();
             }
             break;
         case 0xA000:
@@ -261,21 +389,24 @@ void CPU::execute_opcode(uint16_t instruction, Display& display, Input& input, b
             break;
         case 0xC000:
             // Assigns register x to random value AND nn
-            registers[x] = rand() & nn;
+            registers[x] = rng.next_byte() & nn;
             break;
         case 0xD000:
-            registers[FLAG_REGISTER] = display.draw_sprite(registers[x], registers[y], &memory[index_register], n);
+            {
+                uint8_t scratch[SPRITE_MAX_BYTES];
+                registers[FLAG_REGISTER] = display.draw_sprite(registers[x], registers[y], sprite_source(scratch), n);
+            }
             break;
         case 0xE000:
             switch (nn) {
                 case 0x009E:
                     if (input.is_pressed(registers[x])) {
-                        program_counter += 2;
+                        skip_instruction();
                     }
                     break;
                 case 0x00A1:
                     if (!input.is_pressed(registers[x])) {
-                        program_counter += 2;
+                        skip_instruction();
                     }
                     break;
                 default:
@@ -300,7 +431,7 @@ void CPU::execute_opcode(uint16_t instruction, Display& display, Input& input, b
                     {
                         // Add to index register
                         uint16_t sum = index_register + registers[x];
-                        index_register = (uint8_t) sum;
+                        index_register = variant == Chip8Variant::Chip8 ? (uint8_t) sum : sum;
                         registers[FLAG_REGISTER] = 0;
 
                         // Set flag register if overflowed
@@ -323,15 +454,15 @@ void CPU::execute_opcode(uint16_t instruction, Display& display, Input& input, b
                     {
                         // Break down the value within register and set the 3 numbers into memory
                         uint8_t value = registers[x];
-                        memory[index_register] = value / 100;
-                        memory[index_register + 1] = (value % 100) / 10;
-                        memory[index_register + 2] = value % 10;
+                        write_memory(index_register, value / 100);
+                        write_memory(index_register + 1, (value % 100) / 10);
+                        write_memory(index_register + 2, value % 10);
                     }
                     break;
                 case 0x0055:
                     // Set memory to values within x registers
                     for (int i = 0; i <= x; i++) {
-                        memory[index_register + i] = registers[i];
+                        write_memory(index_register + i, registers[i]);
                     }
 
                     // Increment index register if not using new functionality
@@ -340,7 +471,7 @@ void CPU::execute_opcode(uint16_t instruction, Display& display, Input& input, b
                 case 0x0065:
                     // Set registers to values within memory
                     for (int i = 0; i <= x; i++) {
-                        registers[i] = memory[index_register + i];
+                        registers[i] = read_memory(index_register + i);
                     }
 
                     // Increment index register if not usng new functionality
@@ -359,14 +490,723 @@ void CPU::set_register_after_key_press(uint8_t key_pressed) {
     registers[paused_register] = key_pressed;
 }
 
-void CPU::emulate_cycle(Display& display, Input& input) {
-    if (paused) {
+void CPU::set_dispatch_mode(DispatchMode mode) { dispatch_mode = mode; }
+DispatchMode CPU::get_dispatch_mode() const { return dispatch_mode; }
+
+void CPU::set_fusion(bool enabled) { fusion = enabled; }
+bool CPU::get_fusion() const { return fusion; }
+
+void CPU::set_new_functionality(bool enabled) { new_functionality = enabled; }
+bool CPU::get_new_functionality() const { return new_functionality; }
+
+void CPU::set_variant(Chip8Variant new_variant) {
+    variant = new_variant;
+    decode_table = &decode_table_for(variant);
+    memory_size = variant == Chip8Variant::XoChip ? MEMORY_COUNT : CHIP8_MEMORY_SIZE;
+    memset(memory + memory_size, 0, MEMORY_COUNT - memory_size);
+    load_font();
+    clear_decode_cache();
+}
+
+Chip8Variant CPU::get_variant() const { return variant; }
+
+const uint8_t* CPU::get_audio_pattern() const { return audio_pattern; }
+uint8_t CPU::get_audio_pitch() const { return audio_pitch; }
+
+const uint8_t* CPU::sprite_source(uint8_t* scratch) const {
+    // Sprites are read straight from memory unless they run off the end of the variant's
+    // memory, in which case they wrap around to address 0 like every other access
+    if (index_register <= memory_size - SPRITE_MAX_BYTES) {
+        return &memory[index_register];
+    }
+    for (int i = 0; i < SPRITE_MAX_BYTES; i++) {
+        scratch[i] = read_memory(index_register + i);
+    }
+    return scratch;
+}
+
+void CPU::seed_random(uint64_t seed) { rng.seed(seed); }
+
+void CPU::attach_jit(Jit* recompiler) { jit = recompiler; }
+
+void CPU::save_state(uint8_t* out) const {
+    // Layout: V0-VF, PC, I, DT, ST, SP, paused register, flags, fault, stack, RNG, RPL flags,
+    // audio pattern, pitch, then memory. The header is padded out to CPU_STATE_HEADER_SIZE bytes.
+    memset(out, 0, CPU_STATE_HEADER_SIZE);
+    memcpy(out, registers, REGISTER_COUNT);
+    out[16] = program_counter & 0xFF;
+    out[17] = program_counter >> 8;
+    out[18] = index_register & 0xFF;
+    out[19] = index_register >> 8;
+    out[20] = delay_timer;
+    out[21] = sound_timer;
+    out[22] = stack_pointer;
+    out[23] = paused_register;
+    out[24] = (paused ? 0x01 : 0) | (halted ? 0x02 : 0);
+    out[25] = static_cast<uint8_t>(fault);
+    for (int i = 0; i < STACK_COUNT; i++) {
+        out[28 + i * 2] = stack[i] & 0xFF;
+        out[29 + i * 2] = stack[i] >> 8;
+    }
+    uint64_t rng_state = rng.get_state();
+    for (int b = 0; b < 8; b++) {
+        out[64 + b] = (rng_state >> (b * 8)) & 0xFF;
+    }
+    memcpy(out + 72, rpl_flags, RPL_FLAG_COUNT);
+    memcpy(out + 88, audio_pattern, AUDIO_PATTERN_SIZE);
+    out[104] = audio_pitch;
+    memcpy(out + CPU_STATE_HEADER_SIZE, memory, memory_size);
+}
+
+bool CPU::load_state(const uint8_t* in) {
+    if (in[25] > static_cast<uint8_t>(CpuFault::ProgramTooLarge)) {
+        return false;
+    }
+    memcpy(registers, in, REGISTER_COUNT);
+    program_counter = in[16] | (in[17] << 8);
+    index_register = in[18] | (in[19] << 8);
+    delay_timer = in[20];
+    sound_timer = in[21];
+    stack_pointer = in[22] < STACK_COUNT ? in[22] : STACK_COUNT;
+    paused_register = in[23] & (REGISTER_COUNT - 1);
+    paused = (in[24] & 0x01) != 0;
+    halted = (in[24] & 0x02) != 0;
+    fault = static_cast<CpuFault>(in[25]);
+    for (int i = 0; i < STACK_COUNT; i++) {
+        stack[i] = in[28 + i * 2] | (in[29 + i * 2] << 8);
+    }
+    uint64_t rng_state = 0;
+    for (int b = 0; b < 8; b++) {
+        rng_state |= (uint64_t) in[64 + b] << (b * 8);
+    }
+    rng.set_state(rng_state);
+    memcpy(rpl_flags, in + 72, RPL_FLAG_COUNT);
+    memcpy(audio_pattern, in + 88, AUDIO_PATTERN_SIZE);
+    audio_pitch = in[104];
+
+    restore_memory(in + CPU_STATE_HEADER_SIZE, memory_size);
+    return true;
+}
+
+void CPU::restore_memory(const uint8_t* image, int size) {
+    // Only bytes that actually change need their decoded instructions dropped. Most frames
+    // write a few bytes at most, so whole blocks that still match are skipped.
+    const int BLOCK = 64;
+    for (int block = 0; block < size; block += BLOCK) {
+        if (memcmp(memory + block, image + block, BLOCK) == 0) {
+            continue;
+        }
+        for (int address = block; address < block + BLOCK; address++) {
+            if (memory[address] != image[address]) {
+                write_memory(address, image[address]);
+            }
+        }
+    }
+}
+
+void CPU::save_snapshot(CpuSnapshot& snapshot) const {
+    memcpy(snapshot.registers, registers, REGISTER_COUNT);
+    snapshot.program_counter = program_counter;
+    snapshot.index_register = index_register;
+    snapshot.paused = paused;
+    snapshot.paused_register = paused_register;
+    snapshot.halted = halted;
+    snapshot.fault = fault;
+    snapshot.delay_timer = delay_timer;
+    snapshot.sound_timer = sound_timer;
+    snapshot.stack_pointer = stack_pointer;
+    memcpy(snapshot.stack, stack, sizeof(stack));
+    memcpy(snapshot.rpl_flags, rpl_flags, RPL_FLAG_COUNT);
+    memcpy(snapshot.audio_pattern, audio_pattern, AUDIO_PATTERN_SIZE);
+    snapshot.audio_pitch = audio_pitch;
+    snapshot.rng_state = rng.get_state();
+    memcpy(snapshot.memory, memory, memory_size);
+}
+
+void CPU::load_snapshot(const CpuSnapshot& snapshot) {
+    memcpy(registers, snapshot.registers, REGISTER_COUNT);
+    program_counter = snapshot.program_counter;
+    index_register = snapshot.index_register;
+    paused = snapshot.paused;
+    paused_register = snapshot.paused_register;
+    halted = snapshot.halted;
+    fault = snapshot.fault;
+    delay_timer = snapshot.delay_timer;
+    sound_timer = snapshot.sound_timer;
+    stack_pointer = snapshot.stack_pointer;
+    memcpy(stack, snapshot.stack, sizeof(stack));
+    memcpy(rpl_flags, snapshot.rpl_flags, RPL_FLAG_COUNT);
+    memcpy(audio_pattern, snapshot.audio_pattern, AUDIO_PATTERN_SIZE);
+    audio_pitch = snapshot.audio_pitch;
+    rng.set_state(snapshot.rng_state);
+    restore_memory(snapshot.memory, memory_size);
+}
+
+bool CPU::same_state(const CPU& other) const {
+    return memcmp(registers, other.registers, sizeof(registers)) == 0 &&
+           program_counter == other.program_counter &&
+           index_register == other.index_register &&
+           paused == other.paused &&
+           halted == other.halted &&
+           rng.get_state() == other.rng.get_state() &&
+           delay_timer == other.delay_timer &&
+           sound_timer == other.sound_timer &&
+           stack_pointer == other.stack_pointer &&
+           memcmp(stack, other.stack, sizeof(stack)) == 0 &&
+           memcmp(rpl_flags, other.rpl_flags, sizeof(rpl_flags)) == 0 &&
+           memcmp(audio_pattern, other.audio_pattern, sizeof(audio_pattern)) == 0 &&
+           audio_pitch == other.audio_pitch &&
+           memcmp(memory, other.memory, sizeof(memory)) == 0;
+}
+
+void CPU::emulate_cycle(Display& display, InputSource& input) {
+    if (paused || halted) {
+        return;
+    }
+
+    if (dispatch_mode == DispatchMode::Cached) {
+        // Run the pre-decoded handler for the current address
+        const DecodedInstruction& decoded = fetch_decoded();
+        CHIP8_PROFILE_INSTRUCTION(program_counter - 2, decoded.operation);
+        decoded.handler(*this, decoded, display, input);
         return;
     }
 
     // Fetch the current instruction
     uint16_t instruction = fetch_opcode();
 
+    if (dispatch_mode == DispatchMode::Threaded) {
+        // Decode through the table and call the handler directly
+        DecodedInstruction decoded = decode_instruction(instruction, *decode_table);
+        CHIP8_PROFILE_INSTRUCTION(program_counter - 2, decoded.operation);
+        decoded.handler(*this, decoded, display, input);
+        return;
+    }
+
     // Decode the instruction and execute
-    execute_opcode(instruction, display, input, false);
+    CHIP8_PROFILE_INSTRUCTION(program_counter - 2, (*decode_table)[instruction]);
+    execute_opcode(instruction, display, input, new_functionality);
+}
+
+template <typename DebugPolicy>
+int CPU::run_cycles_with(Display& display, InputSource& input, int max_cycles, DebugPolicy& debugger) {
+    int executed = 0;
+
+#if defined(__GNUC__)
+    if (dispatch_mode == DispatchMode::Threaded) {
+        // Threaded code: every handler ends with its own indirect jump to the next one,
+        // giving the branch predictor one jump site per operation instead of a shared switch
+        static void* const LABELS[] = {
+            &&nop, &&cls, &&ret, &&jp, &&call,
+            &&se_vx_nn, &&sne_vx_nn, &&se_vx_vy, &&ld_vx_nn, &&add_vx_nn,
+            &&ld_vx_vy, &&and_vx_vy, &&xor_vx_vy, &&add_vx_vy, &&sub_vx_vy,
+            &&shr_vx_vy, &&subn_vx_vy, &&shl_vx_vy, &&sne_vx_vy, &&ld_i_nnn,
+            &&jp_v0_nnn, &&rnd_vx_nn, &&drw_vx_vy_n, &&skp_vx, &&sknp_vx,
+            &&ld_vx_dt, &&ld_vx_k, &&ld_dt_vx, &&ld_st_vx, &&add_i_vx,
+            &&ld_f_vx, &&ld_b_vx, &&ld_i_vx, &&ld_vx_i,
+            &&extended, &&extended, &&extended, &&extended, &&extended,
+            &&extended, &&extended, &&extended, &&extended, &&extended,
+            &&extended, &&extended, &&extended, &&extended, &&extended,
+            &&extended, &&extended
+        };
+        static_assert(sizeof(LABELS) / sizeof(LABELS[0]) == OP_COUNT, "Every operation needs a label");
+
+        DecodedInstruction d;
+        const DecodeTable& table = *decode_table;
+
+#define DISPATCH_NEXT()                                   \
+        if (executed == max_cycles || paused || halted || \
+            debugger.stop(*this, display)) {              \
+            return executed;                              \
+        }                                                 \
+        d = decode_instruction(fetch_opcode(), table);    \
+        if (halted) {                                     \
+            return executed;                              \
+        }                                                 \
+        CHIP8_PROFILE_INSTRUCTION(program_counter - 2, d.operation); \
+        executed += 1;                                    \
+        goto *LABELS[d.operation]
+
+#define THREADED_OP(label, handler)                       \
+    label:                                                \
+        handler(*this, d, display, input);                \
+        DISPATCH_NEXT()
+
+        DISPATCH_NEXT();
+
+        THREADED_OP(nop, op_nop);
+        THREADED_OP(cls, op_cls);
+        THREADED_OP(ret, op_ret);
+        THREADED_OP(jp, op_jp);
+        THREADED_OP(call, op_call);
+        THREADED_OP(se_vx_nn, op_se_vx_nn);
+        THREADED_OP(sne_vx_nn, op_sne_vx_nn);
+        THREADED_OP(se_vx_vy, op_se_vx_vy);
+        THREADED_OP(ld_vx_nn, op_ld_vx_nn);
+        THREADED_OP(add_vx_nn, op_add_vx_nn);
+        THREADED_OP(ld_vx_vy, op_ld_vx_vy);
+        THREADED_OP(and_vx_vy, op_and_vx_vy);
+        THREADED_OP(xor_vx_vy, op_xor_vx_vy);
+        THREADED_OP(add_vx_vy, op_add_vx_vy);
+        THREADED_OP(sub_vx_vy, op_sub_vx_vy);
+        THREADED_OP(shr_vx_vy, op_shr_vx_vy);
+        THREADED_OP(subn_vx_vy, op_subn_vx_vy);
+        THREADED_OP(shl_vx_vy, op_shl_vx_vy);
+        THREADED_OP(sne_vx_vy, op_sne_vx_vy);
+        THREADED_OP(ld_i_nnn, op_ld_i_nnn);
+        THREADED_OP(jp_v0_nnn, op_jp_v0_nnn);
+        THREADED_OP(rnd_vx_nn, op_rnd_vx_nn);
+        THREADED_OP(drw_vx_vy_n, op_drw_vx_vy_n);
+        THREADED_OP(skp_vx, op_skp_vx);
+        THREADED_OP(sknp_vx, op_sknp_vx);
+        THREADED_OP(ld_vx_dt, op_ld_vx_dt);
+        THREADED_OP(ld_vx_k, op_ld_vx_k);
+        THREADED_OP(ld_dt_vx, op_ld_dt_vx);
+        THREADED_OP(ld_st_vx, op_ld_st_vx);
+        THREADED_OP(add_i_vx, op_add_i_vx);
+        THREADED_OP(ld_f_vx, op_ld_f_vx);
+        THREADED_OP(ld_b_vx, op_ld_b_vx);
+        THREADED_OP(ld_i_vx, op_ld_i_vx);
+        THREADED_OP(ld_vx_i, op_ld_vx_i);
+
+        // SUPER-CHIP / XO-CHIP operations are rare enough to share one jump site
+        THREADED_OP(extended, d.handler);
+
+#undef THREADED_OP
+#undef DISPATCH_NEXT
+    }
+#endif
+
+    // Cached dispatch with nothing watching individual instructions runs a fused sequence as
+    // one step, provided all of its instructions fit in the budget
+    if (std::is_same<DebugPolicy, NoDebugger>::value && !PROFILE_ENABLED &&
+        dispatch_mode == DispatchMode::Cached && fusion) {
+        while (executed < max_cycles && !paused && !halted) {
+            const DecodedInstruction& decoded = fetch_decoded();
+            if (decoded.fused != FUSED_NONE && max_cycles - executed >= FUSED_LENGTHS[decoded.fused]) {
+                executed += FUSED_HANDLERS[decoded.fused](*this, decoded, display, input);
+                continue;
+            }
+            decoded.handler(*this, decoded, display, input);
+            if (!halted) {
+                executed += 1;
+            }
+        }
+        return executed;
+    }
+
+    // Portable loop (and the only loop for the switch and cached modes)
+    while (executed < max_cycles && !paused && !halted && !debugger.stop(*this, display)) {
+        emulate_cycle(display, input);
+        if (!halted) {
+            executed += 1;
+        }
+    }
+    return executed;
+}
+
+int CPU::run_cycles(Display& display, InputSource& input, int max_cycles) {
+    NoDebugger no_debugger;
+    return run_cycles_with(display, input, max_cycles, no_debugger);
+}
+
+template int CPU::run_cycles_with<Debugger>(Display& display, InputSource& input, int max_cycles, Debugger& debugger);
+
+// Operations whose effect depends only on registers, I, memory, timers and keys, and that
+// change nothing but registers, I and the PC. A loop made of these cannot make progress
+// within a frame.
+static bool is_idle_safe(Operation operation) {
+    switch (operation) {
+        case OP_NOP: case OP_JP: case OP_JP_V0_NNN:
+        case OP_SE_VX_NN: case OP_SNE_VX_NN: case OP_SE_VX_VY: case OP_SNE_VX_VY:
+        case OP_SKP_VX: case OP_SKNP_VX:
+        case OP_LD_VX_NN: case OP_ADD_VX_NN: case OP_LD_VX_VY: case OP_AND_VX_VY:
+        case OP_XOR_VX_VY: case OP_ADD_VX_VY: case OP_SUB_VX_VY: case OP_SHR_VX_VY:
+        case OP_SUBN_VX_VY: case OP_SHL_VX_VY:
+        case OP_LD_I_NNN: case OP_ADD_I_VX: case OP_LD_F_VX:
+        case OP_LD_VX_DT: case OP_LD_VX_I:
+            return true;
+        default:
+            return false;
+    }
+}
+
+int CPU::probe_idle_loop(Display& display, InputSource& input, int max_cycles, int& executed) {
+    executed = 0;
+    uint16_t start_pc = program_counter;
+    uint8_t start_registers[REGISTER_COUNT];
+    uint16_t start_index = 0;
+    bool started = false;
+    int length = 0;
+
+    // The first iteration settles values left over from before the loop (e.g. Vx before
+    // FX07 has run); the second must then reproduce the state exactly
+    while (executed < max_cycles && length < IDLE_LOOP_MAX_LENGTH && !paused && !halted) {
+        if (program_counter + 1 >= memory_size ||
+            !is_idle_safe(static_cast<Operation>((*decode_table)[(memory[program_counter] << 8) | memory[program_counter + 1]]))) {
+            return 0;
+        }
+        emulate_cycle(display, input);
+        executed += 1;
+        length += 1;
+
+        if (program_counter == start_pc) {
+            if (started && index_register == start_index &&
+                memcmp(registers, start_registers, sizeof(registers)) == 0) {
+                return length;
+            }
+            memcpy(start_registers, registers, sizeof(registers));
+            start_index = index_register;
+            started = true;
+            length = 0;
+        }
+    }
+    return 0;
+}
+
+// Handlers below mirror the cases of execute_opcode one for one
+
+const InstructionHandler CPU::HANDLERS[] = {
+    &CPU::op_nop, &CPU::op_cls, &CPU::op_ret, &CPU::op_jp, &CPU::op_call,
+    &CPU::op_se_vx_nn, &CPU::op_sne_vx_nn, &CPU::op_se_vx_vy, &CPU::op_ld_vx_nn, &CPU::op_add_vx_nn,
+    &CPU::op_ld_vx_vy, &CPU::op_and_vx_vy, &CPU::op_xor_vx_vy, &CPU::op_add_vx_vy, &CPU::op_sub_vx_vy,
+    &CPU::op_shr_vx_vy, &CPU::op_subn_vx_vy, &CPU::op_shl_vx_vy, &CPU::op_sne_vx_vy, &CPU::op_ld_i_nnn,
+    &CPU::op_jp_v0_nnn, &CPU::op_rnd_vx_nn, &CPU::op_drw_vx_vy_n, &CPU::op_skp_vx, &CPU::op_sknp_vx,
+    &CPU::op_ld_vx_dt, &CPU::op_ld_vx_k, &CPU::op_ld_dt_vx, &CPU::op_ld_st_vx, &CPU::op_add_i_vx,
+    &CPU::op_ld_f_vx, &CPU::op_ld_b_vx, &CPU::op_ld_i_vx, &CPU::op_ld_vx_i,
+    &CPU::op_scd_n, &CPU::op_scr, &CPU::op_scl, &CPU::op_exit, &CPU::op_low,
+    &CPU::op_high, &CPU::op_drw_vx_vy_16, &CPU::op_ld_hf_vx, &CPU::op_ld_r_vx, &CPU::op_ld_vx_r,
+    &CPU::op_scu_n, &CPU::op_save_vx_vy, &CPU::op_load_vx_vy, &CPU::op_ld_i_long, &CPU::op_plane_n,
+    &CPU::op_audio, &CPU::op_pitch_vx
+};
+
+DecodedInstruction CPU::decode_instruction(uint16_t instruction, const DecodeTable& table) {
+    static_assert(sizeof(HANDLERS) / sizeof(HANDLERS[0]) == OP_COUNT, "Every operation needs a handler");
+
+    DecodedInstruction decoded;
+    decoded.operation = table[instruction];
+    decoded.handler = HANDLERS[decoded.operation];
+    decoded.x = (instruction & 0x0F00) >> 8;
+    decoded.y = (instruction & 0x00F0) >> 4;
+    decoded.n = (instruction & 0x000F);
+    decoded.nn = (instruction & 0x00FF);
+    decoded.nnn = (instruction & 0x0FFF);
+    decoded.fused = FUSED_NONE;
+    return decoded;
+}
+
+void CPU::op_nop(CPU&, const DecodedInstruction&, Display&, InputSource&) {}
+
+void CPU::op_cls(CPU&, const DecodedInstruction&, Display& display, InputSource&) {
+    display.clear_display();
+}
+
+void CPU::op_ret(CPU& cpu, const DecodedInstruction&, Display&, InputSource&) {
+    cpu.program_counter = cpu.pop_from_stack();
+}
+
+void CPU::op_jp(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.program_counter = d.nnn;
+}
+
+void CPU::op_call(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.push_to_stack(cpu.program_counter);
+    cpu.program_counter = d.nnn;
+}
+
+void CPU::op_se_vx_nn(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    if (cpu.registers[d.x] == d.nn) { cpu.skip_instruction(); }
+}
+
+void CPU::op_sne_vx_nn(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    if (cpu.registers[d.x] != d.nn) { cpu.skip_instruction(); }
+}
+
+void CPU::op_se_vx_vy(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    if (cpu.registers[d.x] == cpu.registers[d.y]) { cpu.skip_instruction(); }
+}
+
+void CPU::op_ld_vx_nn(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.registers[d.x] = d.nn;
+}
+
+void CPU::op_add_vx_nn(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.registers[d.x] += d.nn;
+}
+
+void CPU::op_ld_vx_vy(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.registers[d.x] = cpu.registers[d.y];
+}
+
+void CPU::op_and_vx_vy(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.registers[d.x] &= cpu.registers[d.y];
+}
+
+void CPU::op_xor_vx_vy(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.registers[d.x] ^= cpu.registers[d.y];
+}
+
+void CPU::op_add_vx_vy(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    uint16_t sum = (uint16_t) cpu.registers[d.x] + (uint16_t) cpu.registers[d.y];
+    cpu.registers[d.x] = (uint8_t) sum;
+    cpu.registers[FLAG_REGISTER] = sum > 255 ? 1 : 0;
+}
+
+void CPU::op_sub_vx_vy(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    // Clear the flag before comparing so VF operands behave exactly like execute_opcode
+    cpu.registers[FLAG_REGISTER] = 0;
+    if (cpu.registers[d.x] > cpu.registers[d.y]) { cpu.registers[FLAG_REGISTER] = 1; }
+    cpu.registers[d.x] = cpu.registers[d.x] - cpu.registers[d.y];
+}
+
+void CPU::op_shr_vx_vy(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    if (cpu.new_functionality) { cpu.registers[d.x] = cpu.registers[d.y]; }
+    cpu.registers[FLAG_REGISTER] = 0;
+    if ((cpu.registers[d.x] & 0x01) != 0) { cpu.registers[FLAG_REGISTER] = 1; }
+    cpu.registers[d.x] = cpu.registers[d.x] >> 1;
+}
+
+void CPU::op_subn_vx_vy(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.registers[FLAG_REGISTER] = 0;
+    if (cpu.registers[d.x] > cpu.registers[d.y]) { cpu.registers[FLAG_REGISTER] = 1; }
+    cpu.registers[d.x] = cpu.registers[d.y] - cpu.registers[d.x];
+}
+
+void CPU::op_shl_vx_vy(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    if (cpu.new_functionality) { cpu.registers[d.x] = cpu.registers[d.y]; }
+    cpu.registers[FLAG_REGISTER] = 0;
+    if ((cpu.registers[d.x] & 0x80) != 0) { cpu.registers[FLAG_REGISTER] = 1; }
+    cpu.registers[d.x] = cpu.registers[d.x] << 1;
+}
+
+void CPU::op_sne_vx_vy(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    if (cpu.registers[d.x] != cpu.registers[d.y]) { cpu.skip_instruction(); }
+}
+
+void CPU::op_ld_i_nnn(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.index_register = d.nnn;
+}
+
+void CPU::op_jp_v0_nnn(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.program_counter = d.nnn + cpu.registers[cpu.new_functionality ? d.x : 0];
+}
+
+void CPU::op_rnd_vx_nn(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.registers[d.x] = cpu.rng.next_byte() & d.nn;
+}
+
+void CPU::op_drw_vx_vy_n(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource&) {
+    uint8_t scratch[SPRITE_MAX_BYTES];
+    cpu.registers[FLAG_REGISTER] = display.draw_sprite(cpu.registers[d.x], cpu.registers[d.y], cpu.sprite_source(scratch), d.n);
+}
+
+void CPU::op_skp_vx(CPU& cpu, const DecodedInstruction& d, Display&, InputSource& input) {
+    if (input.is_pressed(cpu.registers[d.x])) { cpu.skip_instruction(); }
+}
+
+void CPU::op_sknp_vx(CPU& cpu, const DecodedInstruction& d, Display&, InputSource& input) {
+    if (!input.is_pressed(cpu.registers[d.x])) { cpu.skip_instruction(); }
+}
+
+void CPU::op_ld_vx_dt(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.registers[d.x] = cpu.delay_timer;
+}
+
+void CPU::op_ld_vx_k(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.paused = true;
+    cpu.paused_register = d.x;
+    cpu.program_counter -= 2;
+}
+
+void CPU::op_ld_dt_vx(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.delay_timer = cpu.registers[d.x];
+}
+
+void CPU::op_ld_st_vx(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.sound_timer = cpu.registers[d.x];
+}
+
+void CPU::op_add_i_vx(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    uint16_t sum = cpu.index_register + cpu.registers[d.x];
+    // SUPER-CHIP and XO-CHIP programs index tables well past 0xFF
+    cpu.index_register = cpu.variant == Chip8Variant::Chip8 ? (uint8_t) sum : sum;
+    cpu.registers[FLAG_REGISTER] = sum > 0xFFF ? 1 : 0;
+}
+
+void CPU::op_ld_f_vx(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.index_register = cpu.registers[d.x] * 5;
+}
+
+void CPU::op_ld_b_vx(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    uint8_t value = cpu.registers[d.x];
+    cpu.write_memory(cpu.index_register, value / 100);
+    cpu.write_memory(cpu.index_register + 1, (value % 100) / 10);
+    cpu.write_memory(cpu.index_register + 2, value % 10);
+}
+
+void CPU::op_ld_i_vx(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    for (int i = 0; i <= d.x; i++) {
+        cpu.write_memory(cpu.index_register + i, cpu.registers[i]);
+    }
+    if (!cpu.new_functionality) { cpu.index_register += d.x + 1; }
+}
+
+void CPU::op_ld_vx_i(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    for (int i = 0; i <= d.x; i++) {
+        cpu.registers[i] = cpu.read_memory(cpu.index_register + i);
+    }
+    if (!cpu.new_functionality) { cpu.index_register += d.x + 1; }
+}
+
+void CPU::op_scd_n(CPU&, const DecodedInstruction& d, Display& display, InputSource&) {
+    display.scroll_down(d.n);
+}
+
+void CPU::op_scr(CPU&, const DecodedInstruction&, Display& display, InputSource&) {
+    display.scroll_right();
+}
+
+void CPU::op_scl(CPU&, const DecodedInstruction&, Display& display, InputSource&) {
+    display.scroll_left();
+}
+
+void CPU::op_exit(CPU& cpu, const DecodedInstruction&, Display&, InputSource&) {
+    // The program asked to stop; this is not a fault
+    cpu.program_counter -= 2;
+    cpu.halted = true;
+}
+
+void CPU::op_low(CPU&, const DecodedInstruction&, Display& display, InputSource&) {
+    display.set_hires(false);
+}
+
+void CPU::op_high(CPU&, const DecodedInstruction&, Display& display, InputSource&) {
+    display.set_hires(true);
+}
+
+void CPU::op_drw_vx_vy_16(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource&) {
+    uint8_t scratch[SPRITE_MAX_BYTES];
+    cpu.registers[FLAG_REGISTER] = display.draw_large_sprite(cpu.registers[d.x], cpu.registers[d.y], cpu.sprite_source(scratch));
+}
+
+void CPU::op_ld_hf_vx(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.index_register = FONT_COUNT + (cpu.registers[d.x] & 0x0F) * 10;
+}
+
+void CPU::op_ld_r_vx(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    memcpy(cpu.rpl_flags, cpu.registers, d.x + 1);
+}
+
+void CPU::op_ld_vx_r(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    memcpy(cpu.registers, cpu.rpl_flags, d.x + 1);
+}
+
+void CPU::op_scu_n(CPU&, const DecodedInstruction& d, Display& display, InputSource&) {
+    display.scroll_up(d.n);
+}
+
+void CPU::op_save_vx_vy(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    // Registers X to Y, in either direction, without moving I
+    int step = d.x <= d.y ? 1 : -1;
+    int count = (d.x <= d.y ? d.y - d.x : d.x - d.y) + 1;
+    for (int i = 0; i < count; i++) {
+        cpu.write_memory(cpu.index_register + i, cpu.registers[d.x + i * step]);
+    }
+}
+
+void CPU::op_load_vx_vy(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    int step = d.x <= d.y ? 1 : -1;
+    int count = (d.x <= d.y ? d.y - d.x : d.x - d.y) + 1;
+    for (int i = 0; i < count; i++) {
+        cpu.registers[d.x + i * step] = cpu.read_memory(cpu.index_register + i);
+    }
+}
+
+void CPU::op_ld_i_long(CPU& cpu, const DecodedInstruction&, Display&, InputSource&) {
+    // The address is the instruction's second word
+    cpu.index_register = (cpu.read_memory(cpu.program_counter) << 8) | cpu.read_memory(cpu.program_counter + 1);
+    cpu.program_counter += 2;
+}
+
+void CPU::op_plane_n(CPU&, const DecodedInstruction& d, Display& display, InputSource&) {
+    display.set_plane_mask(d.x);
+}
+
+void CPU::op_audio(CPU& cpu, const DecodedInstruction&, Display&, InputSource&) {
+    for (int i = 0; i < AUDIO_PATTERN_SIZE; i++) {
+        cpu.audio_pattern[i] = cpu.read_memory(cpu.index_register + i);
+    }
+}
+
+void CPU::op_pitch_vx(CPU& cpu, const DecodedInstruction& d, Display&, InputSource&) {
+    cpu.audio_pitch = cpu.registers[d.x];
+}
+
+const FusedHandler CPU::FUSED_HANDLERS[] = {
+    nullptr, &CPU::fused_load_draw, &CPU::fused_index_draw, &CPU::fused_count_loop
+};
+
+const uint8_t CPU::FUSED_LENGTHS[] = {1, 3, 2, 3};
+
+FusedSequence CPU::match_fused(uint16_t address) const {
+    static_assert(sizeof(FUSED_HANDLERS) / sizeof(FUSED_HANDLERS[0]) == FUSED_COUNT, "Every fused sequence needs a handler");
+    static_assert(sizeof(FUSED_LENGTHS) / sizeof(FUSED_LENGTHS[0]) == FUSED_COUNT, "Every fused sequence needs a length");
+
+    // Sequences are only matched inside the cached first 4 KB, so invalidation covers them
+    auto operation_at = [this](int at) {
+        return at + 1 < CHIP8_MEMORY_SIZE ? (*decode_table)[(memory[at] << 8) | memory[at + 1]] : (uint8_t) OP_COUNT;
+    };
+    uint8_t first = operation_at(address);
+    uint8_t second = operation_at(address + 2);
+    if (first == OP_LD_I_NNN && second == OP_DRW_VX_VY_N) {
+        return FUSED_INDEX_DRAW;
+    }
+    uint8_t third = operation_at(address + 4);
+    if (first == OP_LD_VX_NN && second == OP_LD_VX_NN && third == OP_DRW_VX_VY_N) {
+        return FUSED_LOAD_DRAW;
+    }
+    if (first == OP_ADD_VX_NN && second == OP_SE_VX_NN && third == OP_JP) {
+        return FUSED_COUNT_LOOP;
+    }
+    return FUSED_NONE;
+}
+
+// Fused handlers do exactly what the instructions would one by one. Nothing in them writes
+// memory, pauses or faults, so no other instruction could observe the difference.
+
+int CPU::fused_load_draw(CPU& cpu, const DecodedInstruction& first, Display& display, InputSource& input) {
+    const uint8_t* next = &cpu.memory[cpu.program_counter];
+    cpu.registers[first.x] = first.nn;
+    cpu.registers[next[0] & 0x0F] = next[1];
+    DecodedInstruction draw = {};
+    draw.x = next[2] & 0x0F;
+    draw.y = next[3] >> 4;
+    draw.n = next[3] & 0x0F;
+    cpu.program_counter += 4;
+    op_drw_vx_vy_n(cpu, draw, display, input);
+    return 3;
+}
+
+int CPU::fused_index_draw(CPU& cpu, const DecodedInstruction& first, Display& display, InputSource& input) {
+    const uint8_t* next = &cpu.memory[cpu.program_counter];
+    cpu.index_register = first.nnn;
+    DecodedInstruction draw = {};
+    draw.x = next[0] & 0x0F;
+    draw.y = next[1] >> 4;
+    draw.n = next[1] & 0x0F;
+    cpu.program_counter += 2;
+    op_drw_vx_vy_n(cpu, draw, display, input);
+    return 2;
+}
+
+int CPU::fused_count_loop(CPU& cpu, const DecodedInstruction& first, Display&, InputSource&) {
+    const uint8_t* next = &cpu.memory[cpu.program_counter];
+    cpu.registers[first.x] += first.nn;
+    if (cpu.registers[next[0] & 0x0F] == next[1]) {
+        // The skip steps over the jump, which then never runs
+        cpu.program_counter += 4;
+        return 2;
+    }
+    cpu.program_counter = ((next[2] & 0x0F) << 8) | next[3];
+    return 3;
 }
@@ -2,20 +2,41 @@
 #define CPU_H
 
 #include <cstdint> // For uint8_t and uint16_t
-#include <iostream> // For std::cout in error messages (though consider removing in final build)
+#include "opcodes.h"
+#include "rng.h"
 
 // Forward declarations to avoid circular dependencies if Display/Input also include CPU.h
+class CPU;
 class Display;
-class Input;
+class InputSource;
+class Jit;
 
 // Constants are usually defined globally or as static const members within the class
 // For a header, it's common to define them here if they're used by other parts of the system.
-const int MEMORY_COUNT = 4096;
+const int MEMORY_COUNT = 65536;      // Backing store; all of it is addressable on XO-CHIP
+const int CHIP8_MEMORY_SIZE = 4096;  // Addressable memory on CHIP-8 and SUPER-CHIP
 const int STACK_COUNT = 16;
 const int REGISTER_COUNT = 16;
 const int FLAG_REGISTER = REGISTER_COUNT - 1; // VF register
 const int FONT_COUNT = 80;
+const int BIG_FONT_COUNT = 160;              // SUPER-CHIP 8x10 digits, stored right after the small font
+const int RPL_FLAG_COUNT = 16;               // FX75/FX85 user flags (SUPER-CHIP only uses 8)
+const int AUDIO_PATTERN_SIZE = 16;           // XO-CHIP F002 pattern buffer, 128 one-bit samples
+const int DEFAULT_AUDIO_PITCH = 64;          // FX3A value for 4000Hz playback
 const int PROGRAM_BUFFER = 0x200;
+const int SPRITE_MAX_BYTES = 64;             // Largest sprite read: DXY0 into both XO-CHIP planes
+
+// Size of the CPU part of a savestate: 112 bytes of registers, timers, flags, stack, RNG state
+// and SUPER-CHIP / XO-CHIP registers (little-endian, see CPU::save_state) followed by the
+// variant's memory image, at most the full backing store
+const int CPU_STATE_HEADER_SIZE = 112;
+const int CPU_STATE_MAX_SIZE = CPU_STATE_HEADER_SIZE + MEMORY_COUNT;
+
+// Longest wait loop, in instructions, that CPU::probe_idle_loop recognises
+const int IDLE_LOOP_MAX_LENGTH = 8;
+
+// Longest sequence, in instructions, that the decoded instruction cache fuses into one entry
+const int FUSED_MAX_LENGTH = 3;
 
 // Chip-8 font sprites
 const uint8_t CHIP8_FONT[] = {
@@ -37,6 +58,108 @@ const uint8_t CHIP8_FONT[] = {
     0xF0, 0x80, 0xF0, 0x80, 0x80  // F
 };
 
+// SUPER-CHIP big font sprites (FX30)
+const uint8_t CHIP8_BIG_FONT[] = {
+    0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, // 0
+    0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF, // 1
+    0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // 2
+    0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 3
+    0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03, // 4
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 5
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 6
+    0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18, // 7
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 8
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 9
+    0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+    0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, // B
+    0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, // C
+    0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // E
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  // F
+};
+
+// Hot instruction sequences the cached interpreter runs as one superinstruction. The cache
+// entry for the first instruction records the match; the rest are read from memory.
+enum FusedSequence : uint8_t {
+    FUSED_NONE,
+    FUSED_LOAD_DRAW,  // 6XNN 6YNN DXYN: position a sprite and draw it
+    FUSED_INDEX_DRAW, // ANNN DXYN: point I at a sprite and draw it
+    FUSED_COUNT_LOOP, // 7XNN 3XNN 1NNN: step a counter and jump back until it reaches a limit
+    FUSED_COUNT
+};
+
+// An instruction that has already been decoded: the handler to run plus its operands
+struct DecodedInstruction;
+typedef void (*InstructionHandler)(CPU& cpu, const DecodedInstruction& decoded, Display& display, InputSource& input);
+
+// Runs a whole fused sequence starting from the decoded first instruction (the program
+// counter already past it) and returns how many instructions that was
+typedef int (*FusedHandler)(CPU& cpu, const DecodedInstruction& first, Display& display, InputSource& input);
+
+struct DecodedInstruction {
+    InstructionHandler handler; // nullptr while the cache entry is empty
+    uint16_t nnn;
+    uint8_t x;
+    uint8_t y;
+    uint8_t n;
+    uint8_t nn;
+    uint8_t operation; // Operation from opcodes.h
+    uint8_t fused;     // FusedSequence starting here; handler still runs just this instruction
+};
+
+// Problems the CPU can run into. Only the first fault is kept.
+enum class CpuFault {
+    None,
+    StackOverflow,   // 2NNN with a full stack (the call is skipped)
+    StackUnderflow,  // 00EE with an empty stack (returns to 0x000)
+    PcOutOfBounds,   // Instruction fetch past the end of addressable memory (halts the CPU)
+    ProgramTooLarge  // load_program given more bytes than fit (halts the CPU)
+};
+
+// Short name for a fault, for reports
+const char* fault_name(CpuFault fault);
+
+// Called for every fault as it happens (not only the first), with the address of the
+// instruction involved (PROGRAM_BUFFER for ProgramTooLarge). The CPU itself never prints
+// anything, so this is how a host hears about faults other than through get_fault().
+typedef void (*FaultCallback)(void* context, CpuFault fault, uint16_t address);
+
+// How emulate_cycle turns memory into work
+enum class DispatchMode {
+    Switch,  // Fetch and run the raw opcode through execute_opcode every cycle
+    Cached,  // Run handlers from the per-address decoded instruction cache
+    Threaded // Look operations up in the compile-time decode table and dispatch with computed goto
+};
+
+// In-memory copy of the CPU state for run-ahead and other frequent round trips. Unlike
+// save_state() nothing is serialised and only the variant's memory is copied.
+struct CpuSnapshot {
+    uint8_t registers[REGISTER_COUNT];
+    uint16_t program_counter;
+    uint16_t index_register;
+    bool paused;
+    uint8_t paused_register;
+    bool halted;
+    CpuFault fault;
+    uint8_t delay_timer;
+    uint8_t sound_timer;
+    uint8_t stack_pointer;
+    uint16_t stack[STACK_COUNT];
+    uint8_t rpl_flags[RPL_FLAG_COUNT];
+    uint8_t audio_pattern[AUDIO_PATTERN_SIZE];
+    uint8_t audio_pitch;
+    uint64_t rng_state;
+    uint8_t memory[MEMORY_COUNT]; // First memory_size bytes are valid
+};
+
+// Debugger policy for CPU::run_cycles_with(): stop() is asked before each instruction runs,
+// and returning true ends the run with that instruction not executed. This policy never
+// stops, so the run_cycles() built on it compiles to the plain loop with no checks at all.
+// Debugger (debugger.h) is the policy with breakpoints and watchpoints.
+struct NoDebugger {
+    bool stop(const CPU&, const Display&) { return false; }
+};
+
 class CPU {
 private:
     uint8_t registers[REGISTER_COUNT];
@@ -44,7 +167,10 @@ private:
     uint16_t index_register;
     bool paused;
     uint8_t paused_register; // Stores the register to load key into after pause
+    bool halted;             // Set by fatal faults; nothing runs until initialize_cpu()
+    CpuFault fault;
     uint8_t memory[MEMORY_COUNT];
+    int memory_size; // Addressable bytes for the variant (a power of two)
 
     // Timers
     uint8_t delay_timer;
@@ -54,6 +180,30 @@ private:
     uint8_t stack_pointer;
     uint16_t stack[STACK_COUNT];
 
+    // SUPER-CHIP / XO-CHIP registers
+    uint8_t rpl_flags[RPL_FLAG_COUNT];
+    uint8_t audio_pattern[AUDIO_PATTERN_SIZE];
+    uint8_t audio_pitch;
+
+    // Decoded instruction for every address in the first 4 KB, filled lazily and dropped when
+    // memory is written. XO-CHIP code above that is decoded on every visit.
+    DecodedInstruction decode_cache[CHIP8_MEMORY_SIZE];
+    DecodedInstruction uncached_decoded;
+    DispatchMode dispatch_mode;
+    bool fusion; // Run fused sequences as one step in run_cycles()
+    Chip8Variant variant;
+    const DecodeTable* decode_table; // Table for the variant
+    bool new_functionality; // CHIP-48 behaviour for 8XY6/8XYE/BNNN/FX55/FX65
+    Jit* jit;               // Recompiler to notify about memory writes, if one is attached
+    FaultCallback fault_callback;
+    void* fault_context;
+    Rng rng;                // Source for CXNN
+
+    // The recompiler reads operands and emits code against the register file directly
+    friend class Jit;
+    // The lockstep engine keeps the hot state of many CPUs in its own SIMD-friendly arrays
+    friend class LockstepEngine;
+
     // Private helper methods (these are typically not exposed)
     void clear_memory();
     void clear_stack();
@@ -62,6 +212,84 @@ private:
     uint16_t pop_from_stack();
     void load_font();
     uint16_t fetch_opcode();
+    const DecodedInstruction& fetch_decoded();
+    void write_memory(uint16_t address, uint8_t value);
+    void restore_memory(const uint8_t* image, int size);
+    void invalidate_decoded(uint16_t address);
+    FusedSequence match_fused(uint16_t address) const;
+    void clear_decode_cache();
+    void raise_fault(CpuFault new_fault, uint16_t address);
+    const uint8_t* sprite_source(uint8_t* scratch) const;
+
+    // Skip the next instruction. On XO-CHIP that may be the four-byte F000 NNNN.
+    void skip_instruction() {
+        if (variant == Chip8Variant::XoChip && memory[program_counter] == 0xF0 &&
+            memory[(program_counter + 1) & (MEMORY_COUNT - 1)] == 0x00) {
+            program_counter += 2;
+        }
+        program_counter += 2;
+    }
+
+    // Instruction handlers used by the decoded instruction cache
+    static void op_nop(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_cls(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ret(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_jp(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_call(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_se_vx_nn(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_sne_vx_nn(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_se_vx_vy(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ld_vx_nn(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_add_vx_nn(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ld_vx_vy(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_and_vx_vy(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_xor_vx_vy(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_add_vx_vy(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_sub_vx_vy(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_shr_vx_vy(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_subn_vx_vy(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_shl_vx_vy(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_sne_vx_vy(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ld_i_nnn(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_jp_v0_nnn(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_rnd_vx_nn(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_drw_vx_vy_n(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_skp_vx(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_sknp_vx(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ld_vx_dt(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ld_vx_k(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ld_dt_vx(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ld_st_vx(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_add_i_vx(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ld_f_vx(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ld_b_vx(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ld_i_vx(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ld_vx_i(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_scd_n(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_scr(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_scl(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_exit(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_low(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_high(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_drw_vx_vy_16(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ld_hf_vx(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ld_r_vx(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ld_vx_r(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_scu_n(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_save_vx_vy(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_load_vx_vy(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_ld_i_long(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_plane_n(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_audio(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static void op_pitch_vx(CPU& cpu, const DecodedInstruction& d, Display& display, InputSource& input);
+    static const InstructionHandler HANDLERS[];
+
+    // Superinstructions for FusedSequence, and how many instructions each may run at most
+    static int fused_load_draw(CPU& cpu, const DecodedInstruction& first, Display& display, InputSource& input);
+    static int fused_index_draw(CPU& cpu, const DecodedInstruction& first, Display& display, InputSource& input);
+    static int fused_count_loop(CPU& cpu, const DecodedInstruction& first, Display& display, InputSource& input);
+    static const FusedHandler FUSED_HANDLERS[];
+    static const uint8_t FUSED_LENGTHS[];
 
 public:
     // Constructor
@@ -71,11 +299,94 @@ public:
     void initialize_cpu();
     bool is_paused() const;
     void unpause();
-    void load_program(uint8_t program[], int size);
-    void execute_opcode(uint16_t instruction, Display& display, Input& input, bool new_functionality = false);
-    void emulate_cycle(Display& display, Input& input);
+    bool is_halted() const;
+    CpuFault get_fault() const;
+    void set_fault_callback(FaultCallback callback, void* context);
+    void load_program(const uint8_t program[], int size);
+    void execute_opcode(uint16_t instruction, Display& display, InputSource& input, bool new_functionality = false);
+    void emulate_cycle(Display& display, InputSource& input);
+
+    // Run up to max_cycles instructions back to back, stopping early if FX0A pauses the CPU.
+    // Returns the number of instructions executed. In cached mode, fused sequences run as one
+    // step when all of them fit in the cycles left, so the count is still exact.
+    int run_cycles(Display& display, InputSource& input, int max_cycles);
+
+    // run_cycles() consulting a debugger policy (see NoDebugger) before every instruction.
+    // Instantiated for NoDebugger and Debugger.
+    template <typename DebugPolicy>
+    int run_cycles_with(Display& display, InputSource& input, int max_cycles, DebugPolicy& debugger);
+
+    // Check whether the CPU is spinning in a wait loop (e.g. FX07/3XNN/1NNN on the delay timer,
+    // or a 1NNN jumping to itself) by running it for up to two iterations. A loop made only of
+    // instructions that read registers, I, memory, timers and keys, and that comes back to the
+    // same registers and I, will repeat exactly until a timer ticks or the keys change.
+    // Returns the loop length in instructions, or 0 if the code is not such a loop. The probe
+    // instructions really execute; their count is stored in executed (at most max_cycles).
+    int probe_idle_loop(Display& display, InputSource& input, int max_cycles, int& executed);
     void decrement_timers();
     void set_register_after_key_press(uint8_t key_pressed);
+
+    // Read-only views of the architectural state
+    uint16_t get_program_counter() const;
+    uint16_t get_index_register() const;
+    uint8_t get_register(uint8_t index) const;
+    uint8_t get_stack_pointer() const;
+    void copy_registers(uint8_t out[REGISTER_COUNT]) const; // V0-VF
+    uint8_t get_delay_timer() const;
+    uint8_t get_sound_timer() const;
+    uint8_t read_memory(uint16_t address) const;
+
+    // Select between the raw switch interpreter and the decoded instruction cache
+    void set_dispatch_mode(DispatchMode mode);
+    DispatchMode get_dispatch_mode() const;
+
+    // Superinstruction fusion for cached dispatch (on by default). Only run_cycles() without a
+    // debugger uses it, and not in profiling builds; emulate_cycle() always runs one instruction.
+    void set_fusion(bool enabled);
+    bool get_fusion() const;
+
+    // Enable CHIP-48 behaviour for the shift, BNNN and FX55/FX65 instructions
+    void set_new_functionality(bool enabled);
+    bool get_new_functionality() const;
+
+    // Select the instruction set (CHIP-8 by default). This sets the addressable memory,
+    // loads the SUPER-CHIP big font (or clears it again) and drops decoded instructions, so
+    // call it before loading a program. Only CHIP-8 can be recompiled or run in lockstep.
+    void set_variant(Chip8Variant new_variant);
+    Chip8Variant get_variant() const;
+
+    // XO-CHIP audio: the F002 pattern buffer (AUDIO_PATTERN_SIZE bytes, first sample in bit 7
+    // of byte 0) and the FX3A pitch. Playback rate is 4000 * 2^((pitch - 64) / 48) Hz.
+    const uint8_t* get_audio_pattern() const;
+    uint8_t get_audio_pitch() const;
+
+    // Restart the CXNN random sequence from a seed
+    void seed_random(uint64_t seed);
+
+    // Attach (or detach with nullptr) a recompiler whose blocks must follow memory writes
+    void attach_jit(Jit* recompiler);
+
+    // Serialize / restore the architectural state (registers, timers, stack, pause and fault
+    // flags, RNG, RPL flags, audio pattern and pitch, memory) as CPU_STATE_HEADER_SIZE bytes
+    // followed by the variant's memory (4 KB, or 64 KB on XO-CHIP), so a state must be loaded
+    // into a CPU running the variant that saved it. Restoring only rewrites memory bytes that
+    // differ, so decoded instructions and compiled blocks elsewhere in memory stay valid.
+    // Configuration (dispatch mode, quirks, variant) is not part of the state. load_state
+    // returns false, changing nothing, if the recorded fault is not one this CPU knows.
+    void save_state(uint8_t* out) const;
+    bool load_state(const uint8_t* in);
+
+    // Capture / restore the same state as save_state() and load_state() much more cheaply.
+    // Restoring compares memory in blocks and only rewrites the bytes that differ. A snapshot
+    // must be restored into a CPU running the same variant.
+    void save_snapshot(CpuSnapshot& snapshot) const;
+    void load_snapshot(const CpuSnapshot& snapshot);
+
+    // Compare the complete architectural state (registers, timers, stack, RNG, memory) with another CPU
+    bool same_state(const CPU& other) const;
+
+    // Split a raw instruction into its handler and operands
+    static DecodedInstruction decode_instruction(uint16_t instruction, const DecodeTable& table = DECODE_TABLE);
 };
 
 #endif // CPU_H
@@ -0,0 +1,183 @@
+#include "debugger.h"
+#include "display.h"
+
+#include <cstring> // For memset
+
+const char* debug_stop_name(DebugStop stop) {
+    switch (stop) {
+        case DebugStop::None: return "none";
+        case DebugStop::Breakpoint: return "breakpoint";
+        case DebugStop::MemoryRead: return "memory_read";
+        case DebugStop::MemoryWrite: return "memory_write";
+        case DebugStop::IndexRead: return "index_read";
+        case DebugStop::IndexWrite: return "index_write";
+        case DebugStop::Step: return "step";
+        case DebugStop::Frame: return "frame";
+        case DebugStop::Halted: return "halted";
+    }
+    return "unknown";
+}
+
+InstructionAccess next_instruction_access(const CPU& cpu, const Display& display) {
+    InstructionAccess access = {};
+    Chip8Variant variant = cpu.get_variant();
+    uint16_t memory_mask = variant == Chip8Variant::XoChip ? MEMORY_COUNT - 1 : CHIP8_MEMORY_SIZE - 1;
+    uint16_t pc = cpu.get_program_counter();
+    if (pc + 1 > memory_mask) {
+        return access; // The fetch faults before anything else happens
+    }
+
+    uint16_t instruction = (cpu.read_memory(pc) << 8) | cpu.read_memory(pc + 1);
+    uint8_t x = (instruction & 0x0F00) >> 8;
+    uint8_t y = (instruction & 0x00F0) >> 4;
+    uint16_t index = cpu.get_index_register();
+    auto reads = [&](int count) {
+        access.read_address = index;
+        access.read_count = count;
+        access.read_mask = memory_mask;
+        access.reads_index = true;
+    };
+    auto writes = [&](int count) {
+        access.write_address = index;
+        access.write_count = count;
+        access.write_mask = memory_mask;
+        access.reads_index = true;
+    };
+
+    // Each selected XO-CHIP plane takes its own copy of the sprite
+    uint8_t plane_mask = display.get_plane_mask();
+    int planes = (plane_mask & 1) + ((plane_mask >> 1) & 1);
+    switch (decode_operation(instruction, variant)) {
+        case OP_DRW_VX_VY_N: reads((instruction & 0x000F) * planes); break;
+        case OP_DRW_VX_VY_16: reads(32 * planes); break;
+        case OP_LD_VX_I:
+            reads(x + 1);
+            access.writes_index = !cpu.get_new_functionality();
+            break;
+        case OP_LD_I_VX:
+            writes(x + 1);
+            access.writes_index = !cpu.get_new_functionality();
+            break;
+        case OP_LD_B_VX: writes(3); break;
+        case OP_SAVE_VX_VY: writes((x <= y ? y - x : x - y) + 1); break;
+        case OP_LOAD_VX_VY: reads((x <= y ? y - x : x - y) + 1); break;
+        case OP_AUDIO: reads(AUDIO_PATTERN_SIZE); break;
+        case OP_ADD_I_VX:
+            access.reads_index = true;
+            access.writes_index = true;
+            break;
+        case OP_LD_I_NNN: case OP_LD_F_VX: case OP_LD_HF_VX: case OP_LD_I_LONG:
+            access.writes_index = true;
+            break;
+        default:
+            break;
+    }
+    return access;
+}
+
+Debugger::Debugger() {
+    clear();
+    hit = DebugStop::None;
+    hit_address = 0;
+    skip_armed = false;
+    skip_pc = 0;
+}
+
+void Debugger::set_breakpoint(uint16_t address, bool enabled) {
+    if (enabled) {
+        flags[address] |= DEBUG_BREAK;
+    } else {
+        flags[address] &= ~DEBUG_BREAK;
+    }
+}
+
+bool Debugger::has_breakpoint(uint16_t address) const { return flags[address] & DEBUG_BREAK; }
+
+void Debugger::watch_memory(uint16_t address, int length, bool on_read, bool on_write) {
+    uint8_t watch = (on_read ? DEBUG_WATCH_READ : 0) | (on_write ? DEBUG_WATCH_WRITE : 0);
+    for (int i = 0; i < length && i < MEMORY_COUNT; i++) {
+        uint8_t& flag = flags[(address + i) & (MEMORY_COUNT - 1)];
+        bool was_watched = flag & (DEBUG_WATCH_READ | DEBUG_WATCH_WRITE);
+        flag |= watch;
+        watched_bytes += !was_watched && watch != 0;
+    }
+}
+
+void Debugger::unwatch_memory(uint16_t address, int length) {
+    for (int i = 0; i < length && i < MEMORY_COUNT; i++) {
+        uint8_t& flag = flags[(address + i) & (MEMORY_COUNT - 1)];
+        watched_bytes -= (flag & (DEBUG_WATCH_READ | DEBUG_WATCH_WRITE)) != 0;
+        flag &= ~(DEBUG_WATCH_READ | DEBUG_WATCH_WRITE);
+    }
+}
+
+void Debugger::watch_index(bool on_read, bool on_write) {
+    watch_index_read = on_read;
+    watch_index_write = on_write;
+}
+
+void Debugger::clear() {
+    memset(flags, 0, sizeof(flags));
+    watched_bytes = 0;
+    watch_index_read = false;
+    watch_index_write = false;
+}
+
+bool Debugger::watched(uint16_t address, int count, uint16_t mask, uint8_t flag, uint16_t& found) const {
+    for (int i = 0; i < count; i++) {
+        uint16_t byte = (address + i) & mask;
+        if (flags[byte] & flag) {
+            found = byte;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Debugger::report(DebugStop reason, uint16_t address, uint16_t pc) {
+    hit = reason;
+    hit_address = address;
+    skip_armed = true;
+    skip_pc = pc;
+    return true;
+}
+
+bool Debugger::stop(const CPU& cpu, const Display& display) {
+    uint16_t pc = cpu.get_program_counter();
+    if (skip_armed) {
+        skip_armed = false;
+        if (pc == skip_pc && hit == DebugStop::None) {
+            return false;
+        }
+    }
+
+    if (flags[pc] & DEBUG_BREAK) {
+        return report(DebugStop::Breakpoint, pc, pc);
+    }
+    if (watched_bytes == 0 && !watch_index_read && !watch_index_write) {
+        return false;
+    }
+
+    InstructionAccess access = next_instruction_access(cpu, display);
+    uint16_t found = 0;
+    if (watched_bytes > 0) {
+        if (watched(access.read_address, access.read_count, access.read_mask, DEBUG_WATCH_READ, found)) {
+            return report(DebugStop::MemoryRead, found, pc);
+        }
+        if (watched(access.write_address, access.write_count, access.write_mask, DEBUG_WATCH_WRITE, found)) {
+            return report(DebugStop::MemoryWrite, found, pc);
+        }
+    }
+    if (watch_index_read && access.reads_index) {
+        return report(DebugStop::IndexRead, pc, pc);
+    }
+    if (watch_index_write && access.writes_index) {
+        return report(DebugStop::IndexWrite, pc, pc);
+    }
+    return false;
+}
+
+void Debugger::resume() { hit = DebugStop::None; }
+
+DebugStop Debugger::get_stop() const { return hit; }
+uint16_t Debugger::get_stop_address() const { return hit_address; }
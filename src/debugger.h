@@ -0,0 +1,89 @@
+#ifndef DEBUGGER_H
+#define DEBUGGER_H
+
+#include <cstdint> // For uint8_t and uint16_t
+#include "cpu.h"
+
+// Why a debugged run (see Machine::debug_step / debug_run) came back
+enum class DebugStop {
+    None,
+    Breakpoint,  // The PC reached a breakpoint; the instruction there has not run yet
+    MemoryRead,  // The next instruction reads a watched byte
+    MemoryWrite, // The next instruction writes a watched byte
+    IndexRead,   // The next instruction uses I as an address or operand
+    IndexWrite,  // The next instruction changes I
+    Step,        // The requested instruction ran
+    Frame,       // The requested frames completed
+    Halted       // The CPU halted (fault or 00FD)
+};
+
+// Short name for a stop reason, for reports
+const char* debug_stop_name(DebugStop stop);
+
+// The data an instruction touches besides its own fetch. Memory ranges wrap with the given
+// mask, the way the CPU addresses them.
+struct InstructionAccess {
+    uint16_t read_address;
+    int read_count;
+    uint16_t read_mask;
+    uint16_t write_address;
+    int write_count;
+    uint16_t write_mask;
+    bool reads_index;
+    bool writes_index;
+};
+
+// What the instruction at the CPU's PC will access if it runs now
+InstructionAccess next_instruction_access(const CPU& cpu, const Display& display);
+
+// Per-address debugger flags
+const uint8_t DEBUG_BREAK = 0x01;
+const uint8_t DEBUG_WATCH_READ = 0x02;
+const uint8_t DEBUG_WATCH_WRITE = 0x04;
+
+// Breakpoints on the PC and read / write watchpoints on memory and I, checked before every
+// instruction as the policy of CPU::run_cycles_with(). Only debugged runs pay for the checks;
+// everything else runs the NoDebugger instantiation.
+class Debugger {
+public:
+    Debugger();
+
+    void set_breakpoint(uint16_t address, bool enabled = true);
+    bool has_breakpoint(uint16_t address) const;
+
+    // Watch length bytes from address (wrapping at the top of memory) for reads, writes or both
+    void watch_memory(uint16_t address, int length, bool on_read, bool on_write);
+    void unwatch_memory(uint16_t address, int length);
+    void watch_index(bool on_read, bool on_write);
+
+    // Remove every breakpoint and watchpoint
+    void clear();
+
+    // Policy hook: true if the instruction at the PC hits a breakpoint or watchpoint. After a
+    // stop, the first check of the next run lets the instruction it stopped at through, so
+    // resuming does not stop on the same hit again.
+    bool stop(const CPU& cpu, const Display& display);
+
+    // Forget the last hit before a new run (called by Machine)
+    void resume();
+
+    // The last hit: its reason and the PC (breakpoints, I watches) or watched byte
+    DebugStop get_stop() const;
+    uint16_t get_stop_address() const;
+
+private:
+    uint8_t flags[MEMORY_COUNT]; // DEBUG_* bits per address
+    int watched_bytes;           // Addresses with a read or write watch
+    bool watch_index_read;
+    bool watch_index_write;
+
+    DebugStop hit;
+    uint16_t hit_address;
+    bool skip_armed; // The next check may be the instruction that just stopped
+    uint16_t skip_pc;
+
+    bool watched(uint16_t address, int count, uint16_t mask, uint8_t flag, uint16_t& found) const;
+    bool report(DebugStop reason, uint16_t address, uint16_t pc);
+};
+
+#endif // DEBUGGER_H
@@ -1,10 +1,36 @@
 #include "display.h"
+#include "profile.h"
+#include <cstring> // For memset, memmove and memcmp
 
 Display::Display() {
-    clear_display();
+    memset(planes, 0, sizeof(planes));
+    hires = false;
+    plane_mask = 1;
+    mark_all_dirty();
 }
 
-const bool (&Display::get_display() const)[DISPLAY_HEIGHT][DISPLAY_WIDTH] { return display; }
+int Display::get_width() const { return hires ? DISPLAY_HIRES_WIDTH : DISPLAY_WIDTH; }
+int Display::get_height() const { return hires ? DISPLAY_HIRES_HEIGHT : DISPLAY_HEIGHT; }
+bool Display::is_hires() const { return hires; }
+
+const uint64_t* Display::get_row(int plane, int y) const { return planes[plane][y]; }
+
+uint8_t Display::get_pixel(int x, int y) const {
+    uint8_t colour = 0;
+    for (int plane = 0; plane < DISPLAY_PLANES; plane++) {
+        uint64_t word = planes[plane][y][x >> 6];
+        colour |= ((word >> (63 - (x & 63))) & 1) << plane;
+    }
+    return colour;
+}
+
+void Display::unpack(uint8_t pixels[DISPLAY_HIRES_HEIGHT][DISPLAY_HIRES_WIDTH]) const {
+    for (int i = 0; i < get_height(); i++) {
+        for (int j = 0; j < get_width(); j++) {
+            pixels[i][j] = get_pixel(j, i);
+        }
+    }
+}
 
 bool Display::need_to_redraw() const { return redraw; }
 
@@ -12,58 +38,231 @@ void Display::reset_redraw_flag() { redraw = false; };
 
 void Display::set_redraw_flag() { redraw = true; }
 
+uint64_t Display::get_dirty_rows() const { return dirty_rows; }
+
+void Display::clear_dirty_rows() { dirty_rows = 0; }
+
+void Display::mark_all_dirty() {
+    dirty_rows = ~0ULL >> (64 - get_height());
+    redraw = true;
+}
+
+void Display::save_state(uint8_t* out) const {
+    const uint64_t* words = &planes[0][0][0];
+    const int word_count = DISPLAY_PLANES * DISPLAY_HIRES_HEIGHT * DISPLAY_ROW_WORDS;
+    for (int i = 0; i < word_count; i++) {
+        for (int b = 0; b < 8; b++) {
+            out[i * 8 + b] = (words[i] >> (b * 8)) & 0xFF;
+        }
+    }
+    memset(out + word_count * 8, 0, 8);
+    out[word_count * 8] = hires ? 1 : 0;
+    out[word_count * 8 + 1] = plane_mask;
+}
+
+void Display::load_state(const uint8_t* in) {
+    const int row_bytes = DISPLAY_ROW_WORDS * 8;
+    const int settings = DISPLAY_PLANES * DISPLAY_HIRES_HEIGHT * row_bytes;
+    bool new_hires = in[settings] != 0;
+    plane_mask = in[settings + 1] & 0x03;
+    if (new_hires != hires) {
+        hires = new_hires;
+        mark_all_dirty();
+        redraw = true;
+    }
+
+    for (int plane = 0; plane < DISPLAY_PLANES; plane++) {
+        for (int i = 0; i < DISPLAY_HIRES_HEIGHT; i++) {
+            const uint8_t* source = in + (plane * DISPLAY_HIRES_HEIGHT + i) * row_bytes;
+            bool changed = false;
+            for (int w = 0; w < DISPLAY_ROW_WORDS; w++) {
+                uint64_t word = 0;
+                for (int b = 0; b < 8; b++) {
+                    word |= (uint64_t) source[w * 8 + b] << (b * 8);
+                }
+                if (word != planes[plane][i][w]) {
+                    planes[plane][i][w] = word;
+                    changed = true;
+                }
+            }
+            if (changed) {
+                dirty_rows |= 1ULL << i;
+                redraw = true;
+            }
+        }
+    }
+}
+
+bool Display::same_state(const Display& other) const {
+    return hires == other.hires && plane_mask == other.plane_mask &&
+           memcmp(planes, other.planes, sizeof(planes)) == 0;
+}
+
+void Display::set_hires(bool enabled) {
+    hires = enabled;
+    memset(planes, 0, sizeof(planes));
+    mark_all_dirty();
+}
+
+void Display::set_plane_mask(uint8_t mask) { plane_mask = mask & 0x03; }
+uint8_t Display::get_plane_mask() const { return plane_mask; }
+
 void Display::clear_display() {
-    // Set all booleans within display to False
-    for (int i = 0; i < DISPLAY_HEIGHT; i++) {
-        for (int j = 0; j < DISPLAY_WIDTH; j++) {
-            display[i][j] = false;
+    // Turn every row of the selected planes off
+    for (int plane = 0; plane < DISPLAY_PLANES; plane++) {
+        if (plane_mask & (1 << plane)) {
+            memset(planes[plane], 0, sizeof(planes[plane]));
         }
     }
-    redraw = true;
+    mark_all_dirty();
 }
 
-bool Display::draw_sprite(uint8_t x, uint8_t y, uint8_t* sprite_data, uint8_t num_bytes) {
-    bool flipped_pixel_off = false;
-    // Ensure initial coordinates wrap around the screen
-    x = x & (DISPLAY_WIDTH - 1);
-    y = y & (DISPLAY_HEIGHT - 1);
+// Rows move as whole blocks of words; nothing is shifted bit by bit
 
-    // Iterate through all rows for sprite
-    for (int row_idx = 0; row_idx < num_bytes; row_idx++) {
-        uint8_t current_y = y + row_idx;
-        // Get sprite byte from memory
-        uint8_t sprite_byte = sprite_data[row_idx];
+void Display::scroll_down(int count) {
+    int height = get_height();
+    if (count > height) { count = height; }
+    for (int plane = 0; plane < DISPLAY_PLANES; plane++) {
+        if (plane_mask & (1 << plane)) {
+            memmove(planes[plane][count], planes[plane][0], (height - count) * sizeof(planes[plane][0]));
+            memset(planes[plane][0], 0, count * sizeof(planes[plane][0]));
+        }
+    }
+    mark_all_dirty();
+}
 
-        // Break out of loop if hit edge of screen
-        if (current_y >= DISPLAY_HEIGHT) {
-            break;
+void Display::scroll_up(int count) {
+    int height = get_height();
+    if (count > height) { count = height; }
+    for (int plane = 0; plane < DISPLAY_PLANES; plane++) {
+        if (plane_mask & (1 << plane)) {
+            memmove(planes[plane][0], planes[plane][count], (height - count) * sizeof(planes[plane][0]));
+            memset(planes[plane][height - count], 0, count * sizeof(planes[plane][0]));
         }
+    }
+    mark_all_dirty();
+}
 
-        // Iterate through all columns within the current row
-        uint8_t current_x = x;
-        for (int j = 0; j < 8; j++) {
-            // Break out of loop if hit edge of screen
-            if (current_x >= DISPLAY_WIDTH) {
-                break;
+void Display::scroll_right() {
+    // A row is one 64-bit word in lo-res and a two-word (128-bit) value in hi-res
+    const int shift = DISPLAY_SCROLL_PIXELS;
+    for (int plane = 0; plane < DISPLAY_PLANES; plane++) {
+        if ((plane_mask & (1 << plane)) == 0) {
+            continue;
+        }
+        for (int i = 0; i < get_height(); i++) {
+            uint64_t* row = planes[plane][i];
+            if (hires) {
+                row[1] = (row[1] >> shift) | (row[0] << (64 - shift));
             }
+            row[0] >>= shift;
+        }
+    }
+    mark_all_dirty();
+}
 
-            // Get if sprite pixel should be on or off
-            bool sprite_bit = ((sprite_byte >> (7 - j)) & 1) == 1;
-
-            if (sprite_bit) {
-                // If the sprite pixel is on, and the display is currently on. Turn off pixel and set flag register
-                if (display[current_y][current_x]) {
-                    display[current_y][current_x] = false;
-                    flipped_pixel_off = true;
-                } else {
-                    // Turn on display pixel
-                    display[current_y][current_x] = true;
-                }
+void Display::scroll_left() {
+    const int shift = DISPLAY_SCROLL_PIXELS;
+    for (int plane = 0; plane < DISPLAY_PLANES; plane++) {
+        if ((plane_mask & (1 << plane)) == 0) {
+            continue;
+        }
+        for (int i = 0; i < get_height(); i++) {
+            uint64_t* row = planes[plane][i];
+            if (hires) {
+                row[0] = (row[0] << shift) | (row[1] >> (64 - shift));
+                row[1] <<= shift;
+            } else {
+                row[0] <<= shift;
             }
-            current_x += 1;
         }
     }
+    mark_all_dirty();
+}
+
+bool Display::draw_sprite(uint8_t x, uint8_t y, const uint8_t* sprite_data, uint8_t num_bytes) {
+    CHIP8_PROFILE_SCOPE(ProfileTimer::DrawSprite);
+
+    if (hires || plane_mask != 1) {
+        return draw_rows(x, y, sprite_data, num_bytes, false);
+    }
+
+    // Plain CHIP-8: lo-res, plane 0 only, one word per row
+    uint64_t (&rows)[DISPLAY_HIRES_HEIGHT][DISPLAY_ROW_WORDS] = planes[0];
+
+    // Ensure initial coordinates wrap around the screen
+    x = x & (DISPLAY_WIDTH - 1);
+    y = y & (DISPLAY_HEIGHT - 1);
+
+    // Rows past the bottom edge are clipped
+    int row_count = num_bytes;
+    if (y + row_count > DISPLAY_HEIGHT) {
+        row_count = DISPLAY_HEIGHT - y;
+    }
+
+    // Each sprite byte is moved into position with one shift; pixels past the right edge
+    // fall off the bottom of the word, which clips them
+    uint64_t collisions = 0;
+    for (int row_idx = 0; row_idx < row_count; row_idx++) {
+        uint64_t sprite_row = ((uint64_t) sprite_data[row_idx] << (DISPLAY_WIDTH - 8)) >> x;
+        collisions |= rows[y + row_idx][0] & sprite_row;
+        rows[y + row_idx][0] ^= sprite_row;
+    }
+    if (row_count > 0) {
+        dirty_rows |= (~0ULL >> (64 - row_count)) << y;
+    }
+
+    redraw = true;
+    return collisions != 0;
+}
+
+bool Display::draw_large_sprite(uint8_t x, uint8_t y, const uint8_t* sprite_data) {
+    CHIP8_PROFILE_SCOPE(ProfileTimer::DrawSprite);
+    return draw_rows(x, y, sprite_data, 16, true);
+}
+
+bool Display::draw_rows(uint8_t x, uint8_t y, const uint8_t* sprite_data, int height, bool wide) {
+    int width = get_width();
+    x = x & (width - 1);
+    y = y & (get_height() - 1);
+
+    int row_count = height;
+    if (y + row_count > get_height()) {
+        row_count = get_height() - y;
+    }
+
+    // The sprite row is placed in a two-word row with one pair of shifts; bits shifted past
+    // word 1 (or past word 0 in lo-res, where word 1 is not shown) are clipped. The shift
+    // amounts only depend on x, so they are worked out once per sprite.
+    bool starts_left = x < 64;
+    int left_shift = starts_left ? x : 0;
+    int right_shift = starts_left ? 63 - x : x - 64;
+    uint64_t left_mask = starts_left ? ~0ULL : 0;
+    uint64_t right_mask = hires ? ~0ULL : 0;
+
+    uint64_t collisions = 0;
+    int row_bytes = wide ? 2 : 1;
+    for (int plane = 0; plane < DISPLAY_PLANES; plane++) {
+        if ((plane_mask & (1 << plane)) == 0) {
+            continue;
+        }
+        for (int row_idx = 0; row_idx < row_count; row_idx++) {
+            const uint8_t* source = sprite_data + row_idx * row_bytes;
+            uint64_t bits = wide ? (uint64_t) ((source[0] << 8) | source[1]) << 48 : (uint64_t) source[0] << 56;
+            uint64_t left = (bits >> left_shift) & left_mask;
+            // (bits << 1) << (63 - x) rather than bits << (64 - x), which is undefined for x = 0
+            uint64_t right = (starts_left ? (bits << 1) << right_shift : bits >> right_shift) & right_mask;
+            uint64_t* row = planes[plane][y + row_idx];
+            collisions |= (row[0] & left) | (row[1] & right);
+            row[0] ^= left;
+            row[1] ^= right;
+        }
+        sprite_data += height * row_bytes;
+    }
+    if (row_count > 0) {
+        dirty_rows |= (~0ULL >> (64 - row_count)) << y;
+    }
 
     redraw = true;
-    return flipped_pixel_off;
+    return collisions != 0;
 }
@@ -1,25 +1,61 @@
 #ifndef DISPLAY_H
 #define DISPLAY_H
 
-#include <cstdint> // Required for uint8_t
+#include <cstdint> // Required for uint8_t and uint64_t
 
-// Constants for display dimensions.
+// Constants for display dimensions. CHIP-8 (and SUPER-CHIP's lo-res mode) is 64x32.
 const int DISPLAY_WIDTH = 64;
 const int DISPLAY_HEIGHT = 32;
 
+// SUPER-CHIP / XO-CHIP hi-res mode
+const int DISPLAY_HIRES_WIDTH = 128;
+const int DISPLAY_HIRES_HEIGHT = 64;
+
+// Every row is stored hi-res wide: word 0 holds pixels 0-63, word 1 pixels 64-127, and bit 63
+// of each word is its leftmost pixel. Lo-res only uses word 0 of the first 32 rows.
+const int DISPLAY_ROW_WORDS = 2;
+
+// XO-CHIP draws into two bitplanes; a pixel's colour is its plane bits (0-3)
+const int DISPLAY_PLANES = 2;
+
+// Pixels scrolled by 00FB / 00FC
+const int DISPLAY_SCROLL_PIXELS = 4;
+
+// Size of the display part of a savestate: every row word of both planes, little-endian,
+// then the resolution and the selected planes, padded to a multiple of 8
+const int DISPLAY_STATE_SIZE = DISPLAY_PLANES * DISPLAY_HIRES_HEIGHT * DISPLAY_ROW_WORDS * 8 + 8;
+
 class Display {
 private:
-    // Declare the private pixel buffer.
-    bool display[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+    // Declare the private pixel buffer: DISPLAY_ROW_WORDS words per row for each plane.
+    uint64_t planes[DISPLAY_PLANES][DISPLAY_HIRES_HEIGHT][DISPLAY_ROW_WORDS];
     // Declare the private redraw flag.
     bool redraw;
+    // One bit per row changed since the renderer last uploaded it (bit 0 = top row).
+    uint64_t dirty_rows;
+    bool hires;         // 128x64 instead of 64x32
+    uint8_t plane_mask; // Planes that drawing, clearing and scrolling act on (bit 0 = plane 0)
+
+    void mark_all_dirty();
+    bool draw_rows(uint8_t x, uint8_t y, const uint8_t* sprite_data, int height, bool wide);
 
 public:
     Display();
 
-    // Getter for the display pixel data.
-    // Returns a const reference to the 2D boolean array.
-    const bool (&get_display() const)[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+    // Current resolution: 64x32, or 128x64 in hi-res mode.
+    int get_width() const;
+    int get_height() const;
+    bool is_hires() const;
+
+    // The DISPLAY_ROW_WORDS packed words of one row of a plane (y: 0 to get_height() - 1).
+    const uint64_t* get_row(int plane, int y) const;
+
+    // Colour of a single pixel: bit 0 from plane 0, bit 1 from plane 1 (0 = off).
+    uint8_t get_pixel(int x, int y) const;
+
+    // Expand the packed rows into one colour per pixel for code that wants the unpacked layout.
+    // Only the top-left get_width() x get_height() pixels are written.
+    void unpack(uint8_t pixels[DISPLAY_HIRES_HEIGHT][DISPLAY_HIRES_WIDTH]) const;
 
     // Method to check if the display needs to be redrawn.
     bool need_to_redraw() const;
@@ -29,15 +65,46 @@ public:
 
     void set_redraw_flag();
 
-    // Clears all pixels on the display (sets them to false/off).
+    // Rows changed since the last call to clear_dirty_rows(), one bit per row.
+    uint64_t get_dirty_rows() const;
+    void clear_dirty_rows();
+
+    // Serialize / restore the pixels as DISPLAY_STATE_SIZE bytes. Restored rows that differ
+    // are marked dirty and the redraw flag is set if anything changed.
+    void save_state(uint8_t* out) const;
+    void load_state(const uint8_t* in);
+
+    // Compare resolution, selected planes and every pixel with another display
+    bool same_state(const Display& other) const;
+
+    // Switch between 64x32 and 128x64 (00FE / 00FF). Switching clears both planes.
+    void set_hires(bool enabled);
+
+    // Select the planes later draws, clears and scrolls act on (XO-CHIP FN01). CHIP-8 and
+    // SUPER-CHIP programs only ever use plane 0, the default.
+    void set_plane_mask(uint8_t mask);
+    uint8_t get_plane_mask() const;
+
+    // Clears all pixels of the selected planes (sets them to false/off).
     void clear_display();
 
+    // Scroll the selected planes by whole rows (00CN / 00DN) or by DISPLAY_SCROLL_PIXELS
+    // (00FB / 00FC), in pixels of the current resolution. Pixels moved in are off.
+    void scroll_down(int count);
+    void scroll_up(int count);
+    void scroll_right();
+    void scroll_left();
+
     // Draws a sprite onto the display buffer using XOR logic.
     // x, y: The top-left coordinates on the display to start drawing.
     // sprite_data: Pointer to the sprite bytes in memory.
     // num_bytes: The height of the sprite in bytes (each byte is 8 pixels wide).
+    // With both planes selected, the sprite for plane 1 follows the one for plane 0.
     // Returns true if any pixel was flipped from on to off (for CHIP-8's VF register).
-    bool draw_sprite(uint8_t x, uint8_t y, uint8_t* sprite_data, uint8_t num_bytes);
+    bool draw_sprite(uint8_t x, uint8_t y, const uint8_t* sprite_data, uint8_t num_bytes);
+
+    // Draws a 16x16 sprite (SUPER-CHIP DXY0) of 32 bytes per plane, two bytes per row.
+    bool draw_large_sprite(uint8_t x, uint8_t y, const uint8_t* sprite_data);
 };
 
 #endif // DISPLAY_H
@@ -0,0 +1,324 @@
+// headless.cpp
+//
+// Runs a ROM without SDL as fast as possible and reports the interpreter throughput.
+// Usage: chip8-headless [options] <rom> [frames] [cycles_per_frame]
+//   --dispatch=switch|cached|threaded
+//                 Interpreter dispatch: raw switch, decoded instruction cache (default),
+//                 or compile-time decode table with computed goto
+//   --variant=chip8|schip|xochip  Instruction set (default chip8)
+//   --jit         Run through the x86-64 recompiler (CHIP-8 only)
+//   --jit-verify  Run the recompiler and the interpreter side by side and report divergence
+//   --no-idle-skip  Run wait loops cycle by cycle instead of fast-forwarding them
+//   --no-fusion   Run common sequences (e.g. 6XNN 6YNN DXYN) instruction by instruction in cached dispatch
+//   --lockstep=N  Run N copies of the ROM through SIMD lockstep engines and report the combined rate
+//                 (CHIP-8 only)
+//   --load-state=FILE  Resume from a savestate instead of the ROM's initial state
+//   --save-state=FILE  Write a savestate after the run
+//   --seed=N      Seed for CXNN (lockstep instance k uses N + k)
+//   --replay=FILE Feed keys from an input recording (and use its seed) instead of pressing none
+//   --profile=FILE  Write the profiling counters after the run (needs a -DCHIP8_PROFILE build)
+//   --quirks=old|new  CHIP-8 (default) or CHIP-48 behaviour for 8XY6/8XYE/BNNN/FX55/FX65
+//   --trace=FILE  Record every instruction to a binary trace (see trace.h); compare two traces
+//                 with chip8-trace-diff. Runs every instruction through the interpreter.
+//   --break=ADDR  Stop before the instruction at ADDR (hex, repeatable)
+//   --watch=ADDR[+LEN]  Stop before an instruction writes any of LEN bytes (default 1) at ADDR
+//   --watch-read=ADDR[+LEN]  The same for reads (sprites, FX65, 5XY3, F002)
+//   --watch-i=r|w|rw  Stop before an instruction reads or changes I
+//   --stops=N     Report up to N debugger stops, resuming after each (default 1); exit status
+//                 is 3 if any were hit. Debugged runs always use the interpreter.
+
+#include "machine.h"
+#include "debugger.h"
+#include "input_source.h"
+#include "input_record.h"
+#include "lockstep.h"
+#include "profile.h"
+#include "rom_library.h"
+#include "trace.h"
+
+#include <chrono>   // For timing debugged runs
+#include <cstdlib>  // For strtoull and strtoul
+#include <cstring>  // For strcmp and strchr
+#include <iostream> // For reporting results
+
+// Parse ADDR or ADDR+LEN (hex address, decimal length) for --watch
+static bool parse_watch(const char* text, uint16_t& address, int& length) {
+    char* end = nullptr;
+    unsigned long value = strtoul(text, &end, 16);
+    if (end == text || value >= MEMORY_COUNT) {
+        return false;
+    }
+    address = static_cast<uint16_t>(value);
+    length = *end == '+' ? atoi(end + 1) : 1;
+    return length > 0 && (*end == '\0' || *end == '+');
+}
+
+static void print_stop(Machine& machine, const Debugger& debugger, DebugStop stop) {
+    const CPU& cpu = machine.get_cpu();
+    uint16_t pc = cpu.get_program_counter();
+    std::cout << "stop: " << debug_stop_name(stop) << std::hex << std::uppercase;
+    if (stop == DebugStop::MemoryRead || stop == DebugStop::MemoryWrite) {
+        std::cout << " 0x" << debugger.get_stop_address();
+    }
+    std::cout << " at PC=" << pc << " op=" << ((cpu.read_memory(pc) << 8) | cpu.read_memory(pc + 1))
+              << " I=" << cpu.get_index_register() << " V:";
+    for (int r = 0; r < REGISTER_COUNT; r++) {
+        std::cout << " " << static_cast<int>(cpu.get_register(r));
+    }
+    std::cout << std::dec << std::nouppercase << " (frame " << machine.get_total_frames()
+              << ", " << machine.get_total_instructions() << " instructions)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<const char*> positional;
+    DispatchMode dispatch_mode = DispatchMode::Cached;
+    bool use_jit = false;
+    bool verify_jit = false;
+    bool idle_skip = true;
+    bool fusion = true;
+    int lockstep_instances = 0;
+    const char* load_state_path = nullptr;
+    const char* save_state_path = nullptr;
+    const char* replay_path = nullptr;
+    uint64_t seed = DEFAULT_RNG_SEED;
+    const char* profile_path = nullptr;
+    Chip8Variant variant = Chip8Variant::Chip8;
+    bool new_functionality = false;
+    const char* trace_path = nullptr;
+    Debugger debugger;
+    bool debugging = false;
+    int max_stops = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dispatch=switch") == 0) {
+            dispatch_mode = DispatchMode::Switch;
+        } else if (strcmp(argv[i], "--dispatch=cached") == 0) {
+            dispatch_mode = DispatchMode::Cached;
+        } else if (strcmp(argv[i], "--dispatch=threaded") == 0) {
+            dispatch_mode = DispatchMode::Threaded;
+        } else if (strncmp(argv[i], "--variant=", 10) == 0) {
+            if (!parse_variant(argv[i] + 10, variant)) {
+                std::cerr << "Unknown variant: " << argv[i] + 10 << std::endl;
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--jit") == 0) {
+            use_jit = true;
+        } else if (strcmp(argv[i], "--jit-verify") == 0) {
+            use_jit = true;
+            verify_jit = true;
+        } else if (strcmp(argv[i], "--no-idle-skip") == 0) {
+            idle_skip = false;
+        } else if (strcmp(argv[i], "--no-fusion") == 0) {
+            fusion = false;
+        } else if (strncmp(argv[i], "--lockstep=", 11) == 0) {
+            lockstep_instances = atoi(argv[i] + 11);
+        } else if (strncmp(argv[i], "--load-state=", 13) == 0) {
+            load_state_path = argv[i] + 13;
+        } else if (strncmp(argv[i], "--save-state=", 13) == 0) {
+            save_state_path = argv[i] + 13;
+        } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            seed = strtoull(argv[i] + 7, nullptr, 10);
+        } else if (strncmp(argv[i], "--replay=", 9) == 0) {
+            replay_path = argv[i] + 9;
+        } else if (strncmp(argv[i], "--profile=", 10) == 0) {
+            profile_path = argv[i] + 10;
+        } else if (strcmp(argv[i], "--quirks=old") == 0) {
+            new_functionality = false;
+        } else if (strcmp(argv[i], "--quirks=new") == 0) {
+            new_functionality = true;
+        } else if (strncmp(argv[i], "--trace=", 8) == 0) {
+            trace_path = argv[i] + 8;
+        } else if (strncmp(argv[i], "--break=", 8) == 0) {
+            debugger.set_breakpoint(static_cast<uint16_t>(strtoul(argv[i] + 8, nullptr, 16)));
+            debugging = true;
+        } else if (strncmp(argv[i], "--watch=", 8) == 0 || strncmp(argv[i], "--watch-read=", 13) == 0) {
+            bool on_read = argv[i][7] == '-';
+            uint16_t address = 0;
+            int length = 0;
+            if (!parse_watch(argv[i] + (on_read ? 13 : 8), address, length)) {
+                std::cerr << "Bad watch range: " << argv[i] << std::endl;
+                return 1;
+            }
+            debugger.watch_memory(address, length, on_read, !on_read);
+            debugging = true;
+        } else if (strncmp(argv[i], "--watch-i=", 10) == 0) {
+            const char* kinds = argv[i] + 10;
+            debugger.watch_index(strchr(kinds, 'r') != nullptr, strchr(kinds, 'w') != nullptr);
+            debugging = true;
+        } else if (strncmp(argv[i], "--stops=", 8) == 0) {
+            max_stops = atoi(argv[i] + 8);
+        } else {
+            positional.push_back(argv[i]);
+        }
+    }
+
+    if (positional.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--dispatch=switch|cached|threaded] [--variant=chip8|schip|xochip] [--jit] [--jit-verify] [--no-idle-skip] [--no-fusion] [--lockstep=N] [--load-state=FILE] [--save-state=FILE] [--seed=N] [--replay=FILE] [--profile=FILE] [--quirks=old|new] [--trace=FILE] [--break=ADDR] [--watch=ADDR[+LEN]] [--watch-read=ADDR[+LEN]] [--watch-i=r|w|rw] [--stops=N] <rom> [frames] [cycles_per_frame]" << std::endl;
+        return 1;
+    }
+
+    const std::string rom_filepath = positional[0];
+    uint64_t frames = positional.size() > 1 ? strtoull(positional[1], nullptr, 10) : 60 * 60;
+    int cycles_per_frame = positional.size() > 2 ? atoi(positional[2]) : DEFAULT_CYCLES_PER_FRAME;
+
+    MappedRom rom;
+    if (!rom.open(rom_filepath)) {
+        std::cerr << "Exiting due to ROM loading failure." << std::endl;
+        return 1;
+    }
+
+    if (lockstep_instances > 0 && variant != Chip8Variant::Chip8) {
+        std::cerr << "Lockstep engines only run CHIP-8 programs." << std::endl;
+        return 1;
+    }
+    if (lockstep_instances > 0 && trace_path != nullptr) {
+        std::cerr << "Lockstep runs cannot be traced." << std::endl;
+        return 1;
+    }
+    if (debugging && trace_path != nullptr) {
+        std::cerr << "Debugged runs cannot be traced." << std::endl;
+        return 1;
+    }
+    if (lockstep_instances > 0 && debugging) {
+        std::cerr << "Lockstep runs cannot be debugged." << std::endl;
+        return 1;
+    }
+    if (lockstep_instances > 0) {
+        // One engine per LOCKSTEP_LANES instances, run one after another on this thread
+        RunStats total = {};
+        uint64_t vector_steps = 0;
+        uint64_t scalar_steps = 0;
+        for (int first = 0; first < lockstep_instances; first += LOCKSTEP_LANES) {
+            int lanes = lockstep_instances - first < LOCKSTEP_LANES ? lockstep_instances - first : LOCKSTEP_LANES;
+            std::unique_ptr<LockstepEngine> engine(new LockstepEngine(lanes));
+            engine->set_cycles_per_frame(cycles_per_frame);
+            for (int lane = 0; lane < lanes; lane++) {
+                engine->seed_random(lane, seed + first + lane);
+            }
+            engine->load_program(rom.data(), rom.size());
+            RunStats stats = engine->run_frames(frames);
+            total.frames += stats.frames;
+            total.instructions += stats.instructions;
+            total.seconds += stats.seconds;
+            vector_steps += engine->get_vector_steps();
+            scalar_steps += engine->get_scalar_steps();
+        }
+
+        std::cout << "instances: " << lockstep_instances << "\n"
+                  << "instructions: " << total.instructions << "\n"
+                  << "seconds: " << total.seconds << "\n"
+                  << "instructions/sec: " << static_cast<uint64_t>(total.seconds > 0 ? total.instructions / total.seconds : 0) << "\n"
+                  << "vector steps: " << vector_steps << "\n"
+                  << "scalar steps: " << scalar_steps << std::endl;
+        return 0;
+    }
+
+    // No keys are ever pressed in a plain headless run, unless a recording is replayed
+    ScriptedInput input;
+    InputPlayback playback;
+    InputSource* machine_input = &input;
+    if (replay_path != nullptr) {
+        if (!playback.load_file(replay_path)) {
+            std::cerr << "Could not read input recording: " << replay_path << std::endl;
+            return 1;
+        }
+        seed = playback.get_seed();
+        machine_input = &playback;
+    }
+    Machine machine(*machine_input);
+    machine.set_cycles_per_frame(cycles_per_frame);
+    machine.set_idle_skip(idle_skip);
+    machine.get_cpu().set_dispatch_mode(dispatch_mode);
+    machine.get_cpu().set_fusion(fusion);
+    machine.get_cpu().seed_random(seed);
+    machine.get_cpu().set_new_functionality(new_functionality);
+    machine.set_variant(variant);
+    machine.load_program(rom.data(), rom.size());
+    if (machine.get_cpu().get_fault() == CpuFault::ProgramTooLarge) {
+        std::cerr << "Error: ROM is too large for " << variant_name(variant) << std::endl;
+        return 1;
+    }
+    if (load_state_path != nullptr) {
+        SaveState state;
+        if (!load_state_file(load_state_path, state) || !machine.load_state(state)) {
+            std::cerr << "Could not load savestate: " << load_state_path << std::endl;
+            return 1;
+        }
+    }
+    if (profile_path != nullptr && !PROFILE_ENABLED) {
+        std::cerr << "Warning: built without CHIP8_PROFILE, the profile will be empty" << std::endl;
+    }
+    if (use_jit && !machine.enable_jit(true, verify_jit)) {
+        std::cerr << "Warning: JIT is not available on this host or for this variant, interpreting instead" << std::endl;
+    }
+
+    TraceWriter tracer;
+    if (trace_path != nullptr) {
+        if (!tracer.open(trace_path)) {
+            std::cerr << "Could not create trace: " << trace_path << std::endl;
+            return 1;
+        }
+        machine.set_tracer(&tracer);
+    }
+
+    int stops = 0;
+    RunStats stats = {};
+    if (debugging) {
+        // Resume after every stop until the frames are done or enough stops were reported
+        auto start_time = std::chrono::steady_clock::now();
+        uint64_t start_instructions = machine.get_total_instructions();
+        uint64_t end_frame = machine.get_total_frames() + frames;
+        while (stops < max_stops && machine.get_total_frames() < end_frame) {
+            DebugStop stop = machine.debug_run(debugger, end_frame - machine.get_total_frames());
+            if (stop == DebugStop::Frame || stop == DebugStop::Halted) {
+                break;
+            }
+            print_stop(machine, debugger, stop);
+            stops += 1;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+        stats.frames = frames - (end_frame - machine.get_total_frames());
+        stats.instructions = machine.get_total_instructions() - start_instructions;
+        stats.seconds = elapsed.count();
+        stats.instructions_per_second = stats.seconds > 0 ? stats.instructions / stats.seconds : 0;
+    } else {
+        stats = machine.run_frames(frames);
+    }
+
+    if (trace_path != nullptr) {
+        machine.set_tracer(nullptr);
+        if (!tracer.close()) {
+            std::cerr << "Could not write trace: " << trace_path << std::endl;
+            return 1;
+        }
+        std::cout << "trace: " << tracer.get_records() << " instructions, " << tracer.get_bytes() << " bytes" << std::endl;
+    }
+
+    std::cout << "frames: " << stats.frames << "\n"
+              << "instructions: " << stats.instructions << "\n"
+              << "seconds: " << stats.seconds << "\n"
+              << "instructions/sec: " << static_cast<uint64_t>(stats.instructions_per_second) << "\n"
+              << "idle instructions skipped: " << machine.get_idle_instructions_skipped() << std::endl;
+    if (machine.get_cpu().get_fault() != CpuFault::None) {
+        std::cout << "fault: " << fault_name(machine.get_cpu().get_fault()) << std::endl;
+    }
+
+    if (profile_path != nullptr && !get_profiler().write_report(profile_path)) {
+        std::cerr << "Could not write profile: " << profile_path << std::endl;
+        return 1;
+    }
+
+    if (save_state_path != nullptr) {
+        SaveState state;
+        machine.save_state(state);
+        if (!save_state_file(save_state_path, state)) {
+            std::cerr << "Could not write savestate: " << save_state_path << std::endl;
+            return 1;
+        }
+    }
+
+    if (machine.has_diverged()) {
+        std::cerr << machine.get_divergence() << std::endl;
+        return 2;
+    }
+    return stops > 0 ? 3 : 0;
+}
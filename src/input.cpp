@@ -1,11 +1,14 @@
 #include "input.h"
-#include <iostream> // For error/debug output
+#include <cctype>   // For tolower
 
 Input::Input() {
     // Initialize all Chip-8 key states to not pressed
     key_states.fill(false);
     last_pressed_key = -1; // No key pressed initially
     quit_requested = false;
+    rewind_held = false;
+    profile_requested = false;
+    turbo_toggled = false;
 
     // Initialize the specific SDL_Scancode to Chip-8 key mapping
     initialize_key_map();
@@ -54,6 +57,15 @@ void Input::poll_events() {
                 break;
 
             case SDL_KEYDOWN:
+                if (event.key.keysym.scancode == SDL_SCANCODE_BACKSPACE) {
+                    rewind_held = true;
+                }
+                if (event.key.keysym.scancode == SDL_SCANCODE_F12 && event.key.repeat == 0) {
+                    profile_requested = true;
+                }
+                if (event.key.keysym.scancode == SDL_SCANCODE_TAB && event.key.repeat == 0) {
+                    turbo_toggled = true;
+                }
                 // Ignore key repeats for most Chip-8 games
                 if (event.key.repeat == 0) {
                     for (int i = 0; i < CHIP8_KEY_COUNT; ++i) {
@@ -67,6 +79,9 @@ void Input::poll_events() {
                 break;
 
             case SDL_KEYUP:
+                if (event.key.keysym.scancode == SDL_SCANCODE_BACKSPACE) {
+                    rewind_held = false;
+                }
                 for (int i = 0; i < CHIP8_KEY_COUNT; ++i) {
                     if (key_map[i] == event.key.keysym.scancode) {
                         key_states[i] = false;
@@ -83,12 +98,18 @@ void Input::poll_events() {
 }
 
 bool Input::is_pressed(uint8_t chip8_key_code) const {
-    if (chip8_key_code >= 0 && chip8_key_code < CHIP8_KEY_COUNT) {
-        return key_states[chip8_key_code];
+    // EX9E / EXA1 pass whatever VX holds; values past 0xF are simply never pressed
+    return chip8_key_code < CHIP8_KEY_COUNT && key_states[chip8_key_code];
+}
+
+uint16_t Input::get_key_mask() const {
+    uint16_t mask = 0;
+    for (int i = 0; i < CHIP8_KEY_COUNT; ++i) {
+        if (key_states[i]) {
+            mask |= static_cast<uint16_t>(1u << i);
+        }
     }
-    std::cerr << "Warning: Attempted to check invalid Chip-8 key code: "
-              << static_cast<int>(chip8_key_code) << std::endl;
-    return false; // Invalid key code
+    return mask;
 }
 
 int Input::get_pressed_key() const {
@@ -98,3 +119,36 @@ int Input::get_pressed_key() const {
 bool Input::should_quit() const {
     return quit_requested;
 }
+
+bool Input::is_rewind_held() const {
+    return rewind_held;
+}
+
+bool Input::take_profile_request() {
+    bool requested = profile_requested;
+    profile_requested = false;
+    return requested;
+}
+
+bool Input::take_turbo_toggle() {
+    bool toggled = turbo_toggled;
+    turbo_toggled = false;
+    return toggled;
+}
+
+bool Input::set_key_map(const std::string& keys) {
+    if (keys.size() != CHIP8_KEY_COUNT) {
+        return false;
+    }
+
+    // SDL keycodes for letters and digits are their lower-case characters
+    std::array<SDL_Scancode, CHIP8_KEY_COUNT> new_map;
+    for (int i = 0; i < CHIP8_KEY_COUNT; ++i) {
+        new_map[i] = SDL_GetScancodeFromKey(static_cast<SDL_Keycode>(tolower(static_cast<unsigned char>(keys[i]))));
+        if (new_map[i] == SDL_SCANCODE_UNKNOWN) {
+            return false;
+        }
+    }
+    key_map = new_map;
+    return true;
+}
@@ -3,33 +3,53 @@
 
 #include <SDL.h> // Include SDL header
 #include <array>   // For std::array
-#include <cstdint> // For uint8_t
+#include <cstdint> // For uint8_t and uint16_t
+#include <string>  // For key map strings
+#include "input_source.h"
 
-// Define the number of Chip-8 keys
-const int CHIP8_KEY_COUNT = 16;
-
-class Input {
+// Keyboard input backed by SDL events
+class Input : public InputSource {
 public:
     Input();
     ~Input();
 
     // Call this at the beginning of your main loop to process SDL events
-    void poll_events();
+    void poll_events() override;
 
     // Check if a specific Chip-8 key is currently pressed
-    bool is_pressed(uint8_t chip8_key_code) const;
+    bool is_pressed(uint8_t chip8_key_code) const override;
 
     // Get the value of a key that was just pressed (for Fx0A opcode)
     // Returns -1 if no key was pressed since last call, otherwise the Chip-8 key code
-    int get_pressed_key() const;
+    int get_pressed_key() const override;
+
+    // Held keys as a mask, bit n = Chip-8 key n
+    uint16_t get_key_mask() const;
 
     // Check if the quit event was triggered (e.g., closing the window)
-    bool should_quit() const;
+    bool should_quit() const override;
+
+    // Replace the keyboard layout with 16 keys (letters or digits) for Chip-8 keys 0-F,
+    // e.g. "x123qweasdzc4rfv" (the default). Returns false and keeps the old layout if a
+    // character has no key.
+    bool set_key_map(const std::string& keys);
+
+    // Host hotkey: true while Backspace is held to rewind
+    bool is_rewind_held() const;
+
+    // Host hotkey: true once after F12 was pressed to dump the profile
+    bool take_profile_request();
+
+    // Host hotkey: true once after Tab was pressed to toggle fast-forward
+    bool take_turbo_toggle();
 
 private:
     std::array<bool, CHIP8_KEY_COUNT> key_states; // Array to store current state of Chip-8 keys
     int last_pressed_key; // Stores the last pressed Chip-8 key for Fx0A
     bool quit_requested;   // Flag to indicate if the user wants to quit
+    bool rewind_held;      // Backspace is down
+    bool profile_requested; // F12 was pressed since the last take_profile_request()
+    bool turbo_toggled;     // Tab was pressed since the last take_turbo_toggle()
 
     // Map SDL_Scancode to Chip-8 key code
     // SDL_Scancode is preferred over SDLK_Key for layout-independent input
@@ -0,0 +1,172 @@
+#include "input_record.h"
+
+#include <algorithm> // For std::equal
+#include <fstream>  // For reading and writing recordings
+#include <iterator> // For std::istreambuf_iterator
+
+namespace {
+
+const uint8_t RECORD_MAGIC[4] = {'C', '8', 'I', 'N'};
+
+void put_varint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(value);
+}
+
+// Returns false if the stream ends in the middle of the number
+bool get_varint(const std::vector<uint8_t>& data, size_t& offset, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (offset >= data.size()) {
+            return false;
+        }
+        uint8_t byte = data[offset++];
+        value |= (uint32_t) (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+InputRecorder::InputRecorder(InputSource& input_source, uint64_t seed) : source(input_source) {
+    data.assign(RECORD_MAGIC, RECORD_MAGIC + 4);
+    for (int b = 0; b < 8; b++) {
+        data.push_back((seed >> (b * 8)) & 0xFF);
+    }
+    frame = 0;
+    last_entry_frame = 0;
+    keys = 0;
+    pressed_key = -1;
+    quit = false;
+}
+
+void InputRecorder::poll_events() {
+    source.poll_events();
+
+    uint16_t new_keys = 0;
+    for (int key = 0; key < CHIP8_KEY_COUNT; key++) {
+        if (source.is_pressed(key)) {
+            new_keys |= 1 << key;
+        }
+    }
+    int new_pressed_key = source.get_pressed_key();
+    bool new_quit = source.should_quit();
+
+    uint8_t flags = 0;
+    if (new_keys != keys) { flags |= INPUT_RECORD_KEYS; }
+    if (new_pressed_key != pressed_key) { flags |= INPUT_RECORD_PRESSED; }
+    if (new_quit && !quit) { flags |= INPUT_RECORD_QUIT; }
+
+    if (flags != 0) {
+        put_varint(data, frame - last_entry_frame);
+        data.push_back(flags);
+        if (flags & INPUT_RECORD_KEYS) {
+            data.push_back(new_keys & 0xFF);
+            data.push_back(new_keys >> 8);
+        }
+        if (flags & INPUT_RECORD_PRESSED) {
+            data.push_back(new_pressed_key < 0 ? 0xFF : new_pressed_key);
+        }
+        last_entry_frame = frame;
+    }
+
+    keys = new_keys;
+    pressed_key = new_pressed_key;
+    quit = quit || new_quit;
+    frame += 1;
+}
+
+bool InputRecorder::is_pressed(uint8_t chip8_key_code) const { return source.is_pressed(chip8_key_code); }
+int InputRecorder::get_pressed_key() const { return source.get_pressed_key(); }
+bool InputRecorder::should_quit() const { return source.should_quit(); }
+
+const std::vector<uint8_t>& InputRecorder::get_data() const { return data; }
+
+bool InputRecorder::save(const std::string& filepath) const {
+    std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return static_cast<bool>(file);
+}
+
+InputPlayback::InputPlayback() {
+    // An empty recording: no keys, ever
+    std::vector<uint8_t> empty(RECORD_MAGIC, RECORD_MAGIC + 4);
+    empty.resize(INPUT_RECORD_HEADER_SIZE, 0);
+    load(empty);
+}
+
+bool InputPlayback::load(const std::vector<uint8_t>& recording) {
+    if (recording.size() < (size_t) INPUT_RECORD_HEADER_SIZE || !std::equal(RECORD_MAGIC, RECORD_MAGIC + 4, recording.begin())) {
+        return false;
+    }
+    data = recording;
+    seed = 0;
+    for (int b = 0; b < 8; b++) {
+        seed |= (uint64_t) data[4 + b] << (b * 8);
+    }
+    offset = INPUT_RECORD_HEADER_SIZE;
+    frame = 0;
+    keys = 0;
+    pressed_key = -1;
+    quit = false;
+    read_next_entry_frame(0);
+    return true;
+}
+
+bool InputPlayback::load_file(const std::string& filepath) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::vector<uint8_t> recording((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return load(recording);
+}
+
+void InputPlayback::read_next_entry_frame(uint32_t base_frame) {
+    uint32_t delta;
+    if (get_varint(data, offset, delta)) {
+        next_entry_frame = base_frame + delta;
+    } else {
+        offset = data.size();
+    }
+}
+
+void InputPlayback::poll_events() {
+    if (offset < data.size() && frame == next_entry_frame) {
+        uint8_t flags = data[offset++];
+        if ((flags & INPUT_RECORD_KEYS) && offset + 2 <= data.size()) {
+            keys = data[offset] | (data[offset + 1] << 8);
+            offset += 2;
+        }
+        if ((flags & INPUT_RECORD_PRESSED) && offset < data.size()) {
+            pressed_key = data[offset] == 0xFF ? -1 : data[offset];
+            offset += 1;
+        }
+        if (flags & INPUT_RECORD_QUIT) {
+            quit = true;
+        }
+        read_next_entry_frame(frame);
+    }
+    frame += 1;
+}
+
+bool InputPlayback::is_pressed(uint8_t chip8_key_code) const {
+    if (chip8_key_code < CHIP8_KEY_COUNT) {
+        return (keys >> chip8_key_code) & 1;
+    }
+    return false;
+}
+
+int InputPlayback::get_pressed_key() const { return pressed_key; }
+bool InputPlayback::should_quit() const { return quit; }
+uint64_t InputPlayback::get_seed() const { return seed; }
+bool InputPlayback::is_finished() const { return offset >= data.size(); }
@@ -0,0 +1,80 @@
+#ifndef INPUT_RECORD_H
+#define INPUT_RECORD_H
+
+#include <cstdint> // For uint8_t, uint16_t and uint32_t
+#include <string>  // For file paths
+#include <vector>  // For the recorded stream
+#include "input_source.h"
+
+// Recorded input stream: the 4-byte magic "C8IN" and the machine's RNG seed (u64,
+// little-endian), then one entry per frame whose input differs from the frame before.
+// Each entry is the number of frames since the previous entry (LEB128), a flag byte and
+// the changed fields:
+//   0x01 key mask follows (u16, bit n = key n held)
+//   0x02 Fx0A key follows (u8, 0xFF = none)
+//   0x04 quit requested
+// A frame is exactly what the machine can observe between two polls, so replaying the
+// stream into a machine seeded the same way reproduces a run bit for bit.
+const int INPUT_RECORD_HEADER_SIZE = 12;
+const uint8_t INPUT_RECORD_KEYS = 0x01;
+const uint8_t INPUT_RECORD_PRESSED = 0x02;
+const uint8_t INPUT_RECORD_QUIT = 0x04;
+
+// Passes another input source through unchanged while logging what it reports each frame
+class InputRecorder : public InputSource {
+public:
+    // seed is the RNG seed the recorded machine was started with
+    InputRecorder(InputSource& source, uint64_t seed);
+
+    void poll_events() override;
+    bool is_pressed(uint8_t chip8_key_code) const override;
+    int get_pressed_key() const override;
+    bool should_quit() const override;
+
+    const std::vector<uint8_t>& get_data() const;
+    bool save(const std::string& filepath) const;
+
+private:
+    InputSource& source;
+    std::vector<uint8_t> data;
+    uint32_t frame;
+    uint32_t last_entry_frame;
+    uint16_t keys;
+    int pressed_key;
+    bool quit;
+};
+
+// Plays a recorded stream back, one frame per poll_events() call
+class InputPlayback : public InputSource {
+public:
+    InputPlayback();
+
+    // Replace the stream; returns false if the data is not a recording
+    bool load(const std::vector<uint8_t>& recording);
+    bool load_file(const std::string& filepath);
+
+    // RNG seed the recording was made with
+    uint64_t get_seed() const;
+
+    void poll_events() override;
+    bool is_pressed(uint8_t chip8_key_code) const override;
+    int get_pressed_key() const override;
+    bool should_quit() const override;
+
+    // True once every recorded entry has been applied
+    bool is_finished() const;
+
+private:
+    std::vector<uint8_t> data;
+    uint64_t seed;
+    size_t offset;
+    uint32_t frame;
+    uint32_t next_entry_frame;
+    uint16_t keys;
+    int pressed_key;
+    bool quit;
+
+    void read_next_entry_frame(uint32_t base_frame);
+};
+
+#endif // INPUT_RECORD_H
@@ -0,0 +1,111 @@
+#include "input_source.h"
+#include <algorithm> // For std::upper_bound
+
+ScriptedInput::ScriptedInput() {
+    next_event = 0;
+    frame = 0;
+    quit_frame = UINT32_MAX;
+    key_states.fill(false);
+    last_pressed_key = -1;
+}
+
+void ScriptedInput::add_event(uint32_t event_frame, uint8_t key, bool pressed) {
+    if (key >= CHIP8_KEY_COUNT) {
+        return;
+    }
+
+    // Keep the list sorted by frame, preserving insertion order within a frame
+    ScriptedKeyEvent event = {event_frame, key, pressed};
+    auto position = std::upper_bound(events.begin() + next_event, events.end(), event,
+        [](const ScriptedKeyEvent& a, const ScriptedKeyEvent& b) { return a.frame < b.frame; });
+    events.insert(position, event);
+}
+
+void ScriptedInput::quit_at(uint32_t frame_number) { quit_frame = frame_number; }
+
+void ScriptedInput::poll_events() {
+    last_pressed_key = -1;
+
+    // Apply every event scheduled for the current frame
+    while (next_event < events.size() && events[next_event].frame <= frame) {
+        const ScriptedKeyEvent& event = events[next_event];
+        if (event.pressed && !key_states[event.key]) {
+            last_pressed_key = event.key;
+        }
+        key_states[event.key] = event.pressed;
+        next_event += 1;
+    }
+
+    frame += 1;
+}
+
+bool ScriptedInput::is_pressed(uint8_t chip8_key_code) const {
+    if (chip8_key_code < CHIP8_KEY_COUNT) {
+        return key_states[chip8_key_code];
+    }
+    return false;
+}
+
+int ScriptedInput::get_pressed_key() const { return last_pressed_key; }
+
+bool ScriptedInput::should_quit() const { return frame > quit_frame; }
+
+HeldInput::HeldInput() { keys = 0; }
+
+void HeldInput::hold(const InputSource& source) {
+    keys = 0;
+    for (int key = 0; key < CHIP8_KEY_COUNT; key++) {
+        if (source.is_pressed(static_cast<uint8_t>(key))) {
+            keys |= static_cast<uint16_t>(1u << key);
+        }
+    }
+}
+
+void HeldInput::poll_events() {}
+
+bool HeldInput::is_pressed(uint8_t chip8_key_code) const {
+    return chip8_key_code < CHIP8_KEY_COUNT && (keys >> chip8_key_code) & 1;
+}
+
+int HeldInput::get_pressed_key() const { return -1; }
+
+AtomicKeypad::AtomicKeypad() {
+    shared_keys.store(0, std::memory_order_relaxed);
+    shared_presses.store(0, std::memory_order_relaxed);
+    shared_quit.store(false, std::memory_order_relaxed);
+    keys = 0;
+    pressed_key = -1;
+}
+
+void AtomicKeypad::update(uint16_t key_mask, int key) {
+    if (key >= 0 && key < CHIP8_KEY_COUNT) {
+        shared_presses.fetch_or(static_cast<uint16_t>(1u << key), std::memory_order_relaxed);
+    }
+    shared_keys.store(key_mask, std::memory_order_relaxed);
+}
+
+void AtomicKeypad::request_quit() { shared_quit.store(true, std::memory_order_relaxed); }
+
+void AtomicKeypad::poll_events() {
+    keys = shared_keys.load(std::memory_order_relaxed);
+    // Report one press per poll and leave the rest for the following frames, so presses that
+    // land together are not lost to FX0A. Clearing only the reported bit keeps presses the
+    // input thread adds in the meantime.
+    uint16_t presses = shared_presses.load(std::memory_order_relaxed);
+    pressed_key = -1;
+    for (int key = 0; key < CHIP8_KEY_COUNT; key++) {
+        if (presses & (1u << key)) {
+            pressed_key = key;
+            shared_presses.fetch_and(static_cast<uint16_t>(~(1u << key)), std::memory_order_relaxed);
+            break;
+        }
+    }
+}
+
+bool AtomicKeypad::is_pressed(uint8_t chip8_key_code) const {
+    return chip8_key_code < CHIP8_KEY_COUNT && (keys >> chip8_key_code) & 1;
+}
+
+int AtomicKeypad::get_pressed_key() const { return pressed_key; }
+
+bool AtomicKeypad::should_quit() const { return shared_quit.load(std::memory_order_relaxed); }
@@ -0,0 +1,110 @@
+#ifndef INPUT_SOURCE_H
+#define INPUT_SOURCE_H
+
+#include <array>   // For std::array
+#include <atomic>  // For the shared keypad snapshot
+#include <cstddef> // For size_t
+#include <cstdint> // For uint8_t and uint32_t
+#include <vector>  // For the scripted event list
+
+// Define the number of Chip-8 keys
+const int CHIP8_KEY_COUNT = 16;
+
+// Abstract keypad used by the CPU core. The SDL keyboard (Input) is one implementation,
+// but the core never needs to know where key state comes from, so it can run without SDL.
+class InputSource {
+public:
+    virtual ~InputSource() {}
+
+    // Called once per frame to bring the key state up to date
+    virtual void poll_events() = 0;
+
+    // Check if a specific Chip-8 key is currently pressed
+    virtual bool is_pressed(uint8_t chip8_key_code) const = 0;
+
+    // Get the value of a key that was just pressed (for Fx0A opcode)
+    // Returns -1 if no key was pressed since the last poll, otherwise the Chip-8 key code
+    virtual int get_pressed_key() const = 0;
+
+    // Check if the source wants the emulator to stop
+    virtual bool should_quit() const { return false; }
+};
+
+// A single key change applied at the start of a given frame
+struct ScriptedKeyEvent {
+    uint32_t frame;
+    uint8_t key;
+    bool pressed;
+};
+
+// Input source driven by a list of key events instead of a keyboard.
+// Each call to poll_events() advances one frame and applies the events scheduled for it.
+class ScriptedInput : public InputSource {
+public:
+    ScriptedInput();
+
+    // Schedule a key press or release at the given frame (events may be added in any order)
+    void add_event(uint32_t frame, uint8_t key, bool pressed);
+
+    // Request a quit once the given frame has been reached
+    void quit_at(uint32_t frame);
+
+    void poll_events() override;
+    bool is_pressed(uint8_t chip8_key_code) const override;
+    int get_pressed_key() const override;
+    bool should_quit() const override;
+
+private:
+    std::vector<ScriptedKeyEvent> events; // Sorted by frame
+    size_t next_event;
+    uint32_t frame;
+    uint32_t quit_frame;
+    std::array<bool, CHIP8_KEY_COUNT> key_states;
+    int last_pressed_key;
+};
+
+// Repeats the keys another source held at one moment, with no new presses and no quit.
+// Run-ahead uses it for speculative frames so they neither consume nor record real input.
+class HeldInput : public InputSource {
+public:
+    HeldInput();
+
+    // Take the keys source currently reports as held
+    void hold(const InputSource& source);
+
+    void poll_events() override;
+    bool is_pressed(uint8_t chip8_key_code) const override;
+    int get_pressed_key() const override;
+
+private:
+    uint16_t keys; // Bit n = key n held
+};
+
+// Keypad shared between an input thread that writes key state and an emulation thread that
+// reads it. The key mask is one atomic word, and presses are accumulated as edges until the
+// next poll, so a key tapped between two emulated frames still reaches Fx0A.
+class AtomicKeypad : public InputSource {
+public:
+    AtomicKeypad();
+
+    // Input thread: current keys (bit n = key n held), and a key just pressed or -1
+    void update(uint16_t key_mask, int pressed_key);
+    void request_quit();
+
+    // Emulation thread: snapshot the shared state for the coming frame
+    void poll_events() override;
+    bool is_pressed(uint8_t chip8_key_code) const override;
+    int get_pressed_key() const override;
+    bool should_quit() const override;
+
+private:
+    std::atomic<uint16_t> shared_keys;
+    std::atomic<uint16_t> shared_presses; // Keys pressed and not yet reported by a poll
+    std::atomic<bool> shared_quit;
+
+    // Snapshot taken by poll_events()
+    uint16_t keys;
+    int pressed_key;
+};
+
+#endif // INPUT_SOURCE_H
@@ -0,0 +1,294 @@
+#include "jit.h"
+#include "opcodes.h"
+
+#include <cstring> // For memcpy
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define CHIP8_JIT_SUPPORTED 1
+#include <sys/mman.h> // For mmap
+#else
+#define CHIP8_JIT_SUPPORTED 0
+#endif
+
+namespace {
+
+// Appends raw x86-64 machine code
+struct CodeEmitter {
+    std::vector<uint8_t> bytes;
+
+    void byte(uint8_t value) { bytes.push_back(value); }
+
+    void bytes_of(std::initializer_list<uint8_t> values) {
+        bytes.insert(bytes.end(), values.begin(), values.end());
+    }
+
+    void imm16(uint16_t value) {
+        byte(value & 0xFF);
+        byte(value >> 8);
+    }
+
+    void imm64(const void* pointer) {
+        uint64_t value = reinterpret_cast<uint64_t>(pointer);
+        for (int i = 0; i < 8; i++) {
+            byte((value >> (i * 8)) & 0xFF);
+        }
+    }
+
+    // movabs <reg>, imm64 (reg encoded as 0xB8 + register number)
+    void mov_reg_imm64(uint8_t reg, const void* pointer) {
+        bytes_of({0x48, (uint8_t) (0xB8 + reg)});
+        imm64(pointer);
+    }
+
+    // mov word [address], imm16 (via rax)
+    void store_word(const uint16_t* address, uint16_t value) {
+        mov_reg_imm64(0, address);
+        bytes_of({0x66, 0xC7, 0x00});
+        imm16(value);
+    }
+};
+
+const uint8_t RAX = 0;
+const uint8_t RCX = 1;
+const uint8_t RDX = 2;
+const uint8_t RBX = 3;
+const uint8_t RSI = 6;
+const uint8_t RDI = 7;
+
+// Operations that end a block: anything that may move the program counter somewhere
+// other than the next instruction, or that writes memory the block may be running from
+bool ends_block(uint8_t operation) {
+    switch (operation) {
+        case OP_RET:
+        case OP_JP:
+        case OP_CALL:
+        case OP_SE_VX_NN:
+        case OP_SNE_VX_NN:
+        case OP_SE_VX_VY:
+        case OP_SNE_VX_VY:
+        case OP_JP_V0_NNN:
+        case OP_SKP_VX:
+        case OP_SKNP_VX:
+        case OP_LD_VX_K:
+        case OP_LD_B_VX:
+        case OP_LD_I_VX:
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+Jit::Jit(CPU& target_cpu, Display& target_display, InputSource& target_input)
+    : cpu(target_cpu), display(target_display), input(&target_input) {
+    code_cache = nullptr;
+    code_used = 0;
+    blocks_compiled = 0;
+    blocks.resize(CHIP8_MEMORY_SIZE);
+    coverage.assign(CHIP8_MEMORY_SIZE, 0);
+
+#if CHIP8_JIT_SUPPORTED
+    void* memory = mmap(nullptr, JIT_CODE_CACHE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED) {
+        code_cache = static_cast<uint8_t*>(memory);
+    }
+#endif
+
+    cpu.attach_jit(this);
+}
+
+Jit::~Jit() {
+    cpu.attach_jit(nullptr);
+#if CHIP8_JIT_SUPPORTED
+    if (code_cache != nullptr) {
+        munmap(code_cache, JIT_CODE_CACHE_SIZE);
+    }
+#endif
+}
+
+bool Jit::is_available() const { return code_cache != nullptr; }
+
+uint64_t Jit::get_blocks_compiled() const { return blocks_compiled; }
+
+void Jit::set_input(InputSource& new_input) {
+    input = &new_input;
+    flush();
+}
+
+void Jit::flush() {
+    for (int i = 0; i < CHIP8_MEMORY_SIZE; i++) {
+        if (blocks[i]) {
+            retired.push_back(std::move(blocks[i]));
+        }
+    }
+    coverage.assign(CHIP8_MEMORY_SIZE, 0);
+    code_used = 0;
+}
+
+void Jit::retire(uint16_t start) {
+    JitBlock* block = blocks[start].get();
+    for (int address = block->start; address < block->end; address++) {
+        coverage[address] -= 1;
+    }
+    // The block may be the one currently executing, so keep it alive until run_block returns
+    retired.push_back(std::move(blocks[start]));
+}
+
+void Jit::invalidate(uint16_t address) {
+    if (address >= CHIP8_MEMORY_SIZE || coverage[address] == 0) {
+        return;
+    }
+
+    // Any block covering the address must start within one maximum block length before it
+    int first = address - JIT_MAX_BLOCK_INSTRUCTIONS * 2;
+    if (first < 0) { first = 0; }
+    for (int start = first; start <= address; start++) {
+        if (blocks[start] && blocks[start]->end > address) {
+            retire(start);
+        }
+    }
+}
+
+int Jit::run_block(int max_instructions) {
+    // Blocks are compiled against the CHIP-8 instruction set only
+    if (code_cache == nullptr || cpu.paused || cpu.halted || cpu.variant != Chip8Variant::Chip8) {
+        return 0;
+    }
+
+    uint16_t start = cpu.program_counter;
+    if (start + 1 >= CHIP8_MEMORY_SIZE) {
+        return 0;
+    }
+
+    JitBlock* block = blocks[start].get();
+    if (block == nullptr) {
+        block = compile(start);
+        if (block == nullptr) {
+            return 0;
+        }
+    }
+
+    if (block->instruction_count > max_instructions) {
+        return 0;
+    }
+
+    int executed = block->instruction_count;
+#if CHIP8_JIT_SUPPORTED
+    reinterpret_cast<void (*)()>(const_cast<uint8_t*>(block->code))();
+#endif
+    retired.clear();
+    return executed;
+}
+
+JitBlock* Jit::compile(uint16_t start) {
+    std::unique_ptr<JitBlock> block(new JitBlock());
+    block->start = start;
+    block->call_outs.reserve(JIT_MAX_BLOCK_INSTRUCTIONS);
+
+    CodeEmitter emit;
+    // push rbx; rbx = &registers[0] for the whole block (rbx survives handler calls)
+    emit.byte(0x53);
+    emit.mov_reg_imm64(RBX, cpu.registers);
+
+    uint16_t address = start;
+    bool terminated = false;
+    int count = 0;
+    while (count < JIT_MAX_BLOCK_INSTRUCTIONS && address + 1 < CHIP8_MEMORY_SIZE && !terminated) {
+        uint16_t instruction = (cpu.memory[address] << 8) | cpu.memory[address + 1];
+        DecodedInstruction decoded = CPU::decode_instruction(instruction);
+        uint16_t next = address + 2;
+        uint8_t x = decoded.x;
+        uint8_t y = decoded.y;
+        bool touches_flag = (x == FLAG_REGISTER || y == FLAG_REGISTER);
+
+        switch (decoded.operation) {
+            case OP_NOP:
+                break;
+            case OP_JP:
+                emit.store_word(&cpu.program_counter, decoded.nnn);
+                break;
+            case OP_LD_VX_NN:
+                // mov byte [rbx+x], nn
+                emit.bytes_of({0xC6, 0x43, x, decoded.nn});
+                break;
+            case OP_ADD_VX_NN:
+                // add byte [rbx+x], nn
+                emit.bytes_of({0x80, 0x43, x, decoded.nn});
+                break;
+            case OP_LD_VX_VY:
+                // mov al, [rbx+y]; mov [rbx+x], al
+                emit.bytes_of({0x8A, 0x43, y, 0x88, 0x43, x});
+                break;
+            case OP_AND_VX_VY:
+                // mov al, [rbx+y]; and [rbx+x], al
+                emit.bytes_of({0x8A, 0x43, y, 0x20, 0x43, x});
+                break;
+            case OP_XOR_VX_VY:
+                // mov al, [rbx+y]; xor [rbx+x], al
+                emit.bytes_of({0x8A, 0x43, y, 0x30, 0x43, x});
+                break;
+            case OP_ADD_VX_VY:
+                // movzx eax, [rbx+x]; movzx ecx, [rbx+y]; add eax, ecx; mov [rbx+x], al; shr eax, 8; mov [rbx+F], al
+                emit.bytes_of({0x0F, 0xB6, 0x43, x, 0x0F, 0xB6, 0x4B, y, 0x01, 0xC8,
+                               0x88, 0x43, x, 0xC1, 0xE8, 0x08, 0x88, 0x43, (uint8_t) FLAG_REGISTER});
+                break;
+            case OP_LD_I_NNN:
+                emit.store_word(&cpu.index_register, decoded.nnn);
+                break;
+            default:
+                if (decoded.operation == OP_SUB_VX_VY && !touches_flag) {
+                    // movzx eax, [rbx+x]; movzx ecx, [rbx+y]; xor edx, edx; cmp eax, ecx; seta dl;
+                    // sub eax, ecx; mov [rbx+F], dl; mov [rbx+x], al
+                    emit.bytes_of({0x0F, 0xB6, 0x43, x, 0x0F, 0xB6, 0x4B, y, 0x31, 0xD2, 0x39, 0xC8,
+                                   0x0F, 0x97, 0xC2, 0x29, 0xC8, 0x88, 0x53, (uint8_t) FLAG_REGISTER, 0x88, 0x43, x});
+                    break;
+                }
+
+                // Call the interpreter's handler with the program counter it would see
+                block->call_outs.push_back(decoded);
+                emit.store_word(&cpu.program_counter, next);
+                emit.mov_reg_imm64(RDI, &cpu);
+                emit.mov_reg_imm64(RSI, &block->call_outs.back());
+                emit.mov_reg_imm64(RDX, &display);
+                emit.mov_reg_imm64(RCX, input);
+                emit.mov_reg_imm64(RAX, reinterpret_cast<const void*>(decoded.handler));
+                emit.bytes_of({0xFF, 0xD0}); // call rax
+                break;
+        }
+
+        terminated = ends_block(decoded.operation);
+        address = next;
+        count += 1;
+    }
+
+    // Blocks cut short by the length limit still need the program counter moved on
+    if (!terminated) {
+        emit.store_word(&cpu.program_counter, address);
+    }
+
+    // pop rbx; ret
+    emit.bytes_of({0x5B, 0xC3});
+
+    if (code_used + emit.bytes.size() > JIT_CODE_CACHE_SIZE) {
+        flush();
+        if (emit.bytes.size() > JIT_CODE_CACHE_SIZE) {
+            return nullptr;
+        }
+    }
+
+    memcpy(code_cache + code_used, emit.bytes.data(), emit.bytes.size());
+    block->code = code_cache + code_used;
+    code_used += emit.bytes.size();
+
+    block->end = address;
+    block->instruction_count = count;
+    for (int covered = start; covered < address; covered++) {
+        coverage[covered] += 1;
+    }
+
+    blocks_compiled += 1;
+    blocks[start] = std::move(block);
+    return blocks[start].get();
+}
@@ -0,0 +1,75 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <cstddef> // For size_t
+#include <cstdint> // For uint8_t and uint16_t
+#include <memory>  // For std::unique_ptr
+#include <vector>  // For per-block call-out data
+#include "cpu.h"
+
+class Display;
+class InputSource;
+
+// Longest run of instructions compiled into a single block
+const int JIT_MAX_BLOCK_INSTRUCTIONS = 32;
+// Size of the executable code cache; it is flushed wholesale when it fills up
+const size_t JIT_CODE_CACHE_SIZE = 1 << 20;
+
+// A compiled run of straight-line Chip-8 code
+struct JitBlock {
+    uint16_t start;             // Address of the first instruction
+    uint16_t end;               // One past the last byte covered
+    int instruction_count;      // Cycles the block accounts for when run
+    const uint8_t* code;        // Entry point inside the code cache
+    std::vector<DecodedInstruction> call_outs; // Operands handed to handlers the block calls
+};
+
+// Dynamic recompiler that translates Chip-8 basic blocks into x86-64 code.
+// Simple register and ALU operations are emitted inline; everything else calls the
+// interpreter's handlers so drawing and key checks still go through Display and InputSource.
+// Blocks end at any instruction that can change control flow (jumps, calls, returns, skips,
+// FX0A) or write memory, and are dropped when memory they cover is written.
+// Only the CHIP-8 variant is compiled; run_block does nothing for SUPER-CHIP and XO-CHIP.
+// On hosts other than x86-64 Linux/macOS is_available() is false and run_block never runs code.
+class Jit {
+public:
+    Jit(CPU& cpu, Display& display, InputSource& input);
+    ~Jit();
+
+    bool is_available() const;
+
+    // Run the block starting at the current program counter, compiling it first if needed.
+    // Returns the number of instructions executed, or 0 if the block is longer than
+    // max_instructions (or cannot be compiled) and the caller should interpret instead.
+    int run_block(int max_instructions);
+
+    // Drop every block that covers the given address
+    void invalidate(uint16_t address);
+
+    // Drop every block and reset the code cache
+    void flush();
+
+    // Blocks embed the input source address, so changing it means recompiling
+    void set_input(InputSource& input);
+
+    // Number of blocks compiled since construction (for reporting)
+    uint64_t get_blocks_compiled() const;
+
+private:
+    CPU& cpu;
+    Display& display;
+    InputSource* input;
+
+    uint8_t* code_cache;
+    size_t code_used;
+    uint64_t blocks_compiled;
+
+    std::vector<std::unique_ptr<JitBlock>> blocks;  // Indexed by start address
+    std::vector<uint16_t> coverage;                 // Number of live blocks covering each byte
+    std::vector<std::unique_ptr<JitBlock>> retired; // Invalidated while possibly still running
+
+    JitBlock* compile(uint16_t start);
+    void retire(uint16_t start);
+};
+
+#endif // JIT_H
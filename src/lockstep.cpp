@@ -0,0 +1,509 @@
+#include "lockstep.h"
+#include "opcodes.h"
+#include <chrono> // For timing batch runs
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h> // For the AVX2/SSE2 intrinsics
+#endif
+
+namespace {
+
+// What a lane can do next, kept next to the lane arrays so scheduling never touches the CPUs
+enum LaneState : uint8_t {
+    LANE_RUNNING,
+    LANE_PAUSED, // Waiting on Fx0A
+    LANE_HALTED
+};
+
+// One byte per lane for every lane at once: a single AVX2 register, two SSE2 registers,
+// or a plain array the compiler may vectorize on its own.
+#if defined(__AVX2__)
+
+struct LaneBytes { __m256i v; };
+
+inline LaneBytes lanes_load(const uint8_t* p) { return {_mm256_load_si256(reinterpret_cast<const __m256i*>(p))}; }
+inline void lanes_store(uint8_t* p, LaneBytes a) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), a.v); }
+inline LaneBytes lanes_splat(uint8_t value) { return {_mm256_set1_epi8((char) value)}; }
+inline LaneBytes lanes_add(LaneBytes a, LaneBytes b) { return {_mm256_add_epi8(a.v, b.v)}; }
+inline LaneBytes lanes_sub(LaneBytes a, LaneBytes b) { return {_mm256_sub_epi8(a.v, b.v)}; }
+inline LaneBytes lanes_and(LaneBytes a, LaneBytes b) { return {_mm256_and_si256(a.v, b.v)}; }
+inline LaneBytes lanes_xor(LaneBytes a, LaneBytes b) { return {_mm256_xor_si256(a.v, b.v)}; }
+inline LaneBytes lanes_eq(LaneBytes a, LaneBytes b) { return {_mm256_cmpeq_epi8(a.v, b.v)}; }
+inline LaneBytes lanes_max(LaneBytes a, LaneBytes b) { return {_mm256_max_epu8(a.v, b.v)}; }
+inline LaneBytes lanes_shr1(LaneBytes a) { return {_mm256_and_si256(_mm256_srli_epi16(a.v, 1), _mm256_set1_epi8(0x7F))}; }
+inline LaneBytes lanes_select(LaneBytes mask, LaneBytes a, LaneBytes b) { return {_mm256_blendv_epi8(b.v, a.v, mask.v)}; }
+
+#elif defined(__SSE2__)
+
+struct LaneBytes { __m128i lo, hi; };
+
+inline LaneBytes lanes_load(const uint8_t* p) {
+    return {_mm_load_si128(reinterpret_cast<const __m128i*>(p)), _mm_load_si128(reinterpret_cast<const __m128i*>(p + 16))};
+}
+inline void lanes_store(uint8_t* p, LaneBytes a) {
+    _mm_store_si128(reinterpret_cast<__m128i*>(p), a.lo);
+    _mm_store_si128(reinterpret_cast<__m128i*>(p + 16), a.hi);
+}
+inline LaneBytes lanes_splat(uint8_t value) { return {_mm_set1_epi8((char) value), _mm_set1_epi8((char) value)}; }
+inline LaneBytes lanes_add(LaneBytes a, LaneBytes b) { return {_mm_add_epi8(a.lo, b.lo), _mm_add_epi8(a.hi, b.hi)}; }
+inline LaneBytes lanes_sub(LaneBytes a, LaneBytes b) { return {_mm_sub_epi8(a.lo, b.lo), _mm_sub_epi8(a.hi, b.hi)}; }
+inline LaneBytes lanes_and(LaneBytes a, LaneBytes b) { return {_mm_and_si128(a.lo, b.lo), _mm_and_si128(a.hi, b.hi)}; }
+inline LaneBytes lanes_xor(LaneBytes a, LaneBytes b) { return {_mm_xor_si128(a.lo, b.lo), _mm_xor_si128(a.hi, b.hi)}; }
+inline LaneBytes lanes_eq(LaneBytes a, LaneBytes b) { return {_mm_cmpeq_epi8(a.lo, b.lo), _mm_cmpeq_epi8(a.hi, b.hi)}; }
+inline LaneBytes lanes_max(LaneBytes a, LaneBytes b) { return {_mm_max_epu8(a.lo, b.lo), _mm_max_epu8(a.hi, b.hi)}; }
+inline LaneBytes lanes_shr1(LaneBytes a) {
+    __m128i low_bits = _mm_set1_epi8(0x7F);
+    return {_mm_and_si128(_mm_srli_epi16(a.lo, 1), low_bits), _mm_and_si128(_mm_srli_epi16(a.hi, 1), low_bits)};
+}
+inline LaneBytes lanes_select(LaneBytes mask, LaneBytes a, LaneBytes b) {
+    return {_mm_or_si128(_mm_and_si128(mask.lo, a.lo), _mm_andnot_si128(mask.lo, b.lo)),
+            _mm_or_si128(_mm_and_si128(mask.hi, a.hi), _mm_andnot_si128(mask.hi, b.hi))};
+}
+
+#else
+
+struct LaneBytes { uint8_t v[LOCKSTEP_LANES]; };
+
+template <typename Op>
+inline LaneBytes lanes_map(LaneBytes a, LaneBytes b, Op op) {
+    LaneBytes result;
+    for (int i = 0; i < LOCKSTEP_LANES; i++) { result.v[i] = op(a.v[i], b.v[i]); }
+    return result;
+}
+
+inline LaneBytes lanes_load(const uint8_t* p) {
+    LaneBytes result;
+    for (int i = 0; i < LOCKSTEP_LANES; i++) { result.v[i] = p[i]; }
+    return result;
+}
+inline void lanes_store(uint8_t* p, LaneBytes a) {
+    for (int i = 0; i < LOCKSTEP_LANES; i++) { p[i] = a.v[i]; }
+}
+inline LaneBytes lanes_splat(uint8_t value) {
+    LaneBytes result;
+    for (int i = 0; i < LOCKSTEP_LANES; i++) { result.v[i] = value; }
+    return result;
+}
+inline LaneBytes lanes_add(LaneBytes a, LaneBytes b) { return lanes_map(a, b, [](uint8_t x, uint8_t y) { return (uint8_t) (x + y); }); }
+inline LaneBytes lanes_sub(LaneBytes a, LaneBytes b) { return lanes_map(a, b, [](uint8_t x, uint8_t y) { return (uint8_t) (x - y); }); }
+inline LaneBytes lanes_and(LaneBytes a, LaneBytes b) { return lanes_map(a, b, [](uint8_t x, uint8_t y) { return (uint8_t) (x & y); }); }
+inline LaneBytes lanes_xor(LaneBytes a, LaneBytes b) { return lanes_map(a, b, [](uint8_t x, uint8_t y) { return (uint8_t) (x ^ y); }); }
+inline LaneBytes lanes_eq(LaneBytes a, LaneBytes b) { return lanes_map(a, b, [](uint8_t x, uint8_t y) { return (uint8_t) (x == y ? 0xFF : 0); }); }
+inline LaneBytes lanes_max(LaneBytes a, LaneBytes b) { return lanes_map(a, b, [](uint8_t x, uint8_t y) { return x > y ? x : y; }); }
+inline LaneBytes lanes_shr1(LaneBytes a) { return lanes_map(a, a, [](uint8_t x, uint8_t) { return (uint8_t) (x >> 1); }); }
+inline LaneBytes lanes_select(LaneBytes mask, LaneBytes a, LaneBytes b) {
+    return lanes_map(lanes_and(mask, a), lanes_and(lanes_xor(mask, lanes_splat(0xFF)), b),
+                     [](uint8_t x, uint8_t y) { return (uint8_t) (x | y); });
+}
+
+#endif
+
+// 0xFF in lanes where a > b (unsigned), 0 elsewhere
+inline LaneBytes lanes_greater(LaneBytes a, LaneBytes b) {
+    return lanes_xor(lanes_eq(lanes_max(a, b), b), lanes_splat(0xFF));
+}
+
+// Write value into the masked lanes of p, leaving the other lanes untouched
+inline void lanes_store_masked(uint8_t* p, LaneBytes value, LaneBytes mask) {
+    lanes_store(p, lanes_select(mask, value, lanes_load(p)));
+}
+
+} // namespace
+
+LockstepEngine::LockstepEngine(int count) {
+    if (count < 1) { count = 1; }
+    if (count > LOCKSTEP_LANES) { count = LOCKSTEP_LANES; }
+    lane_count = count;
+    cycles_per_frame = DEFAULT_CYCLES_PER_FRAME;
+    new_functionality = false;
+    total_instructions = 0;
+    total_frames = 0;
+    vector_steps = 0;
+    scalar_steps = 0;
+
+    // Unused lanes stay zeroed so the vector ops never see uninitialised bytes
+    for (int r = 0; r < REGISTER_COUNT; r++) {
+        for (int lane = 0; lane < LOCKSTEP_LANES; lane++) { registers[r][lane] = 0; }
+    }
+    for (int lane = 0; lane < LOCKSTEP_LANES; lane++) {
+        program_counter[lane] = 0;
+        index_register[lane] = 0;
+        delay_timer[lane] = 0;
+        sound_timer[lane] = 0;
+        lane_state[lane] = LANE_HALTED;
+        memory_written[lane] = false;
+    }
+
+    for (int lane = 0; lane < lane_count; lane++) {
+        default_inputs.emplace_back(new ScriptedInput());
+        lanes.emplace_back(new Machine(*default_inputs.back()));
+        store_lane(lane);
+    }
+}
+
+int LockstepEngine::get_lane_count() const { return lane_count; }
+
+void LockstepEngine::load_program(const uint8_t program[], int size) {
+    for (int lane = 0; lane < lane_count; lane++) {
+        lanes[lane]->load_program(program, size);
+        memory_written[lane] = false;
+        store_lane(lane);
+    }
+}
+
+void LockstepEngine::set_input(int lane, InputSource& input) {
+    lanes[lane]->set_input(input);
+}
+
+void LockstepEngine::seed_random(int lane, uint64_t seed) {
+    lanes[lane]->get_cpu().seed_random(seed);
+}
+
+void LockstepEngine::set_cycles_per_frame(int cycles) {
+    if (cycles > 0) {
+        cycles_per_frame = cycles;
+    }
+}
+
+void LockstepEngine::set_new_functionality(bool enabled) {
+    new_functionality = enabled;
+    for (int lane = 0; lane < lane_count; lane++) {
+        lanes[lane]->get_cpu().set_new_functionality(enabled);
+    }
+}
+
+void LockstepEngine::load_lane(int lane) {
+    CPU& cpu = lanes[lane]->get_cpu();
+    for (int r = 0; r < REGISTER_COUNT; r++) {
+        cpu.registers[r] = registers[r][lane];
+    }
+    cpu.program_counter = program_counter[lane];
+    cpu.index_register = index_register[lane];
+    cpu.delay_timer = delay_timer[lane];
+    cpu.sound_timer = sound_timer[lane];
+}
+
+void LockstepEngine::store_lane(int lane) {
+    const CPU& cpu = lanes[lane]->get_cpu();
+    for (int r = 0; r < REGISTER_COUNT; r++) {
+        registers[r][lane] = cpu.registers[r];
+    }
+    program_counter[lane] = cpu.program_counter;
+    index_register[lane] = cpu.index_register;
+    delay_timer[lane] = cpu.delay_timer;
+    sound_timer[lane] = cpu.sound_timer;
+    lane_state[lane] = cpu.halted ? LANE_HALTED : (cpu.paused ? LANE_PAUSED : LANE_RUNNING);
+}
+
+void LockstepEngine::step_lane(int lane) {
+    Machine& machine = *lanes[lane];
+    if (machine.get_cpu().is_halted()) {
+        return;
+    }
+
+    // Remember lanes whose memory may no longer match the others
+    const CPU& cpu = machine.get_cpu();
+    uint16_t pc = program_counter[lane];
+    if (lane_state[lane] == LANE_RUNNING && pc + 1 < CHIP8_MEMORY_SIZE) {
+        uint8_t operation = DECODE_TABLE[(cpu.memory[pc] << 8) | cpu.memory[pc + 1]];
+        if (operation == OP_LD_B_VX || operation == OP_LD_I_VX) {
+            memory_written[lane] = true;
+        }
+    }
+
+    load_lane(lane);
+    if (machine.step()) {
+        total_instructions += 1;
+        scalar_steps += 1;
+    }
+    store_lane(lane);
+}
+
+bool LockstepEngine::step_vector(const DecodedInstruction& d, const uint8_t* mask_bytes) {
+    LaneBytes mask = lanes_load(mask_bytes);
+    uint8_t* vx = registers[d.x];
+    uint8_t* vy = registers[d.y];
+    uint8_t* vf = registers[FLAG_REGISTER];
+    LaneBytes one = lanes_splat(1);
+
+    // Extra program counter advance per lane for the skip instructions (0 or 2)
+    alignas(32) uint8_t skip[LOCKSTEP_LANES] = {};
+
+    // Registers are reloaded after every partial write, so instructions whose x or y is VF
+    // see the same intermediate values as the interpreter does
+    switch (d.operation) {
+        case OP_NOP:
+            break;
+        case OP_LD_VX_NN:
+            lanes_store_masked(vx, lanes_splat(d.nn), mask);
+            break;
+        case OP_ADD_VX_NN:
+            lanes_store_masked(vx, lanes_add(lanes_load(vx), lanes_splat(d.nn)), mask);
+            break;
+        case OP_LD_VX_VY:
+            lanes_store_masked(vx, lanes_load(vy), mask);
+            break;
+        case OP_AND_VX_VY:
+            lanes_store_masked(vx, lanes_and(lanes_load(vx), lanes_load(vy)), mask);
+            break;
+        case OP_XOR_VX_VY:
+            lanes_store_masked(vx, lanes_xor(lanes_load(vx), lanes_load(vy)), mask);
+            break;
+        case OP_ADD_VX_VY: {
+            LaneBytes x = lanes_load(vx);
+            LaneBytes y = lanes_load(vy);
+            // x + y carries exactly when x > 255 - y
+            LaneBytes carry = lanes_and(lanes_greater(x, lanes_xor(y, lanes_splat(0xFF))), one);
+            lanes_store_masked(vx, lanes_add(x, y), mask);
+            lanes_store_masked(vf, carry, mask);
+            break;
+        }
+        case OP_SUB_VX_VY:
+        case OP_SUBN_VX_VY: {
+            lanes_store_masked(vf, lanes_splat(0), mask);
+            LaneBytes flag = lanes_and(lanes_greater(lanes_load(vx), lanes_load(vy)), one);
+            lanes_store_masked(vf, flag, mask);
+            LaneBytes x = lanes_load(vx);
+            LaneBytes y = lanes_load(vy);
+            lanes_store_masked(vx, d.operation == OP_SUB_VX_VY ? lanes_sub(x, y) : lanes_sub(y, x), mask);
+            break;
+        }
+        case OP_SHR_VX_VY:
+        case OP_SHL_VX_VY: {
+            if (new_functionality) { lanes_store_masked(vx, lanes_load(vy), mask); }
+            lanes_store_masked(vf, lanes_splat(0), mask);
+            LaneBytes x = lanes_load(vx);
+            // Low bit for a right shift, high bit (x > 0x7F) for a left shift
+            LaneBytes flag = d.operation == OP_SHR_VX_VY ? lanes_and(x, one)
+                                                         : lanes_and(lanes_greater(x, lanes_splat(0x7F)), one);
+            lanes_store_masked(vf, flag, mask);
+            x = lanes_load(vx);
+            lanes_store_masked(vx, d.operation == OP_SHR_VX_VY ? lanes_shr1(x) : lanes_add(x, x), mask);
+            break;
+        }
+        case OP_SE_VX_NN:
+            lanes_store(skip, lanes_and(lanes_eq(lanes_load(vx), lanes_splat(d.nn)), lanes_splat(2)));
+            break;
+        case OP_SNE_VX_NN:
+            lanes_store(skip, lanes_and(lanes_xor(lanes_eq(lanes_load(vx), lanes_splat(d.nn)), lanes_splat(0xFF)), lanes_splat(2)));
+            break;
+        case OP_SE_VX_VY:
+            lanes_store(skip, lanes_and(lanes_eq(lanes_load(vx), lanes_load(vy)), lanes_splat(2)));
+            break;
+        case OP_SNE_VX_VY:
+            lanes_store(skip, lanes_and(lanes_xor(lanes_eq(lanes_load(vx), lanes_load(vy)), lanes_splat(0xFF)), lanes_splat(2)));
+            break;
+        case OP_LD_VX_DT:
+            lanes_store_masked(vx, lanes_load(delay_timer), mask);
+            break;
+        case OP_LD_DT_VX:
+            lanes_store_masked(delay_timer, lanes_load(vx), mask);
+            break;
+        case OP_LD_ST_VX:
+            lanes_store_masked(sound_timer, lanes_load(vx), mask);
+            break;
+        case OP_JP:
+            for (int lane = 0; lane < LOCKSTEP_LANES; lane++) {
+                if (mask_bytes[lane]) { program_counter[lane] = d.nnn; }
+            }
+            return true;
+        case OP_LD_I_NNN:
+            for (int lane = 0; lane < LOCKSTEP_LANES; lane++) {
+                if (mask_bytes[lane]) { index_register[lane] = d.nnn; }
+            }
+            break;
+        case OP_LD_F_VX:
+            for (int lane = 0; lane < LOCKSTEP_LANES; lane++) {
+                if (mask_bytes[lane]) { index_register[lane] = vx[lane] * 5; }
+            }
+            break;
+        default:
+            // Display, keypad, stack, memory and RNG instructions run per lane
+            return false;
+    }
+
+    // Branch-free so the compiler can vectorise the 16-bit update as well
+    for (int lane = 0; lane < LOCKSTEP_LANES; lane++) {
+        program_counter[lane] += (2 + skip[lane]) & mask_bytes[lane];
+    }
+    return true;
+}
+
+int LockstepEngine::run_group(const uint8_t* mask, int leader, int budget, uint16_t stop_pc, bool check_memory) {
+    // Keep the group together for as long as it stays on one PC and on vector instructions,
+    // handing over once it reaches a PC where lanes outside the group are waiting
+    const uint8_t* leader_memory = lanes[leader]->get_cpu().memory;
+    int executed = 0;
+    while (executed < budget) {
+        uint16_t pc = program_counter[leader];
+        if (pc + 1 >= CHIP8_MEMORY_SIZE || (executed > 0 && pc >= stop_pc)) {
+            break;
+        }
+
+        uint16_t instruction = (leader_memory[pc] << 8) | leader_memory[pc + 1];
+        if (check_memory) {
+            bool same_instruction = true;
+            for (int lane = 0; lane < lane_count && same_instruction; lane++) {
+                const uint8_t* memory = lanes[lane]->get_cpu().memory;
+                same_instruction = !mask[lane] || ((memory[pc] << 8) | memory[pc + 1]) == instruction;
+            }
+            if (!same_instruction) {
+                break;
+            }
+        }
+
+        DecodedInstruction decoded = CPU::decode_instruction(instruction);
+        if (!step_vector(decoded, mask)) {
+            break;
+        }
+        executed += 1;
+        vector_steps += 1;
+
+        // Only a skip can send lanes of the group to different PCs
+        if (decoded.operation == OP_SE_VX_NN || decoded.operation == OP_SNE_VX_NN ||
+            decoded.operation == OP_SE_VX_VY || decoded.operation == OP_SNE_VX_VY) {
+            bool together = true;
+            for (int lane = 0; lane < lane_count; lane++) {
+                together &= !mask[lane] || program_counter[lane] == program_counter[leader];
+            }
+            if (!together) {
+                break;
+            }
+        }
+    }
+    return executed;
+}
+
+void LockstepEngine::run_frame() {
+    for (int lane = 0; lane < lane_count; lane++) {
+        lanes[lane]->get_input().poll_events();
+    }
+
+    int remaining[LOCKSTEP_LANES] = {};
+    for (int lane = 0; lane < lane_count; lane++) {
+        remaining[lane] = cycles_per_frame;
+    }
+
+    alignas(32) uint8_t mask[LOCKSTEP_LANES];
+    while (true) {
+        // Lanes that cannot join a group take their cycle on their own; of the rest,
+        // the one furthest behind leads
+        int leader = -1;
+        bool stepped_alone = false;
+        for (int lane = 0; lane < lane_count; lane++) {
+            if (remaining[lane] == 0) {
+                continue;
+            }
+            if (lane_state[lane] == LANE_HALTED) {
+                remaining[lane] = 0;
+            } else if (lane_state[lane] == LANE_PAUSED || program_counter[lane] + 1 >= CHIP8_MEMORY_SIZE) {
+                step_lane(lane);
+                remaining[lane] -= 1;
+                stepped_alone = true;
+            } else if (leader < 0 || program_counter[lane] < program_counter[leader]) {
+                leader = lane;
+            }
+        }
+        if (leader < 0) {
+            // A lane that just left Fx0A may still have cycles to run
+            if (stepped_alone) {
+                continue;
+            }
+            break;
+        }
+
+        // Group every runnable lane at the leader's PC. Lanes that have written memory are
+        // checked for the same instruction; all others still hold the loaded program.
+        uint16_t pc = program_counter[leader];
+        const uint8_t* leader_memory = lanes[leader]->get_cpu().memory;
+        uint16_t instruction = (leader_memory[pc] << 8) | leader_memory[pc + 1];
+        int group_size = 0;
+        int budget = cycles_per_frame;
+        bool check_memory = false;
+        uint16_t next_pc = 0xFFFF; // Lowest PC among runnable lanes left out of the group
+        for (int lane = 0; lane < LOCKSTEP_LANES; lane++) {
+            mask[lane] = 0;
+            if (lane >= lane_count || remaining[lane] == 0 || lane_state[lane] != LANE_RUNNING) {
+                continue;
+            }
+            bool same_instruction = program_counter[lane] == pc;
+            if (same_instruction && (memory_written[lane] || memory_written[leader])) {
+                const uint8_t* memory = lanes[lane]->get_cpu().memory;
+                same_instruction = ((memory[pc] << 8) | memory[pc + 1]) == instruction;
+                check_memory = true;
+            }
+            if (!same_instruction) {
+                if (program_counter[lane] < next_pc) { next_pc = program_counter[lane]; }
+                continue;
+            }
+            mask[lane] = 0xFF;
+            group_size += 1;
+            if (remaining[lane] < budget) { budget = remaining[lane]; }
+        }
+
+        int executed = group_size > 1 ? run_group(mask, leader, budget, next_pc, check_memory) : 0;
+        if (executed > 0) {
+            total_instructions += (uint64_t) executed * group_size;
+            for (int lane = 0; lane < lane_count; lane++) {
+                if (mask[lane]) { remaining[lane] -= executed; }
+            }
+        } else {
+            for (int lane = 0; lane < lane_count; lane++) {
+                if (mask[lane]) {
+                    step_lane(lane);
+                    remaining[lane] -= 1;
+                }
+            }
+        }
+    }
+
+    // Timers tick once per frame except in lanes waiting on Fx0A
+    for (int lane = 0; lane < LOCKSTEP_LANES; lane++) {
+        mask[lane] = lane < lane_count && lane_state[lane] != LANE_PAUSED ? 0xFF : 0;
+    }
+    LaneBytes ticking = lanes_load(mask);
+    LaneBytes one = lanes_splat(1);
+    LaneBytes delay = lanes_load(delay_timer);
+    LaneBytes sound = lanes_load(sound_timer);
+    // Saturating decrement: lanes already at zero subtract zero
+    lanes_store_masked(delay_timer, lanes_sub(delay, lanes_and(lanes_greater(delay, lanes_splat(0)), one)), ticking);
+    lanes_store_masked(sound_timer, lanes_sub(sound, lanes_and(lanes_greater(sound, lanes_splat(0)), one)), ticking);
+
+    total_frames += 1;
+}
+
+RunStats LockstepEngine::run_frames(uint64_t frames) {
+    uint64_t start_instructions = total_instructions;
+    uint64_t start_frames = total_frames;
+    auto start_time = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < frames; i++) {
+        // Stop early only once every lane's input has asked to quit
+        bool all_quit = true;
+        for (int lane = 0; lane < lane_count && all_quit; lane++) {
+            all_quit = lanes[lane]->get_input().should_quit();
+        }
+        if (all_quit) {
+            break;
+        }
+        run_frame();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    RunStats stats = {};
+    stats.frames = total_frames - start_frames;
+    stats.cycles = stats.frames * cycles_per_frame * lane_count;
+    stats.instructions = total_instructions - start_instructions;
+    stats.seconds = elapsed.count();
+    stats.instructions_per_second = stats.seconds > 0 ? stats.instructions / stats.seconds : 0;
+    return stats;
+}
+
+Machine& LockstepEngine::get_lane(int lane) {
+    load_lane(lane);
+    return *lanes[lane];
+}
+
+uint64_t LockstepEngine::get_total_instructions() const { return total_instructions; }
+uint64_t LockstepEngine::get_vector_steps() const { return vector_steps; }
+uint64_t LockstepEngine::get_scalar_steps() const { return scalar_steps; }
@@ -0,0 +1,83 @@
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include <cstdint> // For uint8_t, uint16_t and uint64_t
+#include <memory>  // For std::unique_ptr
+#include <vector>  // For the lane machines
+#include "cpu.h"
+#include "machine.h"
+
+// Instances advanced together by one LockstepEngine (one AVX2 register of 8-bit lanes)
+const int LOCKSTEP_LANES = 32;
+
+// Runs up to LOCKSTEP_LANES instances of the same ROM in lockstep. The hot CPU state
+// (V registers, I, PC and timers) lives in structure-of-arrays form, one array per field
+// with one element per lane, so when several lanes are at the same instruction it is
+// executed for all of them at once with SIMD (AVX2, SSE2, or a plain loop otherwise).
+// Lanes at other PCs are masked off, and instructions that touch the display, keypad,
+// stack, memory or RNG go through the normal interpreter one lane at a time.
+// Lanes always run the CHIP-8 variant.
+class LockstepEngine {
+public:
+    // lane_count instances, each reading keys from its own input source
+    explicit LockstepEngine(int lane_count);
+
+    int get_lane_count() const;
+
+    // Load the same program into every lane
+    void load_program(const uint8_t program[], int size);
+
+    // Give a lane its own input (e.g. a different scripted key sequence)
+    void set_input(int lane, InputSource& input);
+
+    // Give a lane its own CXNN sequence (every lane starts from DEFAULT_RNG_SEED)
+    void seed_random(int lane, uint64_t seed);
+
+    void set_cycles_per_frame(int cycles);
+    void set_new_functionality(bool enabled);
+
+    // Poll every lane's input, run one frame of cycles in every lane and tick the timers once.
+    // Lanes only interact at frame boundaries, so within a frame the lowest PC always runs
+    // first: lanes knocked out of step by a skip catch up and rejoin the group.
+    void run_frame();
+    RunStats run_frames(uint64_t frames);
+
+    // Machine for one lane, with its CPU brought up to date from the lane arrays
+    Machine& get_lane(int lane);
+
+    uint64_t get_total_instructions() const;
+    uint64_t get_vector_steps() const; // Instructions run for a whole group as one SIMD step
+    uint64_t get_scalar_steps() const; // Lane-instructions that went through the interpreter
+
+private:
+    int lane_count;
+    int cycles_per_frame;
+    bool new_functionality;
+
+    // Structure-of-arrays CPU state, indexed [field][lane]
+    alignas(32) uint8_t registers[REGISTER_COUNT][LOCKSTEP_LANES];
+    alignas(32) uint16_t program_counter[LOCKSTEP_LANES];
+    alignas(32) uint16_t index_register[LOCKSTEP_LANES];
+    alignas(32) uint8_t delay_timer[LOCKSTEP_LANES];
+    alignas(32) uint8_t sound_timer[LOCKSTEP_LANES];
+    uint8_t lane_state[LOCKSTEP_LANES];     // LaneState, mirrored from each lane's CPU
+    bool memory_written[LOCKSTEP_LANES];    // Lane has run FX33/FX55 since the program was loaded
+
+    // Memory, stack, display and pause state stay in each lane's own machine
+    std::vector<std::unique_ptr<ScriptedInput>> default_inputs;
+    std::vector<std::unique_ptr<Machine>> lanes;
+
+    uint64_t total_instructions;
+    uint64_t total_frames;
+    uint64_t vector_steps;
+    uint64_t scalar_steps;
+
+    void load_lane(int lane);  // Lane arrays -> lane CPU
+    void store_lane(int lane); // Lane CPU -> lane arrays
+    void step_lane(int lane); // One cycle through the lane's own interpreter
+    bool step_vector(const DecodedInstruction& d, const uint8_t* mask);
+    // Run the masked lanes as one group for up to budget cycles; returns the cycles run
+    int run_group(const uint8_t* mask, int leader, int budget, uint16_t stop_pc, bool check_memory);
+};
+
+#endif // LOCKSTEP_H
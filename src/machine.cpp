@@ -0,0 +1,382 @@
+#include "machine.h"
+#include "jit.h"
+#include "trace.h"
+#include <chrono>   // For timing batch runs
+#include <climits>  // For INT_MAX
+#include <sstream>  // For divergence reports
+
+Machine::Machine(InputSource& input_source) {
+    input = &input_source;
+    cycles_per_frame = DEFAULT_CYCLES_PER_FRAME;
+    total_instructions = 0;
+    total_frames = 0;
+    idle_skip = true;
+    idle_instructions_skipped = 0;
+    tracer = nullptr;
+    frame_cycles_left = 0;
+}
+
+Machine::~Machine() {}
+
+void Machine::set_input(InputSource& input_source) {
+    input = &input_source;
+    if (jit) {
+        jit->set_input(input_source);
+    }
+    if (shadow) {
+        shadow->set_input(input_source);
+    }
+}
+
+void Machine::load_program(const uint8_t program[], int size) {
+    cpu.load_program(program, size);
+    if (shadow) {
+        shadow->load_program(program, size);
+    }
+}
+
+void Machine::set_variant(Chip8Variant variant) {
+    cpu.set_variant(variant);
+    if (variant != Chip8Variant::Chip8) {
+        jit.reset();
+        shadow.reset();
+    }
+}
+
+void Machine::save_state(SaveState& state) const {
+    write_savestate_header(state, cpu.get_variant());
+    display.save_state(state.data() + SAVESTATE_DISPLAY_OFFSET);
+    cpu.save_state(state.data() + SAVESTATE_CPU_OFFSET);
+}
+
+bool Machine::load_state(const SaveState& state) {
+    // A state from another variant would not fit its memory or display modes
+    if (!is_valid_savestate(state) || savestate_variant(state) != cpu.get_variant() ||
+        !cpu.load_state(state.data() + SAVESTATE_CPU_OFFSET)) {
+        return false;
+    }
+    display.load_state(state.data() + SAVESTATE_DISPLAY_OFFSET);
+    if (shadow) {
+        shadow->load_state(state);
+    }
+    return true;
+}
+
+void Machine::save_snapshot(MachineSnapshot& snapshot) const {
+    cpu.save_snapshot(snapshot.cpu);
+    snapshot.display = display;
+    snapshot.total_instructions = total_instructions;
+    snapshot.total_frames = total_frames;
+    snapshot.idle_instructions_skipped = idle_instructions_skipped;
+}
+
+void Machine::load_snapshot(const MachineSnapshot& snapshot) {
+    cpu.load_snapshot(snapshot.cpu);
+    display = snapshot.display;
+    total_instructions = snapshot.total_instructions;
+    total_frames = snapshot.total_frames;
+    idle_instructions_skipped = snapshot.idle_instructions_skipped;
+    if (shadow) {
+        // The shadow matched this machine when the snapshot was taken
+        shadow->load_snapshot(snapshot);
+    }
+}
+
+bool Machine::enable_jit(bool enabled, bool verify) {
+    shadow.reset();
+    divergence.clear();
+    if (!enabled) {
+        jit.reset();
+        return true;
+    }
+
+    if (cpu.get_variant() != Chip8Variant::Chip8) {
+        jit.reset();
+        return false;
+    }
+    if (!jit) {
+        jit.reset(new Jit(cpu, display, *input));
+    }
+    if (!jit->is_available()) {
+        jit.reset();
+        return false;
+    }
+
+    if (verify) {
+        // Start the reference interpreter from an exact copy of the current state
+        shadow.reset(new Machine(*input));
+        shadow->cpu = cpu;
+        shadow->cpu.attach_jit(nullptr);
+        shadow->cpu.set_dispatch_mode(DispatchMode::Switch);
+        shadow->display = display;
+        shadow->cycles_per_frame = cycles_per_frame;
+    }
+    return true;
+}
+
+bool Machine::has_diverged() const { return !divergence.empty(); }
+const std::string& Machine::get_divergence() const { return divergence; }
+
+void Machine::verify_against_shadow(int cycles) {
+    // The shadow's CPU carries its own copy of the RNG, so CXNN matches without help
+    for (int i = 0; i < cycles; i++) {
+        shadow->step();
+    }
+
+    if (!cpu.same_state(shadow->cpu) || !display.same_state(shadow->display)) {
+        std::ostringstream report;
+        report << "JIT diverged from the interpreter after " << total_instructions
+               << " instructions (block ending at PC 0x" << std::hex << shadow->cpu.get_program_counter() << ")";
+        divergence = report.str();
+        shadow.reset();
+    }
+}
+
+void Machine::skip_idle_loop(uint64_t& cycles) {
+    int limit = cycles > INT_MAX ? INT_MAX : (int) cycles;
+    int executed = 0;
+    int length = cpu.probe_idle_loop(display, *input, limit, executed);
+    uint64_t skipped = 0;
+    if (length > 0) {
+        // Whole iterations leave the state untouched; the remainder runs normally below
+        skipped = (uint64_t) (limit - executed) / length * length;
+        idle_instructions_skipped += skipped;
+    }
+    total_instructions += executed + skipped;
+    cycles -= executed + skipped;
+
+    // The reference interpreter really runs every skipped iteration, checking the shortcut
+    if (shadow) {
+        verify_against_shadow(executed + skipped);
+    }
+}
+
+void Machine::set_tracer(TraceWriter* trace_writer) { tracer = trace_writer; }
+
+void Machine::execute_traced(uint64_t cycles) {
+    for (; cycles > 0 && !cpu.is_halted(); cycles--) {
+        bool runs_instruction = !cpu.is_paused();
+        uint16_t pc = cpu.get_program_counter();
+        uint16_t opcode = (cpu.read_memory(pc) << 8) | cpu.read_memory(pc + 1);
+        step();
+        // A faulting instruction is recorded too; it is often where two runs part ways
+        if (runs_instruction) {
+            uint8_t registers[REGISTER_COUNT];
+            cpu.copy_registers(registers);
+            tracer->record(pc, opcode, cpu.get_index_register(), cpu.get_stack_pointer(), registers);
+        }
+        if (shadow) {
+            verify_against_shadow(1);
+        }
+    }
+}
+
+void Machine::execute(uint64_t cycles) {
+    if (tracer) {
+        execute_traced(cycles);
+        return;
+    }
+
+    if (idle_skip && cycles > 0 && !cpu.is_paused() && !cpu.is_halted()) {
+        skip_idle_loop(cycles);
+    }
+
+    // A halted CPU cannot do anything with the remaining cycles
+    while (cycles > 0 && !cpu.is_halted()) {
+        if (jit && !cpu.is_paused()) {
+            int limit = cycles > INT_MAX ? INT_MAX : (int) cycles;
+            int executed = jit->run_block(limit);
+            if (executed > 0) {
+                total_instructions += executed;
+                cycles -= executed;
+                if (shadow) {
+                    verify_against_shadow(executed);
+                }
+                continue;
+            }
+        }
+
+        // Let the CPU run uninterrupted until the budget is spent or FX0A pauses it
+        if (!jit && !cpu.is_paused()) {
+            int limit = cycles > INT_MAX ? INT_MAX : (int) cycles;
+            int executed = cpu.run_cycles(display, *input, limit);
+            total_instructions += executed;
+            cycles -= executed;
+            if (cycles == 0) {
+                break;
+            }
+        }
+
+        // Fall back to the interpreter for a single cycle
+        step();
+        if (shadow) {
+            verify_against_shadow(1);
+        }
+        cycles -= 1;
+    }
+}
+
+void Machine::set_cycles_per_frame(int cycles) {
+    if (cycles > 0) {
+        cycles_per_frame = cycles;
+    }
+}
+
+int Machine::get_cycles_per_frame() const { return cycles_per_frame; }
+
+void Machine::set_idle_skip(bool enabled) { idle_skip = enabled; }
+uint64_t Machine::get_idle_instructions_skipped() const { return idle_instructions_skipped; }
+
+bool Machine::step() {
+    // Handle Fx0A (LD Vx, K) opcode: CPU pauses until a key is pressed
+    if (cpu.is_paused()) {
+        int pressed_key = input->get_pressed_key();
+        if (pressed_key != -1) {
+            cpu.set_register_after_key_press(pressed_key);
+            cpu.unpause();
+        }
+        return false;
+    }
+
+    if (cpu.is_halted()) {
+        return false;
+    }
+
+    cpu.emulate_cycle(display, *input);
+    if (cpu.is_halted()) {
+        return false;
+    }
+    total_instructions += 1;
+    return true;
+}
+
+void Machine::tick_timers() {
+    // Sticking to common practice where Fx0A truly "pauses" everything
+    if (!cpu.is_paused()) {
+        cpu.decrement_timers();
+    }
+    if (shadow) {
+        shadow->tick_timers();
+    }
+}
+
+void Machine::run_frame() {
+    if (frame_cycles_left > 0) {
+        // Finish the frame a debugger stopped in; its input was already polled
+        execute(frame_cycles_left);
+        frame_cycles_left = 0;
+    } else {
+        input->poll_events();
+        execute(cycles_per_frame);
+    }
+    finish_frame();
+}
+
+void Machine::finish_frame() {
+    tick_timers();
+    total_frames += 1;
+    if (tracer) {
+        tracer->mark_frame();
+    }
+}
+
+int Machine::execute_debug(Debugger& debugger, int cycles) {
+    int used = 0;
+    while (used < cycles && !cpu.is_halted()) {
+        if (cpu.is_paused()) {
+            step();
+            used += 1;
+            continue;
+        }
+        int executed = cpu.run_cycles_with(display, *input, cycles - used, debugger);
+        total_instructions += executed;
+        used += executed;
+        if (debugger.get_stop() != DebugStop::None) {
+            break;
+        }
+    }
+    if (shadow) {
+        verify_against_shadow(used);
+    }
+    return used;
+}
+
+DebugStop Machine::debug_advance(Debugger& debugger, int cycles) {
+    if (frame_cycles_left == 0) {
+        input->poll_events();
+        frame_cycles_left = cycles_per_frame;
+    }
+    int budget = cycles < frame_cycles_left ? cycles : frame_cycles_left;
+    frame_cycles_left -= execute_debug(debugger, budget);
+    if (cpu.is_halted()) {
+        frame_cycles_left = 0; // As in execute(), a halted CPU forfeits the rest of the frame
+    }
+    if (frame_cycles_left == 0) {
+        finish_frame();
+    }
+    return debugger.get_stop();
+}
+
+DebugStop Machine::debug_step(Debugger& debugger) {
+    debugger.resume();
+    DebugStop stop = debug_advance(debugger, 1);
+    if (stop != DebugStop::None) {
+        return stop;
+    }
+    return cpu.is_halted() ? DebugStop::Halted : DebugStop::Step;
+}
+
+DebugStop Machine::debug_run(Debugger& debugger, uint64_t frames) {
+    debugger.resume();
+    for (uint64_t i = 0; i < frames && !input->should_quit(); i++) {
+        DebugStop stop = debug_advance(debugger, INT_MAX);
+        if (stop != DebugStop::None) {
+            return stop;
+        }
+        if (cpu.is_halted()) {
+            return DebugStop::Halted;
+        }
+    }
+    return DebugStop::Frame;
+}
+
+RunStats Machine::run_cycles(uint64_t cycles) {
+    uint64_t start_instructions = total_instructions;
+    auto start_time = std::chrono::steady_clock::now();
+
+    execute(cycles);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    RunStats stats = {};
+    stats.cycles = cycles;
+    stats.instructions = total_instructions - start_instructions;
+    stats.seconds = elapsed.count();
+    stats.instructions_per_second = stats.seconds > 0 ? stats.instructions / stats.seconds : 0;
+    return stats;
+}
+
+RunStats Machine::run_frames(uint64_t frames) {
+    uint64_t start_instructions = total_instructions;
+    uint64_t start_frames = total_frames;
+    auto start_time = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < frames && !input->should_quit(); i++) {
+        run_frame();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    RunStats stats = {};
+    stats.frames = total_frames - start_frames;
+    stats.cycles = stats.frames * cycles_per_frame;
+    stats.instructions = total_instructions - start_instructions;
+    stats.seconds = elapsed.count();
+    stats.instructions_per_second = stats.seconds > 0 ? stats.instructions / stats.seconds : 0;
+    return stats;
+}
+
+CPU& Machine::get_cpu() { return cpu; }
+Display& Machine::get_display() { return display; }
+InputSource& Machine::get_input() { return *input; }
+
+uint64_t Machine::get_total_instructions() const { return total_instructions; }
+uint64_t Machine::get_total_frames() const { return total_frames; }
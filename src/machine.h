@@ -0,0 +1,144 @@
+#ifndef MACHINE_H
+#define MACHINE_H
+
+#include <cstdint> // For uint64_t
+#include <memory>  // For std::unique_ptr
+#include <string>  // For divergence reports
+#include "cpu.h"
+#include "debugger.h"
+#include "display.h"
+#include "input_source.h"
+#include "savestate.h"
+
+// Default number of CPU cycles run per 60Hz frame (600Hz total)
+const int DEFAULT_CYCLES_PER_FRAME = 10;
+const int TIMER_HZ = 60; // Timers decrement at 60Hz
+
+// Results reported by a batch of cycles or frames
+struct RunStats {
+    uint64_t cycles;       // Cycles requested (including ones spent paused on Fx0A)
+    uint64_t instructions; // Instructions actually executed
+    uint64_t frames;       // Frames completed (0 for run_cycles)
+    double seconds;        // Host wall-clock time spent
+    double instructions_per_second;
+};
+
+// In-memory copy of a whole machine (see Machine::save_snapshot)
+struct MachineSnapshot {
+    CpuSnapshot cpu;
+    Display display;
+    uint64_t total_instructions;
+    uint64_t total_frames;
+    uint64_t idle_instructions_skipped;
+};
+
+// A complete Chip-8 system (CPU + display) wired to a pluggable input source.
+// Nothing here depends on SDL, so it can run headless as fast as the host allows.
+class Jit;
+class TraceWriter;
+
+class Machine {
+public:
+    explicit Machine(InputSource& input);
+    ~Machine();
+
+    // Swap the input source (e.g. from scripted to recorded)
+    void set_input(InputSource& input);
+
+    // Load a program into memory at 0x200
+    void load_program(const uint8_t program[], int size);
+
+    // Select CHIP-8, SUPER-CHIP or XO-CHIP before loading a program (see CPU::set_variant).
+    // The recompiler only handles CHIP-8, so choosing another variant switches it off.
+    void set_variant(Chip8Variant variant);
+
+    void set_cycles_per_frame(int cycles);
+    int get_cycles_per_frame() const;
+
+    // Fast-forward wait loops (on by default). When a frame starts inside a loop that cannot
+    // change anything until the next timer tick or input poll, the rest of the frame's cycles
+    // are accounted for without running them; registers, I, PC and timers end up exactly as
+    // if they had run.
+    void set_idle_skip(bool enabled);
+    uint64_t get_idle_instructions_skipped() const;
+
+    // Run a single CPU cycle, resolving a pending Fx0A key wait first.
+    // Returns true if an instruction was executed.
+    bool step();
+
+    // Decrement the delay and sound timers (skipped while waiting on Fx0A)
+    void tick_timers();
+
+    // Poll input, run one frame's worth of cycles and tick the timers once
+    void run_frame();
+
+    // Run the given number of cycles / frames back to back without any pacing
+    RunStats run_cycles(uint64_t cycles);
+    RunStats run_frames(uint64_t frames);
+
+    // Capture the complete emulated state / restore it (returns false for an invalid image).
+    // Frame and instruction counters are host statistics and are not part of the state.
+    void save_state(SaveState& state) const;
+    bool load_state(const SaveState& state);
+
+    // Fast in-memory round trip for run-ahead: a snapshot is a few plain copies, and restoring
+    // one touches only the memory that changed since. Unlike savestates, snapshots include the
+    // frame and instruction counters, so speculative frames leave no trace in the statistics.
+    void save_snapshot(MachineSnapshot& snapshot) const;
+    void load_snapshot(const MachineSnapshot& snapshot);
+
+    // Record every executed instruction and frame end to a trace (nullptr to stop). While
+    // tracing, instructions run one at a time through the interpreter: the recompiler, its
+    // verification and idle-loop skipping are bypassed so the trace holds every instruction.
+    void set_tracer(TraceWriter* trace_writer);
+
+    // Run under a debugger (see debugger.h): one instruction, or up to frames whole frames.
+    // They return the debugger's hit, or Step / Frame once done, or Halted. A stop in the
+    // middle of a frame is resumed there by the next debugged run or run_frame(), so timers
+    // still tick once every cycles_per_frame cycles. These always interpret: the recompiler
+    // and idle-loop skipping are bypassed, and the instructions are not traced.
+    DebugStop debug_step(Debugger& debugger);
+    DebugStop debug_run(Debugger& debugger, uint64_t frames);
+
+    // Run straight-line code through the x86-64 recompiler where possible.
+    // With verify set, an interpreter-only copy of the machine runs in lockstep and the
+    // full state is compared after every block; the first mismatch is recorded.
+    // Returns false if the recompiler is not available on this host or for this variant.
+    bool enable_jit(bool enabled, bool verify = false);
+    bool has_diverged() const;
+    const std::string& get_divergence() const;
+
+    CPU& get_cpu();
+    Display& get_display();
+    InputSource& get_input();
+
+    uint64_t get_total_instructions() const;
+    uint64_t get_total_frames() const;
+
+private:
+    CPU cpu;
+    Display display;
+    InputSource* input;
+    int cycles_per_frame;
+    uint64_t total_instructions;
+    uint64_t total_frames;
+    bool idle_skip;
+    uint64_t idle_instructions_skipped;
+    int frame_cycles_left; // Left in a frame a debugger stopped in the middle of, else 0
+
+    std::unique_ptr<Jit> jit;
+    TraceWriter* tracer;
+    std::unique_ptr<Machine> shadow; // Reference interpreter for differential runs
+    std::string divergence;
+
+    // Run cycles, preferring compiled blocks when the recompiler is enabled
+    void execute(uint64_t cycles);
+    void execute_traced(uint64_t cycles);
+    void skip_idle_loop(uint64_t& cycles);
+    void verify_against_shadow(int cycles);
+    void finish_frame();
+    int execute_debug(Debugger& debugger, int cycles);
+    DebugStop debug_advance(Debugger& debugger, int cycles);
+};
+
+#endif // MACHINE_H
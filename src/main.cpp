@@ -1,57 +1,144 @@
 // main.cpp
 
+#include "audio.h"
 #include "cpu.h"
 #include "input.h"
+#include "input_record.h"
 #include "display.h"
+#include "machine.h"
+#include "profile.h"
+#include "renderer.h"
+#include "rewind.h"
+#include "rom_library.h"
+#include "scheduler.h"
+#include "triple_buffer.h"
 
 #include <SDL.h>     // Include SDL header
 #include <iostream>  // For error output
-#include <chrono>    // For timing
-#include <vector>    // For loading ROM
-#include <fstream>   // Required for file operations
+#include <string>    // For the ROM path and key map
+#include <cstring>   // For strcmp
+#include <memory>    // For std::unique_ptr
+#include <ctime>     // For the default RNG seed
+#include <atomic>    // For the flags shared with the emulation thread
+#include <thread>    // For the emulation thread
+#include <chrono>    // For fast-forward timing
 
 // Define emulator constants (should ideally be in a common header or here)
 const int CHIP8_WIDTH = 64;
 const int CHIP8_HEIGHT = 32;
 const int PIXEL_SCALE = 10; // How much to scale each Chip-8 pixel on screen
 
-// Function to load a Chip-8 ROM file into a vector of bytes
-std::vector<uint8_t> load_rom_file(const std::string& filepath) {
-    // Open the file in binary mode and at the end to get its size
-    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+// Runs on SDL's audio thread: pulls samples from the engine without locking
+static void audio_callback(void* userdata, Uint8* stream, int length) {
+    static_cast<AudioEngine*>(userdata)->mix(reinterpret_cast<int16_t*>(stream), length / static_cast<int>(sizeof(int16_t)));
+}
 
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open ROM file: " << filepath << std::endl;
-        return {}; // Return an empty vector to indicate failure
-    }
+int main(int argc, char* argv[]) {
 
-    // Get the file size
-    std::streamsize file_size = file.tellg();
-    if (file_size < 0) { // Check for potential errors with tellg
-        std::cerr << "Error: Could not determine file size for ROM: " << filepath << std::endl;
-        return {};
+    // Command line options
+    RendererBackend renderer_backend = RendererBackend::StreamingTexture;
+    int cycles_per_frame = 0; // 0 = from the ROM's profile, else DEFAULT_CYCLES_PER_FRAME (600Hz)
+    int quirks = -1;          // -1 = from the ROM's profile, else 0 (CHIP-8) or 1 (CHIP-48)
+    bool has_variant = false; // false = from the ROM's profile, else CHIP-8
+    Chip8Variant variant = Chip8Variant::Chip8;
+    std::string key_map;      // Empty = from the ROM's profile, else the built-in layout
+    std::string rom_filepath = "rom.rom";
+    const char* rom_db_path = "chip8-roms.db";
+    bool use_vsync = false;
+    bool idle_skip = true;
+    int run_ahead = 0;          // Speculative frames shown ahead of the real one, 0 = off
+    bool start_turbo = false;
+    int turbo_speed = 0;        // Emulated frames per host frame while fast-forwarding, 0 = uncapped
+    int turbo_render_every = 0; // Show every Nth emulated frame while fast-forwarding, 0 = one per host frame
+    bool audio_enabled = true;
+    AudioConfig audio_config;
+    size_t rewind_bytes = DEFAULT_REWIND_BYTES;
+    uint64_t seed = static_cast<uint64_t>(time(nullptr));
+    const char* record_path = nullptr;
+    const char* replay_path = nullptr;
+    const char* profile_path = "chip8-profile.txt";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--renderer=rects") == 0) {
+            renderer_backend = RendererBackend::FillRects;
+        } else if (strcmp(argv[i], "--renderer=texture") == 0) {
+            renderer_backend = RendererBackend::StreamingTexture;
+        } else if (strncmp(argv[i], "--cycles-per-frame=", 19) == 0) {
+            cycles_per_frame = atoi(argv[i] + 19);
+        } else if (strcmp(argv[i], "--vsync") == 0) {
+            use_vsync = true;
+        } else if (strcmp(argv[i], "--no-idle-skip") == 0) {
+            idle_skip = false;
+        } else if (strncmp(argv[i], "--run-ahead=", 12) == 0) {
+            run_ahead = atoi(argv[i] + 12);
+        } else if (strcmp(argv[i], "--turbo") == 0) {
+            start_turbo = true;
+        } else if (strncmp(argv[i], "--turbo-speed=", 14) == 0) {
+            turbo_speed = atoi(argv[i] + 14);
+        } else if (strncmp(argv[i], "--turbo-render-every=", 21) == 0) {
+            turbo_render_every = atoi(argv[i] + 21);
+        } else if (strcmp(argv[i], "--no-audio") == 0) {
+            audio_enabled = false;
+        } else if (strncmp(argv[i], "--audio-rate=", 13) == 0) {
+            audio_config.sample_rate = atoi(argv[i] + 13);
+        } else if (strncmp(argv[i], "--audio-buffer=", 15) == 0) {
+            audio_config.device_samples = atoi(argv[i] + 15);
+        } else if (strncmp(argv[i], "--audio-frames=", 15) == 0) {
+            audio_config.ring_frames = atoi(argv[i] + 15);
+        } else if (strncmp(argv[i], "--audio-target=", 15) == 0) {
+            audio_config.target_frames = atoi(argv[i] + 15);
+        } else if (strncmp(argv[i], "--beeper-hz=", 12) == 0) {
+            audio_config.beeper_hz = atoi(argv[i] + 12);
+        } else if (strncmp(argv[i], "--rewind-kb=", 12) == 0) {
+            rewind_bytes = static_cast<size_t>(atoi(argv[i] + 12)) * 1024;
+        } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            seed = strtoull(argv[i] + 7, nullptr, 10);
+        } else if (strncmp(argv[i], "--record=", 9) == 0) {
+            record_path = argv[i] + 9;
+        } else if (strncmp(argv[i], "--replay=", 9) == 0) {
+            replay_path = argv[i] + 9;
+        } else if (strncmp(argv[i], "--profile=", 10) == 0) {
+            profile_path = argv[i] + 10;
+        } else if (strcmp(argv[i], "--quirks=old") == 0) {
+            quirks = 0;
+        } else if (strcmp(argv[i], "--quirks=new") == 0) {
+            quirks = 1;
+        } else if (strncmp(argv[i], "--variant=", 10) == 0) {
+            has_variant = parse_variant(argv[i] + 10, variant);
+            if (!has_variant) {
+                std::cerr << "Unknown variant: " << argv[i] + 10 << std::endl;
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--keys=", 7) == 0) {
+            key_map = argv[i] + 7;
+        } else if (strncmp(argv[i], "--rom-db=", 9) == 0) {
+            rom_db_path = argv[i] + 9;
+        } else if (strncmp(argv[i], "--", 2) != 0) {
+            rom_filepath = argv[i];
+        }
     }
 
-    // Seek back to the beginning of the file
-    file.seekg(0, std::ios::beg);
-
-    // Create a vector of uint8_t with the exact size of the file
-    std::vector<uint8_t> rom_data(static_cast<size_t>(file_size));
-
-    // Read the entire file content into the vector
-    // reinterpret_cast<char*> is needed because std::ifstream::read expects a char* buffer
-    if (!file.read(reinterpret_cast<char*>(rom_data.data()), file_size)) {
-        std::cerr << "Error: Could not read ROM file: " << filepath << std::endl;
-        return {}; // Return an empty vector on read failure
+    // Map the ROM and look up its settings before anything else; a missing database is fine
+    MappedRom rom;
+    if (!rom.open(rom_filepath) || rom.size() > static_cast<size_t>(MAX_PROGRAM_SIZE)) {
+        std::cerr << "Error: Could not load ROM file: " << rom_filepath << std::endl;
+        return 1;
+    }
+    uint64_t rom_hash = hash_rom(rom.data(), rom.size());
+    RomDatabase rom_db;
+    rom_db.load(rom_db_path);
+    const RomProfile* rom_profile = rom_db.find(rom_hash);
+    std::cout << "ROM " << rom_filepath << " (" << rom.size() << " bytes, " << format_rom_hash(rom_hash) << ")";
+    if (rom_profile != nullptr) {
+        std::cout << " using profile " << (rom_profile->name.empty() ? "(unnamed)" : rom_profile->name);
+        if (cycles_per_frame == 0) { cycles_per_frame = rom_profile->cycles_per_frame; }
+        if (quirks < 0 && rom_profile->has_quirks) { quirks = rom_profile->new_functionality ? 1 : 0; }
+        if (!has_variant && rom_profile->has_variant) { variant = rom_profile->variant; }
+        if (key_map.empty()) { key_map = rom_profile->key_map; }
+    }
+    std::cout << std::endl;
+    if (cycles_per_frame <= 0) {
+        cycles_per_frame = DEFAULT_CYCLES_PER_FRAME;
     }
-
-    file.close(); // Close the file
-
-    std::cout << "Successfully loaded ROM: " << filepath << " (" << file_size << " bytes)" << std::endl;
-    return rom_data;
-}
-
-int main(int argc, char* argv[]) {
 
     // 1. Initialize SDL
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_EVENTS) < 0) {
@@ -59,6 +146,28 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    // The emulation loop publishes each frame's sound state; SDL's audio thread mixes it.
+    // Without a usable device the emulator simply runs silently.
+    std::unique_ptr<AudioEngine> audio;
+    SDL_AudioDeviceID audio_device = 0;
+    if (audio_enabled && audio_config.sample_rate >= TIMER_HZ && audio_config.device_samples > 0) {
+        audio.reset(new AudioEngine(audio_config));
+        SDL_AudioSpec wanted = {};
+        wanted.freq = audio_config.sample_rate;
+        wanted.format = AUDIO_S16SYS;
+        wanted.channels = 1;
+        wanted.samples = static_cast<Uint16>(audio_config.device_samples);
+        wanted.callback = audio_callback;
+        wanted.userdata = audio.get();
+        audio_device = SDL_OpenAudioDevice(nullptr, 0, &wanted, nullptr, 0);
+        if (audio_device == 0) {
+            std::cerr << "Audio disabled: " << SDL_GetError() << std::endl;
+            audio.reset();
+        } else {
+            SDL_PauseAudioDevice(audio_device, 0);
+        }
+    }
+
     // 2. Create SDL Window and Renderer
     SDL_Window* window = SDL_CreateWindow(
         "Chip-8 Emulator",
@@ -72,7 +181,11 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    Uint32 renderer_flags = SDL_RENDERER_ACCELERATED;
+    if (use_vsync) {
+        renderer_flags |= SDL_RENDERER_PRESENTVSYNC;
+    }
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, renderer_flags);
     if (!renderer) {
         std::cerr << "Renderer could not be created! SDL_Error: " << SDL_GetError() << std::endl;
         SDL_DestroyWindow(window);
@@ -82,114 +195,306 @@ int main(int argc, char* argv[]) {
 
     // 3. Initialize Chip-8 components
     Input input;
-    Display display; // Display object will manage its own pixel buffer
-    CPU cpu;
+    if (!key_map.empty() && !input.set_key_map(key_map)) {
+        std::cerr << "Ignoring key map with unknown keys: " << key_map << std::endl;
+    }
 
-    // Seed random number generator once at the start for the CPU's rand()
-    srand(static_cast<unsigned int>(time(nullptr)));
+    // The SDL thread polls the keyboard into a shared keypad; the machine reads that directly,
+    // through a recorder, or plays back a recording instead
+    AtomicKeypad keypad;
+    InputPlayback playback;
+    std::unique_ptr<InputRecorder> recorder;
+    InputSource* machine_input = &keypad;
+    if (replay_path != nullptr) {
+        if (!playback.load_file(replay_path)) {
+            std::cerr << "Could not read input recording: " << replay_path << std::endl;
+            SDL_DestroyRenderer(renderer);
+            SDL_DestroyWindow(window);
+            SDL_Quit();
+            return 1;
+        }
+        seed = playback.get_seed();
+        machine_input = &playback;
+    } else if (record_path != nullptr) {
+        recorder.reset(new InputRecorder(keypad, seed));
+        machine_input = recorder.get();
+    }
 
-    // 4. Load ROM
-    const std::string rom_filepath = "rom.rom";
-    std::vector<uint8_t> rom_data = load_rom_file(rom_filepath);
-    if (rom_data.empty()) {
-        std::cerr << "Exiting due to ROM loading failure." << std::endl;
+    Machine machine(*machine_input); // Owns the CPU and the display's pixel buffer
+
+    // CXNN draws from the machine's own generator, so a seed and the input replay a run exactly
+    machine.get_cpu().seed_random(seed);
+
+    // 4. Load ROM: one copy from the mapped file into CPU memory
+    std::cout << "Loading ROM file into memory..." << std::endl;
+    machine.get_cpu().set_new_functionality(quirks == 1);
+    machine.set_variant(variant);
+    machine.load_program(rom.data(), rom.size());
+    rom.close();
+    if (machine.get_cpu().get_fault() == CpuFault::ProgramTooLarge) {
+        std::cerr << "Error: ROM is too large for " << variant_name(variant) << std::endl;
         SDL_DestroyRenderer(renderer);
         SDL_DestroyWindow(window);
         SDL_Quit();
         return 1;
     }
-    std::cout << "Loading ROM file into memory..." << std::endl;
-    cpu.load_program(rom_data.data(), rom_data.size());
     std::cout << "Done loading file into memory"  << std::endl;;
 
     // 5. Main Emulation Loop Setup
-    bool running = true;
-    const int CPU_CYCLES_PER_SECOND = 600; // Typically around 500-700 Hz for Chip-8
-    const int TIMER_HZ = 60; // Timers decrement at 60Hz
+    machine.set_cycles_per_frame(cycles_per_frame);
+    machine.set_idle_skip(idle_skip); // Wait loops cost almost nothing instead of a frame of cycles
+
+    // Frames run at the 60Hz timer rate: one batch of cycles and one timer tick each
+    FrameScheduler scheduler(TIMER_HZ);
+
+    // Every frame is recorded so holding Backspace can step back through them.
+    // Rewinding is off while recording or replaying input, since it would break the replay.
+    bool rewind_enabled = record_path == nullptr && replay_path == nullptr;
+    RewindBuffer rewind(rewind_enabled ? rewind_bytes : 0);
+
+    // Finished frames go from the emulation thread to this one through the triple buffer
+    FrameTripleBuffer frames;
+
+    // Host controls, written by the SDL thread and read by the emulation thread
+    std::atomic<bool> stop_requested(false);
+    std::atomic<bool> emulation_finished(false); // The machine's input asked to quit
+    std::atomic<bool> rewind_held(false);
+    std::atomic<bool> profile_requested(false);
+    std::atomic<bool> turbo_active(start_turbo);  // Tab toggles fast-forward
+    std::atomic<uint64_t> emulated_frames(0);     // For the speed shown in the title bar
+
+    // The renderer owns an SDL texture, so it must go away before the SDL renderer does
+    std::unique_ptr<Renderer> frame_renderer(new Renderer(renderer, renderer_backend, PIXEL_SCALE));
+
+    // Speed achieved over a stretch of fast-forwarding, as a multiple of real time
+    auto report_turbo = [](uint64_t frame_count, std::chrono::steady_clock::duration elapsed) {
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        if (seconds > 0) {
+            std::cout << "Fast-forward: " << frame_count << " frames in " << seconds << " s ("
+                      << frame_count / seconds / TIMER_HZ << "x real time)" << std::endl;
+        }
+    };
+
+    // 6. Emulation thread: paced by the scheduler alone, so slow presentation or a vsync
+    // stall on the SDL thread never delays a frame
+    std::cout << "Starting emulation..."  << std::endl;
+    std::thread emulation_thread([&]() {
+        Display& display = machine.get_display();
+        SaveState state;
+        machine.save_state(state);
+        rewind.push(state);
+
+        // Hand the newest picture to the SDL thread; the renderer works out which rows changed
+        auto publish_display = [&](bool always) {
+            if (always || display.need_to_redraw()) {
+                PublishedFrame& frame = frames.back();
+                display.save_state(frame.display_state);
+                frame.frame = machine.get_total_frames();
+                frames.publish();
+                display.reset_redraw_flag();
+                display.clear_dirty_rows();
+            }
+        };
+
+        // One emulated frame: snapshot the keypad, run its batch of cycles (resolving Fx0A key
+        // waits) and tick the timers exactly once, or step back one frame while rewinding.
+        // Returns false once the keypad quits or a replay ends.
+        auto emulate_frame = [&]() {
+            if (rewind_enabled && rewind_held.load(std::memory_order_relaxed)) {
+                if (rewind.rewind(state)) {
+                    machine.load_state(state);
+                }
+            } else {
+                machine.run_frame();
+                if (rewind_enabled) {
+                    machine.save_state(state);
+                    rewind.push(state);
+                }
+            }
+            emulated_frames.fetch_add(1, std::memory_order_relaxed);
+            return !machine_input->should_quit();
+        };
+
+        // Run-ahead: after the real frame, emulate run_ahead more frames with the keys held
+        // right now, show the last of them and roll back. A key press then appears on screen
+        // run_ahead frames sooner. Speculative frames read a HeldInput, so they never consume
+        // key presses meant for the real frame or end up in a recording.
+        std::unique_ptr<MachineSnapshot> snapshot(new MachineSnapshot());
+        HeldInput held_input;
+        auto publish_run_ahead = [&]() {
+            machine.save_snapshot(*snapshot);
+            held_input.hold(*machine_input);
+            machine.set_input(held_input);
+            for (int f = 0; f < run_ahead; f++) {
+                machine.run_frame();
+            }
+            publish_display(true);
+            machine.set_input(*machine_input);
+            machine.load_snapshot(*snapshot);
+        };
+
+        bool fast_forwarding = false;
+        uint64_t turbo_start_frame = 0;
+        std::chrono::steady_clock::time_point turbo_start_time;
+        const std::chrono::nanoseconds host_frame(1000000000 / TIMER_HZ);
+
+        while (!stop_requested.load(std::memory_order_relaxed)) {
+            bool turbo = turbo_active.load(std::memory_order_relaxed);
+            if (turbo != fast_forwarding) {
+                fast_forwarding = turbo;
+                if (fast_forwarding) {
+                    turbo_start_frame = machine.get_total_frames();
+                    turbo_start_time = std::chrono::steady_clock::now();
+                } else {
+                    report_turbo(machine.get_total_frames() - turbo_start_frame, std::chrono::steady_clock::now() - turbo_start_time);
+                    scheduler.reset(); // Back to real time without a catch-up burst
+                }
+            }
+            bool uncapped = fast_forwarding && turbo_speed <= 0;
+
+            // Run every host frame that is due (more than one only when catching up after a
+            // stall). A host frame is one emulated frame, or while fast-forwarding
+            // turbo_speed of them, or as many as fit in a 60Hz period when uncapped. Timers
+            // tick once per emulated frame either way.
+            int host_frames_due = uncapped ? 1 : scheduler.frames_due();
+            for (int i = 0; i < host_frames_due; i++) {
+                std::chrono::steady_clock::time_point host_deadline = std::chrono::steady_clock::now() + host_frame;
+                int64_t frame_count = fast_forwarding ? (uncapped ? INT64_MAX : turbo_speed) : 1;
+                for (int64_t f = 0; f < frame_count; f++) {
+                    if (!emulate_frame()) {
+                        if (fast_forwarding) {
+                            report_turbo(machine.get_total_frames() - turbo_start_frame, std::chrono::steady_clock::now() - turbo_start_time);
+                        }
+                        publish_display(false);
+                        emulation_finished.store(true, std::memory_order_relaxed);
+                        return;
+                    }
+                    if (fast_forwarding && turbo_render_every > 0 && machine.get_total_frames() % turbo_render_every == 0) {
+                        publish_display(false);
+                    }
+                    if (uncapped && std::chrono::steady_clock::now() >= host_deadline) {
+                        break;
+                    }
+                }
+                bool rewinding = rewind_enabled && rewind_held.load(std::memory_order_relaxed);
+                if (run_ahead > 0 && !fast_forwarding && !rewinding) {
+                    publish_run_ahead();
+                } else if (!fast_forwarding || turbo_render_every <= 0) {
+                    publish_display(false);
+                }
 
-    // Calculate duration for one CPU cycle
-    const std::chrono::nanoseconds cycle_duration(1000000000 / CPU_CYCLES_PER_SECOND);
-    auto last_cycle_time = std::chrono::high_resolution_clock::now();
+                // Sound follows the host clock: one frame of it per host frame, so the ring
+                // does not overflow while fast-forwarding
+                if (audio) {
+                    if (rewinding) {
+                        audio->publish_silence();
+                    } else {
+                        audio->publish(machine.get_cpu());
+                    }
+                }
 
-    // To handle 60Hz timer updates
-    auto last_timer_update_time = std::chrono::high_resolution_clock::now();
-    const std::chrono::nanoseconds timer_update_duration(1000000000 / TIMER_HZ);
+                // F12 writes the profile so far without stopping (profiling builds only)
+                if (profile_requested.exchange(false, std::memory_order_relaxed) && PROFILE_ENABLED) {
+                    if (get_profiler().write_report(profile_path)) {
+                        std::cout << "Wrote profile to " << profile_path << std::endl;
+                    }
+                }
+            }
 
-    // 6. Emulation Loop
-    std::cout << "Starting emulation..."  << std::endl;
-    while (running) {
-        // Process SDL Events through the Input class
+            if (!uncapped) {
+                scheduler.wait_for_next_frame();
+            }
+        }
+        if (fast_forwarding) {
+            report_turbo(machine.get_total_frames() - turbo_start_frame, std::chrono::steady_clock::now() - turbo_start_time);
+        }
+    });
+
+    // SDL thread: events and presentation. The shown display only receives whole published
+    // frames; loading one marks the rows that differ from the previous frame dirty.
+    Display shown;
+    std::chrono::steady_clock::time_point title_time = std::chrono::steady_clock::now();
+    uint64_t title_frames = 0;
+    while (!emulation_finished.load(std::memory_order_relaxed)) {
         input.poll_events();
-
-        // Check for quit request from Input class
         if (input.should_quit()) {
-            running = false;
             break;
         }
-
-        // Handle Fx0A (LD Vx, K) opcode: CPU pauses until a key is pressed
-        if (cpu.is_paused()) {
-            int pressed_key = input.get_pressed_key();
-            if (pressed_key != -1) {
-                cpu.set_register_after_key_press(pressed_key); // Assumes this method exists in CPU
-                cpu.unpause();
-            }
-        } else {
-            // Emulate CPU cycles based on target speed
-            auto current_time = std::chrono::high_resolution_clock::now();
-            if (current_time - last_cycle_time >= cycle_duration) {
-                cpu.emulate_cycle(display, input);
-                last_cycle_time = current_time;
-            }
+        keypad.update(input.get_key_mask(), input.get_pressed_key());
+        rewind_held.store(input.is_rewind_held(), std::memory_order_relaxed);
+        if (input.take_profile_request()) {
+            profile_requested.store(true, std::memory_order_relaxed);
+        }
+        if (input.take_turbo_toggle()) {
+            turbo_active.store(!turbo_active.load(std::memory_order_relaxed), std::memory_order_relaxed);
         }
 
-        // Update timers at 60Hz
-        auto current_time_timer = std::chrono::high_resolution_clock::now();
-        if (current_time_timer - last_timer_update_time >= timer_update_duration) {
-            // Only decrement timers if CPU is not paused.
-            // This behavior varies slightly between emulators;
-            // some decrement always, others only when not paused for Fx0A.
-            // Sticking to common practice where Fx0A truly "pauses" everything.
-            if (!cpu.is_paused()) {
-                 cpu.decrement_timers(); // You'll need to add this method to your CPU
+        // Show the fast-forward speed in the title bar, measured over the last second
+        auto now = std::chrono::steady_clock::now();
+        if (now - title_time >= std::chrono::seconds(1)) {
+            uint64_t frame_count = emulated_frames.load(std::memory_order_relaxed);
+            double seconds = std::chrono::duration<double>(now - title_time).count();
+            std::string title = "Chip-8 Emulator";
+            if (turbo_active.load(std::memory_order_relaxed)) {
+                title += " - fast-forward " + std::to_string(static_cast<int>((frame_count - title_frames) / seconds / TIMER_HZ)) + "x";
             }
-            last_timer_update_time = current_time_timer;
+            SDL_SetWindowTitle(window, title.c_str());
+            title_time = now;
+            title_frames = frame_count;
         }
 
+        if (frames.take()) {
+            shown.load_state(frames.front().display_state);
+        }
+        if (shown.need_to_redraw()) {
+            frame_renderer->present(shown);
+            shown.reset_redraw_flag();
+        } else if (!use_vsync) {
+            // Nothing new to show: check again shortly for input and the next frame
+            SDL_Delay(1);
+        }
+    }
+    // The quit reaches the machine through the keypad at the start of the next frame, so a
+    // recording ends with it. A replay ignores the keypad and is stopped directly.
+    keypad.request_quit();
+    if (replay_path != nullptr) {
+        stop_requested.store(true, std::memory_order_relaxed);
+    }
+    emulation_thread.join();
 
-        // Rendering
-        if (display.need_to_redraw()) {
-            // Clear SDL renderer to black
-            SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-            SDL_RenderClear(renderer);
-
-            // Get the Chip-8 display pixel data
-            const auto& pixels = display.get_display(); // Get const reference to bool[][]
-
-            // Set drawing color to white for pixels
-            SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-
-            // Draw each active Chip-8 pixel as a scaled SDL_Rect
-            for (int y = 0; y < CHIP8_HEIGHT; ++y) {
-                for (int x = 0; x < CHIP8_WIDTH; ++x) {
-                    if (pixels[y][x]) {
-                        SDL_Rect pixel_rect = {x * PIXEL_SCALE, y * PIXEL_SCALE, PIXEL_SCALE, PIXEL_SCALE};
-                        SDL_RenderFillRect(renderer, &pixel_rect);
-                    }
-                }
-            }
+    // The core records faults instead of printing them; report the first one here
+    if (machine.get_cpu().get_fault() != CpuFault::None) {
+        std::cerr << "CPU fault: " << fault_name(machine.get_cpu().get_fault()) << std::endl;
+    }
 
-            // Present the rendered content to the window
-            SDL_RenderPresent(renderer);
+    if (scheduler.get_dropped_frames() > 0) {
+        std::cout << "Dropped " << scheduler.get_dropped_frames() << " frames after stalls" << std::endl;
+    }
+    std::cout << "Published " << frames.get_published() << " frames, " << frames.get_overwritten()
+              << " replaced before they were shown" << std::endl;
+    std::cout << "Average render time: " << frame_renderer->get_average_frame_time_us() << " us over "
+              << frame_renderer->get_frames_presented() << " frames ("
+              << (frame_renderer->get_backend() == RendererBackend::StreamingTexture ? "texture" : "rects") << ")" << std::endl;
+    frame_renderer.reset();
+
+    if (audio) {
+        // Stop the callback before the engine goes away
+        SDL_CloseAudioDevice(audio_device);
+        std::cout << "Audio latency: " << audio->get_average_latency_us() << " us average, "
+                  << audio->get_max_latency_us() << " us max in the ring, plus "
+                  << audio->get_device_latency_us() << " us device buffer; "
+                  << audio->get_underruns() << " underruns (" << audio->get_underrun_samples() << " samples), "
+                  << audio->get_frames_skipped() << " frames skipped, "
+                  << audio->get_frames_dropped() << " dropped" << std::endl;
+        audio.reset();
+    }
 
-            // Reset the redraw flag after drawing
-            display.reset_redraw_flag();
-        }
+    if (PROFILE_ENABLED && !get_profiler().write_report(profile_path)) {
+        std::cerr << "Could not write profile: " << profile_path << std::endl;
+    }
 
-        // --- Frame Rate Limiting (for overall loop if needed, but per-cycle timing is better) ---
-        // This can be removed if your CPU_CYCLES_PER_SECOND logic is strict enough.
-        // If the CPU is very fast, you might need a small sleep here to avoid 100% CPU usage.
-        // std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    if (recorder && !recorder->save(record_path)) {
+        std::cerr << "Could not write input recording: " << record_path << std::endl;
     }
 
     // 7. Cleanup SDL
@@ -0,0 +1,26 @@
+#include "opcodes.h"
+#include <cstring> // For strcmp
+
+constexpr DecodeTable DECODE_TABLE = make_decode_table();
+constexpr DecodeTable SUPER_CHIP_DECODE_TABLE = make_decode_table(Chip8Variant::SuperChip);
+constexpr DecodeTable XO_CHIP_DECODE_TABLE = make_decode_table(Chip8Variant::XoChip);
+
+const char* variant_name(Chip8Variant variant) {
+    switch (variant) {
+        case Chip8Variant::Chip8: return "chip8";
+        case Chip8Variant::SuperChip: return "schip";
+        case Chip8Variant::XoChip: return "xochip";
+    }
+    return "unknown";
+}
+
+bool parse_variant(const char* name, Chip8Variant& variant) {
+    const Chip8Variant VARIANTS[] = {Chip8Variant::Chip8, Chip8Variant::SuperChip, Chip8Variant::XoChip};
+    for (Chip8Variant candidate : VARIANTS) {
+        if (strcmp(name, variant_name(candidate)) == 0) {
+            variant = candidate;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,186 @@
+#ifndef OPCODES_H
+#define OPCODES_H
+
+#include <array>   // For the decode table
+#include <cstdint> // For uint8_t and uint16_t
+
+// Instruction sets the CPU can run. Each one extends the one before it.
+enum class Chip8Variant : uint8_t {
+    Chip8,     // The original 64x32 machine with 4 KB of memory
+    SuperChip, // SUPER-CHIP 1.1: 128x64 hi-res mode, scrolling, 16x16 sprites, big font, RPL flags
+    XoChip     // XO-CHIP: SUPER-CHIP plus 64 KB of memory, two bitplanes and audio patterns
+};
+
+// Short name of a variant ("chip8", "schip" or "xochip") and the reverse lookup, for options
+// and ROM profiles. parse_variant returns false for an unknown name.
+const char* variant_name(Chip8Variant variant);
+bool parse_variant(const char* name, Chip8Variant& variant);
+
+// Every distinct instruction the CPU understands. Opcodes that the interpreter ignores
+// (e.g. 0NNN machine routines) decode to OP_NOP.
+enum Operation : uint8_t {
+    OP_NOP,
+    OP_CLS,          // 00E0
+    OP_RET,          // 00EE
+    OP_JP,           // 1NNN
+    OP_CALL,         // 2NNN
+    OP_SE_VX_NN,     // 3XNN
+    OP_SNE_VX_NN,    // 4XNN
+    OP_SE_VX_VY,     // 5XY0
+    OP_LD_VX_NN,     // 6XNN
+    OP_ADD_VX_NN,    // 7XNN
+    OP_LD_VX_VY,     // 8XY0
+    OP_AND_VX_VY,    // 8XY2
+    OP_XOR_VX_VY,    // 8XY3
+    OP_ADD_VX_VY,    // 8XY4
+    OP_SUB_VX_VY,    // 8XY5
+    OP_SHR_VX_VY,    // 8XY6
+    OP_SUBN_VX_VY,   // 8XY7
+    OP_SHL_VX_VY,    // 8XYE
+    OP_SNE_VX_VY,    // 9XY0
+    OP_LD_I_NNN,     // ANNN
+    OP_JP_V0_NNN,    // BNNN
+    OP_RND_VX_NN,    // CXNN
+    OP_DRW_VX_VY_N,  // DXYN
+    OP_SKP_VX,       // EX9E
+    OP_SKNP_VX,      // EXA1
+    OP_LD_VX_DT,     // FX07
+    OP_LD_VX_K,      // FX0A
+    OP_LD_DT_VX,     // FX15
+    OP_LD_ST_VX,     // FX18
+    OP_ADD_I_VX,     // FX1E
+    OP_LD_F_VX,      // FX29
+    OP_LD_B_VX,      // FX33
+    OP_LD_I_VX,      // FX55
+    OP_LD_VX_I,      // FX65
+    // SUPER-CHIP
+    OP_SCD_N,        // 00CN
+    OP_SCR,          // 00FB
+    OP_SCL,          // 00FC
+    OP_EXIT,         // 00FD
+    OP_LOW,          // 00FE
+    OP_HIGH,         // 00FF
+    OP_DRW_VX_VY_16, // DXY0
+    OP_LD_HF_VX,     // FX30
+    OP_LD_R_VX,      // FX75
+    OP_LD_VX_R,      // FX85
+    // XO-CHIP
+    OP_SCU_N,        // 00DN
+    OP_SAVE_VX_VY,   // 5XY2
+    OP_LOAD_VX_VY,   // 5XY3
+    OP_LD_I_LONG,    // F000 NNNN
+    OP_PLANE_N,      // FN01
+    OP_AUDIO,        // F002
+    OP_PITCH_VX,     // FX3A
+    OP_COUNT
+};
+
+// Work out which operation a raw 16-bit instruction performs. Instructions a variant does
+// not have decode the way CHIP-8 does (mostly to OP_NOP).
+constexpr Operation decode_operation(uint16_t instruction, Chip8Variant variant = Chip8Variant::Chip8) {
+    uint8_t n = instruction & 0x000F;
+    uint8_t nn = instruction & 0x00FF;
+    bool super_chip = variant != Chip8Variant::Chip8;
+    bool xo_chip = variant == Chip8Variant::XoChip;
+
+    switch (instruction & 0xF000) {
+        case 0x0000:
+            if (instruction == 0x00E0) { return OP_CLS; }
+            if (instruction == 0x00EE) { return OP_RET; }
+            if (super_chip) {
+                if ((instruction & 0xFFF0) == 0x00C0) { return OP_SCD_N; }
+                if (instruction == 0x00FB) { return OP_SCR; }
+                if (instruction == 0x00FC) { return OP_SCL; }
+                if (instruction == 0x00FD) { return OP_EXIT; }
+                if (instruction == 0x00FE) { return OP_LOW; }
+                if (instruction == 0x00FF) { return OP_HIGH; }
+            }
+            if (xo_chip && (instruction & 0xFFF0) == 0x00D0) { return OP_SCU_N; }
+            return OP_NOP;
+        case 0x1000: return OP_JP;
+        case 0x2000: return OP_CALL;
+        case 0x3000: return OP_SE_VX_NN;
+        case 0x4000: return OP_SNE_VX_NN;
+        case 0x5000:
+            if (xo_chip && n == 0x2) { return OP_SAVE_VX_VY; }
+            if (xo_chip && n == 0x3) { return OP_LOAD_VX_VY; }
+            return OP_SE_VX_VY;
+        case 0x6000: return OP_LD_VX_NN;
+        case 0x7000: return OP_ADD_VX_NN;
+        case 0x8000:
+            switch (n) {
+                case 0x0: return OP_LD_VX_VY;
+                case 0x2: return OP_AND_VX_VY;
+                case 0x3: return OP_XOR_VX_VY;
+                case 0x4: return OP_ADD_VX_VY;
+                case 0x5: return OP_SUB_VX_VY;
+                case 0x6: return OP_SHR_VX_VY;
+                case 0x7: return OP_SUBN_VX_VY;
+                case 0xE: return OP_SHL_VX_VY;
+                default: return OP_NOP;
+            }
+        case 0x9000: return OP_SNE_VX_VY;
+        case 0xA000: return OP_LD_I_NNN;
+        case 0xB000: return OP_JP_V0_NNN;
+        case 0xC000: return OP_RND_VX_NN;
+        case 0xD000: return super_chip && n == 0 ? OP_DRW_VX_VY_16 : OP_DRW_VX_VY_N;
+        case 0xE000:
+            if (nn == 0x9E) { return OP_SKP_VX; }
+            if (nn == 0xA1) { return OP_SKNP_VX; }
+            return OP_NOP;
+        default:
+            if (xo_chip) {
+                if (instruction == 0xF000) { return OP_LD_I_LONG; }
+                if (nn == 0x01) { return OP_PLANE_N; }
+                if (instruction == 0xF002) { return OP_AUDIO; }
+                if (nn == 0x3A) { return OP_PITCH_VX; }
+            }
+            if (super_chip) {
+                if (nn == 0x30) { return OP_LD_HF_VX; }
+                if (nn == 0x75) { return OP_LD_R_VX; }
+                if (nn == 0x85) { return OP_LD_VX_R; }
+            }
+            switch (nn) {
+                case 0x07: return OP_LD_VX_DT;
+                case 0x0A: return OP_LD_VX_K;
+                case 0x15: return OP_LD_DT_VX;
+                case 0x18: return OP_LD_ST_VX;
+                case 0x1E: return OP_ADD_I_VX;
+                case 0x29: return OP_LD_F_VX;
+                case 0x33: return OP_LD_B_VX;
+                case 0x55: return OP_LD_I_VX;
+                case 0x65: return OP_LD_VX_I;
+                default: return OP_NOP;
+            }
+    }
+}
+
+// Number of distinct 16-bit instructions
+const int INSTRUCTION_COUNT = 0x10000;
+
+// Operation for every possible instruction, generated at compile time from decode_operation.
+// One load replaces the nested switches when dispatching.
+typedef std::array<uint8_t, INSTRUCTION_COUNT> DecodeTable;
+
+constexpr DecodeTable make_decode_table(Chip8Variant variant = Chip8Variant::Chip8) {
+    DecodeTable table = {};
+    for (int instruction = 0; instruction < INSTRUCTION_COUNT; instruction++) {
+        table[instruction] = decode_operation(instruction, variant);
+    }
+    return table;
+}
+
+// DECODE_TABLE is plain CHIP-8; the recompiler and the lockstep engine only ever use it
+extern const DecodeTable DECODE_TABLE;
+extern const DecodeTable SUPER_CHIP_DECODE_TABLE;
+extern const DecodeTable XO_CHIP_DECODE_TABLE;
+
+inline const DecodeTable& decode_table_for(Chip8Variant variant) {
+    switch (variant) {
+        case Chip8Variant::SuperChip: return SUPER_CHIP_DECODE_TABLE;
+        case Chip8Variant::XoChip: return XO_CHIP_DECODE_TABLE;
+        default: return DECODE_TABLE;
+    }
+}
+
+#endif // OPCODES_H
@@ -0,0 +1,43 @@
+#include "pixel_expand.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h> // For SSE2 intrinsics
+#endif
+
+void expand_row(uint64_t row, uint32_t* pixels, uint32_t on_color, uint32_t off_color) {
+#if defined(__SSE2__) || defined(_M_X64)
+    // Each sprite byte becomes two vectors of four pixels: broadcast the byte, isolate one
+    // bit per lane, turn set bits into all-ones masks and pick between the two colors
+    const __m128i high_bits = _mm_set_epi32(0x10, 0x20, 0x40, 0x80);
+    const __m128i low_bits = _mm_set_epi32(0x01, 0x02, 0x04, 0x08);
+    const __m128i on = _mm_set1_epi32(on_color);
+    const __m128i off = _mm_set1_epi32(off_color);
+
+    for (int byte_idx = 0; byte_idx < 8; byte_idx++) {
+        __m128i byte = _mm_set1_epi32((row >> (56 - byte_idx * 8)) & 0xFF);
+        __m128i high_mask = _mm_cmpeq_epi32(_mm_and_si128(byte, high_bits), high_bits);
+        __m128i low_mask = _mm_cmpeq_epi32(_mm_and_si128(byte, low_bits), low_bits);
+        __m128i high = _mm_or_si128(_mm_and_si128(high_mask, on), _mm_andnot_si128(high_mask, off));
+        __m128i low = _mm_or_si128(_mm_and_si128(low_mask, on), _mm_andnot_si128(low_mask, off));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + byte_idx * 8), high);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + byte_idx * 8 + 4), low);
+    }
+#else
+    uint32_t difference = on_color ^ off_color;
+    for (int i = 0; i < 64; i++) {
+        uint32_t bit = (row >> (63 - i)) & 1;
+        pixels[i] = off_color ^ (difference & (0u - bit));
+    }
+#endif
+}
+
+void expand_row_planes(uint64_t plane_0, uint64_t plane_1, uint32_t* pixels, const uint32_t palette[4]) {
+    if (plane_1 == 0) {
+        expand_row(plane_0, pixels, palette[1], palette[0]);
+        return;
+    }
+    for (int i = 0; i < 64; i++) {
+        int colour = ((plane_0 >> (63 - i)) & 1) | (((plane_1 >> (63 - i)) & 1) << 1);
+        pixels[i] = palette[colour];
+    }
+}
@@ -0,0 +1,14 @@
+#ifndef PIXEL_EXPAND_H
+#define PIXEL_EXPAND_H
+
+#include <cstdint> // For uint32_t and uint64_t
+
+// Expand one packed display row (bit 63 = leftmost pixel) into 64 32-bit pixels.
+// Uses SSE2 where available and a branchless scalar loop otherwise.
+void expand_row(uint64_t row, uint32_t* pixels, uint32_t on_color, uint32_t off_color);
+
+// Expand one packed word from each of the two XO-CHIP planes into 64 pixels, picking
+// palette[plane 0 bit | plane 1 bit << 1]. Rows with nothing in plane 1 go through expand_row.
+void expand_row_planes(uint64_t plane_0, uint64_t plane_1, uint32_t* pixels, const uint32_t palette[4]);
+
+#endif // PIXEL_EXPAND_H
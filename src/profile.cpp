@@ -0,0 +1,109 @@
+#include "profile.h"
+#include <cstring> // For memset
+#include <fstream> // For writing reports
+
+Profiler profiler_instance;
+
+// Instruction pattern for each Operation, in enum order
+static const char* const OPERATION_NAMES[] = {
+    "NOP", "00E0", "00EE", "1NNN", "2NNN",
+    "3XNN", "4XNN", "5XY0", "6XNN", "7XNN",
+    "8XY0", "8XY2", "8XY3", "8XY4", "8XY5",
+    "8XY6", "8XY7", "8XYE", "9XY0", "ANNN",
+    "BNNN", "CXNN", "DXYN", "EX9E", "EXA1",
+    "FX07", "FX0A", "FX15", "FX18", "FX1E",
+    "FX29", "FX33", "FX55", "FX65",
+    "00CN", "00FB", "00FC", "00FD", "00FE",
+    "00FF", "DXY0", "FX30", "FX75", "FX85",
+    "00DN", "5XY2", "5XY3", "F000", "FN01",
+    "F002", "FX3A"
+};
+static_assert(sizeof(OPERATION_NAMES) / sizeof(OPERATION_NAMES[0]) == OP_COUNT, "Every operation needs a name");
+
+Profiler::Profiler() {
+    reset();
+}
+
+void Profiler::reset() {
+    instructions = 0;
+    instructions_since_draw = 0;
+    draws = 0;
+    memset(operation_counts, 0, sizeof(operation_counts));
+    memset(pc_counts, 0, sizeof(pc_counts));
+    memset(draw_gaps, 0, sizeof(draw_gaps));
+    memset(timer_calls, 0, sizeof(timer_calls));
+    memset(timer_nanoseconds, 0, sizeof(timer_nanoseconds));
+}
+
+void Profiler::count_draw() {
+    // Bucket b holds gaps in [2^(b-1), 2^b), bucket 0 holds back-to-back draws
+    int bucket = 0;
+    for (uint64_t gap = instructions_since_draw; gap != 0 && bucket < PROFILE_DRAW_GAP_BUCKETS - 1; gap >>= 1) {
+        bucket += 1;
+    }
+    // The first draw has no previous one to measure from
+    if (draws > 0) {
+        draw_gaps[bucket] += 1;
+    }
+    draws += 1;
+    instructions_since_draw = 0;
+}
+
+void Profiler::add_time(ProfileTimer timer, uint64_t nanoseconds) {
+    int index = static_cast<int>(timer);
+    timer_calls[index] += 1;
+    timer_nanoseconds[index] += nanoseconds;
+}
+
+uint64_t Profiler::get_instructions() const { return instructions; }
+uint64_t Profiler::get_operation_count(Operation operation) const { return operation_counts[operation]; }
+uint64_t Profiler::get_pc_count(uint16_t address) const { return pc_counts[address & (PROFILE_PC_COUNT - 1)]; }
+
+bool Profiler::write_report(const std::string& filepath) const {
+    std::ofstream file(filepath);
+    if (!file) {
+        return false;
+    }
+
+    file << "# Chip-8 profile\n"
+         << "instructions " << instructions << "\n"
+         << "draws " << draws << "\n\n";
+
+    file << "[operations] pattern count percent\n";
+    for (int op = 0; op < OP_COUNT; op++) {
+        if (operation_counts[op] > 0) {
+            file << OPERATION_NAMES[op] << " " << operation_counts[op] << " "
+                 << (100.0 * operation_counts[op] / instructions) << "\n";
+        }
+    }
+
+    file << "\n[draw_gaps] instructions_between_draws count\n";
+    for (int bucket = 0; bucket < PROFILE_DRAW_GAP_BUCKETS; bucket++) {
+        uint64_t low = bucket == 0 ? 0 : 1ULL << (bucket - 1);
+        file << low;
+        if (bucket == PROFILE_DRAW_GAP_BUCKETS - 1) {
+            file << "+";
+        } else if (bucket > 1) {
+            file << "-" << (1ULL << bucket) - 1;
+        }
+        file << " " << draw_gaps[bucket] << "\n";
+    }
+
+    static const char* const TIMER_NAMES[] = {"draw_sprite", "render"};
+    file << "\n[timers] name calls total_ns average_ns\n";
+    for (int timer = 0; timer < 2; timer++) {
+        file << TIMER_NAMES[timer] << " " << timer_calls[timer] << " " << timer_nanoseconds[timer] << " "
+             << (timer_calls[timer] > 0 ? timer_nanoseconds[timer] / timer_calls[timer] : 0) << "\n";
+    }
+
+    // Row r holds the execution counts of addresses r*64 to r*64+63
+    file << "\n[pc_heatmap] 64 rows of 64 addresses\n";
+    for (int row = 0; row < PROFILE_PC_COUNT / 64; row++) {
+        for (int column = 0; column < 64; column++) {
+            file << (column > 0 ? " " : "") << pc_counts[row * 64 + column];
+        }
+        file << "\n";
+    }
+
+    return static_cast<bool>(file);
+}
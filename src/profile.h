@@ -0,0 +1,102 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <chrono>  // For timing draws and renders
+#include <cstdint> // For uint16_t and uint64_t
+#include <string>  // For report paths
+#include "opcodes.h"
+
+// Profiling is compiled in with -DCHIP8_PROFILE. Without it the CHIP8_PROFILE_* hooks
+// expand to nothing, so the interpreter loops are exactly what they would be otherwise.
+#ifdef CHIP8_PROFILE
+const bool PROFILE_ENABLED = true;
+#else
+const bool PROFILE_ENABLED = false;
+#endif
+
+// One counter per memory address for the PC heatmap (XO-CHIP code above 4 KB folds onto it)
+const int PROFILE_PC_COUNT = 4096;
+
+// Histogram of instructions executed between two DXYN draws, in power-of-two buckets:
+// 0, 1, 2-3, 4-7, ... with everything from 2^(N-2) up in the last bucket
+const int PROFILE_DRAW_GAP_BUCKETS = 20;
+
+// Host time measured by ProfileScope
+enum class ProfileTimer {
+    DrawSprite, // Display::draw_sprite
+    Render      // Renderer::present
+};
+
+// Counters filled in by the hooks while a profiling build runs. There is one global
+// instance and it is not synchronised, so profile one machine at a time. In the SDL front
+// end the render timer is added from the render thread, so a report written mid-run may
+// catch it part way through an update.
+// Only interpreted instructions are counted: JIT-compiled blocks and lockstep vector
+// steps bypass the hooks.
+class Profiler {
+public:
+    Profiler();
+
+    void reset();
+
+    void count_instruction(uint16_t address, uint8_t operation) {
+        pc_counts[address & (PROFILE_PC_COUNT - 1)] += 1;
+        operation_counts[operation] += 1;
+        instructions += 1;
+        if (operation == OP_DRW_VX_VY_N) {
+            count_draw();
+        } else {
+            instructions_since_draw += 1;
+        }
+    }
+
+    void add_time(ProfileTimer timer, uint64_t nanoseconds);
+
+    uint64_t get_instructions() const;
+    uint64_t get_operation_count(Operation operation) const;
+    uint64_t get_pc_count(uint16_t address) const;
+
+    // Write every counter as a text report ending with the PC heatmap (64 rows of 64
+    // addresses). Returns false if the file could not be written.
+    bool write_report(const std::string& filepath) const;
+
+private:
+    uint64_t instructions;
+    uint64_t operation_counts[OP_COUNT];
+    uint64_t pc_counts[PROFILE_PC_COUNT];
+    uint64_t draw_gaps[PROFILE_DRAW_GAP_BUCKETS];
+    uint64_t instructions_since_draw;
+    uint64_t draws;
+    uint64_t timer_calls[2];
+    uint64_t timer_nanoseconds[2];
+
+    void count_draw();
+};
+
+// The global profiler the hooks write to
+extern Profiler profiler_instance;
+inline Profiler& get_profiler() { return profiler_instance; }
+
+// Adds the time until the end of the enclosing scope to a profile timer
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileTimer timer) : timer(timer), start_time(std::chrono::steady_clock::now()) {}
+    ~ProfileScope() {
+        std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start_time;
+        get_profiler().add_time(timer, elapsed.count());
+    }
+
+private:
+    ProfileTimer timer;
+    std::chrono::steady_clock::time_point start_time;
+};
+
+#ifdef CHIP8_PROFILE
+#define CHIP8_PROFILE_INSTRUCTION(address, operation) get_profiler().count_instruction((address), (operation))
+#define CHIP8_PROFILE_SCOPE(timer) ProfileScope profile_scope(timer)
+#else
+#define CHIP8_PROFILE_INSTRUCTION(address, operation) ((void) 0)
+#define CHIP8_PROFILE_SCOPE(timer) ((void) 0)
+#endif
+
+#endif // PROFILE_H
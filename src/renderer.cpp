@@ -0,0 +1,121 @@
+#include "renderer.h"
+#include "pixel_expand.h"
+#include "profile.h"
+
+#include <chrono> // For frame timing
+
+// Colour for each combination of plane bits (ARGB8888): off, plane 0, plane 1, both.
+// CHIP-8 and SUPER-CHIP only draw in plane 0, so they come out black and white.
+const uint32_t PIXEL_PALETTE[4] = {0xFF000000, 0xFFFFFFFF, 0xFF606060, 0xFFB0B0B0};
+
+Renderer::Renderer(SDL_Renderer* sdl_renderer, RendererBackend selected_backend, int scale) {
+    renderer = sdl_renderer;
+    backend = selected_backend;
+    pixel_scale = scale;
+    texture = nullptr;
+    frames_presented = 0;
+    total_frame_time_us = 0;
+
+    if (backend == RendererBackend::StreamingTexture) {
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                    DISPLAY_HIRES_WIDTH, DISPLAY_HIRES_HEIGHT);
+        if (!texture) {
+            // Fall back to the slow path rather than showing nothing
+            backend = RendererBackend::FillRects;
+        }
+    }
+}
+
+Renderer::~Renderer() {
+    if (texture) {
+        SDL_DestroyTexture(texture);
+    }
+}
+
+RendererBackend Renderer::get_backend() const { return backend; }
+
+double Renderer::get_average_frame_time_us() const {
+    return frames_presented > 0 ? total_frame_time_us / frames_presented : 0;
+}
+
+uint64_t Renderer::get_frames_presented() const { return frames_presented; }
+
+void Renderer::present(Display& display) {
+    CHIP8_PROFILE_SCOPE(ProfileTimer::Render);
+    auto start_time = std::chrono::steady_clock::now();
+
+    if (backend == RendererBackend::StreamingTexture) {
+        draw_texture(display);
+    } else {
+        draw_rects(display);
+    }
+
+    // Present the rendered content to the window
+    SDL_RenderPresent(renderer);
+
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start_time;
+    total_frame_time_us += elapsed.count();
+    frames_presented += 1;
+}
+
+void Renderer::draw_rects(const Display& display) {
+    // Clear SDL renderer to black
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+
+    // Hi-res pixels are half the size so the window stays the same
+    int size = display.is_hires() ? pixel_scale / 2 : pixel_scale;
+    int current_colour = 0;
+
+    // Draw each active Chip-8 pixel as a scaled SDL_Rect
+    for (int y = 0; y < display.get_height(); ++y) {
+        for (int x = 0; x < display.get_width(); ++x) {
+            int colour = display.get_pixel(x, y);
+            if (colour == 0) {
+                continue;
+            }
+            if (colour != current_colour) {
+                uint32_t argb = PIXEL_PALETTE[colour];
+                SDL_SetRenderDrawColor(renderer, (argb >> 16) & 0xFF, (argb >> 8) & 0xFF, argb & 0xFF, 255);
+                current_colour = colour;
+            }
+            SDL_Rect pixel_rect = {x * size, y * size, size, size};
+            SDL_RenderFillRect(renderer, &pixel_rect);
+        }
+    }
+}
+
+void Renderer::draw_texture(Display& display) {
+    int width = display.get_width();
+    int height = display.get_height();
+    int words = width / 64;
+
+    uint64_t dirty = display.get_dirty_rows();
+    if (dirty != 0) {
+        // Re-expand only the rows that changed and upload the band that covers them
+        int first_row = height;
+        int last_row = -1;
+        for (int y = 0; y < height; y++) {
+            if ((dirty >> y) & 1) {
+                const uint64_t* plane_0 = display.get_row(0, y);
+                const uint64_t* plane_1 = display.get_row(1, y);
+                for (int w = 0; w < words; w++) {
+                    expand_row_planes(plane_0[w], plane_1[w], pixels[y] + w * 64, PIXEL_PALETTE);
+                }
+                if (first_row == height) { first_row = y; }
+                last_row = y;
+            }
+        }
+
+        if (last_row >= 0) {
+            SDL_Rect band = {0, first_row, width, last_row - first_row + 1};
+            SDL_UpdateTexture(texture, &band, pixels[first_row], DISPLAY_HIRES_WIDTH * sizeof(uint32_t));
+        }
+        display.clear_dirty_rows();
+    }
+
+    // One scaled copy of the current resolution replaces thousands of rectangle fills
+    SDL_Rect source = {0, 0, width, height};
+    SDL_Rect destination = {0, 0, DISPLAY_WIDTH * pixel_scale, DISPLAY_HEIGHT * pixel_scale};
+    SDL_RenderCopy(renderer, texture, &source, &destination);
+}
@@ -0,0 +1,46 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <SDL.h>   // Include SDL header
+#include <cstdint> // For uint32_t and uint64_t
+#include "display.h"
+
+// How the Chip-8 framebuffer reaches the window
+enum class RendererBackend {
+    FillRects,        // One SDL_RenderFillRect per lit pixel
+    StreamingTexture  // Expand rows into a streaming texture and draw it with one SDL_RenderCopy
+};
+
+// Draws a Display into an SDL renderer and keeps frame-time statistics.
+class Renderer {
+public:
+    Renderer(SDL_Renderer* renderer, RendererBackend backend, int pixel_scale);
+    ~Renderer();
+
+    // Draw the current framebuffer and present it
+    void present(Display& display);
+
+    RendererBackend get_backend() const;
+
+    // Average host time spent in present(), in microseconds
+    double get_average_frame_time_us() const;
+    uint64_t get_frames_presented() const;
+
+private:
+    SDL_Renderer* renderer;
+    SDL_Texture* texture;
+    RendererBackend backend;
+    int pixel_scale;
+
+    // CPU-side copy of the texture contents; only dirty rows are re-expanded. The texture is
+    // hi-res sized and lo-res frames use its top-left corner.
+    uint32_t pixels[DISPLAY_HIRES_HEIGHT][DISPLAY_HIRES_WIDTH];
+
+    uint64_t frames_presented;
+    double total_frame_time_us;
+
+    void draw_rects(const Display& display);
+    void draw_texture(Display& display);
+};
+
+#endif // RENDERER_H
@@ -0,0 +1,189 @@
+#include "rewind.h"
+#include <cstring> // For memcpy
+
+namespace {
+
+// Record layout in the ring: [u32 payload length][payload][u32 payload length].
+// The length at both ends lets the oldest record be dropped from the tail and the newest
+// one be read back from the head. The payload is a sequence of
+// (zero run, literal count, literal bytes) tokens with LEB128 counts, applied by XOR.
+const size_t RECORD_OVERHEAD = 8;
+
+// A literal run ends at this many zero bytes in a row
+const int MIN_ZERO_RUN = 3;
+
+void put_varint(std::vector<uint8_t>& out, size_t value) {
+    while (value >= 0x80) {
+        out.push_back((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(value);
+}
+
+size_t get_varint(const uint8_t* data, size_t& offset) {
+    size_t value = 0;
+    int shift = 0;
+    uint8_t byte;
+    do {
+        byte = data[offset++];
+        value |= (size_t) (byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return value;
+}
+
+// Bytes that matter when comparing two states: both may be of different variants
+size_t used_size(const SaveState& a, const SaveState& b) {
+    int size_a = savestate_size(savestate_variant(a));
+    int size_b = savestate_size(savestate_variant(b));
+    return size_a > size_b ? size_a : size_b;
+}
+
+// XOR delta between the first size bytes of two states as zero-run tokens
+void encode_delta(const SaveState& a, const SaveState& b, size_t size, std::vector<uint8_t>& out) {
+    out.clear();
+    size_t i = 0;
+    while (i < size) {
+        // Skip equal bytes a word at a time where possible
+        size_t zero_start = i;
+        while (i + 8 <= size) {
+            uint64_t wa, wb;
+            memcpy(&wa, a.data() + i, 8);
+            memcpy(&wb, b.data() + i, 8);
+            if (wa != wb) {
+                break;
+            }
+            i += 8;
+        }
+        while (i < size && a[i] == b[i]) {
+            i += 1;
+        }
+        if (i == size) {
+            break; // Trailing zeros are implied
+        }
+
+        size_t literal_start = i;
+        int zeros = 0;
+        while (i < size && zeros < MIN_ZERO_RUN) {
+            zeros = a[i] == b[i] ? zeros + 1 : 0;
+            i += 1;
+        }
+        size_t literal_end = i - zeros;
+
+        put_varint(out, literal_start - zero_start);
+        put_varint(out, literal_end - literal_start);
+        for (size_t j = literal_start; j < literal_end; j++) {
+            out.push_back(a[j] ^ b[j]);
+        }
+        i = literal_end;
+    }
+}
+
+void apply_delta(SaveState& state, const uint8_t* payload, size_t size) {
+    size_t offset = 0;
+    size_t position = 0;
+    while (offset < size) {
+        position += get_varint(payload, offset);
+        size_t literal_count = get_varint(payload, offset);
+        for (size_t j = 0; j < literal_count; j++) {
+            state[position++] ^= payload[offset++];
+        }
+    }
+}
+
+} // namespace
+
+RewindBuffer::RewindBuffer(size_t capacity_bytes) : ring(capacity_bytes) {
+    scratch.reserve(SAVESTATE_MAX_SIZE * 2);
+    clear();
+}
+
+void RewindBuffer::clear() {
+    head = 0;
+    tail = 0;
+    used = 0;
+    frame_count = 0;
+    has_current = false;
+}
+
+size_t RewindBuffer::get_frame_count() const { return frame_count; }
+size_t RewindBuffer::get_bytes_used() const { return used; }
+size_t RewindBuffer::get_capacity() const { return ring.size(); }
+
+void RewindBuffer::write_ring(size_t position, const uint8_t* data, size_t size) {
+    size_t first = ring.size() - position < size ? ring.size() - position : size;
+    memcpy(ring.data() + position, data, first);
+    memcpy(ring.data(), data + first, size - first);
+}
+
+void RewindBuffer::read_ring(size_t position, uint8_t* data, size_t size) const {
+    size_t first = ring.size() - position < size ? ring.size() - position : size;
+    memcpy(data, ring.data() + position, first);
+    memcpy(data + first, ring.data(), size - first);
+}
+
+uint32_t RewindBuffer::read_length(size_t position) const {
+    uint8_t bytes[4];
+    read_ring(position, bytes, 4);
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+}
+
+void RewindBuffer::drop_oldest() {
+    size_t record_size = read_length(tail) + RECORD_OVERHEAD;
+    tail = (tail + record_size) % ring.size();
+    used -= record_size;
+    frame_count -= 1;
+}
+
+void RewindBuffer::push(const SaveState& state) {
+    if (!has_current) {
+        current = state;
+        has_current = true;
+        return;
+    }
+
+    // The record turns the new state back into the previous one. Only the bytes either state
+    // uses are compared and kept, so a CHIP-8 frame costs a 4 KB image, not the 64 KB one.
+    size_t size = used_size(current, state);
+    encode_delta(current, state, size, scratch);
+    memcpy(current.data(), state.data(), size);
+
+    size_t record_size = scratch.size() + RECORD_OVERHEAD;
+    if (record_size > ring.size()) {
+        // Too big to keep at all: history before this frame is lost
+        head = tail = used = frame_count = 0;
+        return;
+    }
+    while (used + record_size > ring.size()) {
+        drop_oldest();
+    }
+
+    uint32_t length = scratch.size();
+    uint8_t length_bytes[4] = {(uint8_t) length, (uint8_t) (length >> 8), (uint8_t) (length >> 16), (uint8_t) (length >> 24)};
+    write_ring(head, length_bytes, 4);
+    write_ring((head + 4) % ring.size(), scratch.data(), length);
+    write_ring((head + 4 + length) % ring.size(), length_bytes, 4);
+    head = (head + record_size) % ring.size();
+    used += record_size;
+    frame_count += 1;
+}
+
+bool RewindBuffer::rewind(SaveState& state) {
+    if (frame_count == 0) {
+        return false;
+    }
+
+    // Walk back over the newest record
+    size_t length_position = (head + ring.size() - 4) % ring.size();
+    uint32_t length = read_length(length_position);
+    size_t record_start = (head + ring.size() - length - RECORD_OVERHEAD) % ring.size();
+    scratch.resize(length);
+    read_ring((record_start + 4) % ring.size(), scratch.data(), length);
+    apply_delta(current, scratch.data(), length);
+
+    head = record_start;
+    used -= length + RECORD_OVERHEAD;
+    frame_count -= 1;
+    memcpy(state.data(), current.data(), savestate_size(savestate_variant(current)));
+    return true;
+}
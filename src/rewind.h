@@ -0,0 +1,52 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <cstddef> // For size_t
+#include <cstdint> // For uint8_t and uint64_t
+#include <vector>  // For the ring storage
+#include "savestate.h"
+
+// Default rewind budget. Typical games change well under 100 bytes of state per frame,
+// which is several minutes of history at 60 frames per second.
+const size_t DEFAULT_REWIND_BYTES = 1 << 20;
+
+// Frame-by-frame history of savestates in a fixed amount of memory.
+// Only the newest state is kept whole. Each older frame is stored as the XOR of two
+// neighbouring states with runs of zero bytes collapsed, so unchanged memory costs
+// almost nothing. Records live in a byte ring; when it fills up the oldest frames go.
+class RewindBuffer {
+public:
+    explicit RewindBuffer(size_t capacity_bytes = DEFAULT_REWIND_BYTES);
+
+    // Forget all history
+    void clear();
+
+    // Record the state at the end of a frame
+    void push(const SaveState& state);
+
+    // Step back one frame: the state recorded before the newest one becomes the newest
+    // and is copied to state. Returns false when there is no older frame left.
+    bool rewind(SaveState& state);
+
+    size_t get_frame_count() const; // Frames that can be rewound
+    size_t get_bytes_used() const;
+    size_t get_capacity() const;
+
+private:
+    std::vector<uint8_t> ring;
+    size_t head;        // Where the next record is written
+    size_t tail;        // Start of the oldest record
+    size_t used;
+    size_t frame_count;
+
+    SaveState current;  // Newest state, stored whole
+    bool has_current;
+    std::vector<uint8_t> scratch;
+
+    void write_ring(size_t position, const uint8_t* data, size_t size);
+    void read_ring(size_t position, uint8_t* data, size_t size) const;
+    uint32_t read_length(size_t position) const;
+    void drop_oldest();
+};
+
+#endif // REWIND_H
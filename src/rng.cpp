@@ -0,0 +1,25 @@
+#include "rng.h"
+
+Rng::Rng(uint64_t initial_seed) {
+    seed(initial_seed);
+}
+
+void Rng::seed(uint64_t new_seed) {
+    state = new_seed != 0 ? new_seed : DEFAULT_RNG_SEED;
+}
+
+uint64_t Rng::next() {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1DULL;
+}
+
+uint8_t Rng::next_byte() {
+    // The high bits of xorshift64* are the strongest
+    return next() >> 56;
+}
+
+uint64_t Rng::get_state() const { return state; }
+
+void Rng::set_state(uint64_t new_state) { seed(new_state); }
@@ -0,0 +1,29 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint> // For uint8_t and uint64_t
+
+// Seed used until a machine is given its own
+const uint64_t DEFAULT_RNG_SEED = 0x9E3779B97F4A7C15ULL;
+
+// xorshift64* generator for CXNN. Each CPU owns one, so runs are reproducible from the
+// seed and parallel machines never share random state.
+class Rng {
+public:
+    explicit Rng(uint64_t seed = DEFAULT_RNG_SEED);
+
+    // Restart the sequence (a zero seed is replaced, since xorshift would stick at zero)
+    void seed(uint64_t seed);
+
+    uint64_t next();
+    uint8_t next_byte();
+
+    // Raw state, for savestates
+    uint64_t get_state() const;
+    void set_state(uint64_t state);
+
+private:
+    uint64_t state;
+};
+
+#endif // RNG_H
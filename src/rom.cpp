@@ -0,0 +1,31 @@
+#include "rom.h"
+
+#include <fstream>   // Required for file operations
+
+bool load_rom_file(const std::string& filepath, std::vector<uint8_t>& rom_data) {
+    // Open the file in binary mode and at the end to get its size
+    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // Get the file size
+    std::streamsize file_size = file.tellg();
+    if (file_size < 0) { // Check for potential errors with tellg
+        return false;
+    }
+
+    // Seek back to the beginning of the file
+    file.seekg(0, std::ios::beg);
+
+    // Size the vector to the exact size of the file
+    rom_data.resize(static_cast<size_t>(file_size));
+
+    // Read the entire file content into the vector
+    // reinterpret_cast<char*> is needed because std::ifstream::read expects a char* buffer
+    if (!file.read(reinterpret_cast<char*>(rom_data.data()), file_size)) {
+        rom_data.clear();
+        return false;
+    }
+    return true;
+}
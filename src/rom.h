@@ -0,0 +1,12 @@
+#ifndef ROM_H
+#define ROM_H
+
+#include <cstdint> // For uint8_t
+#include <string>  // For std::string
+#include <vector>  // For std::vector
+
+// Load a Chip-8 ROM file into a vector of bytes. Returns false if the file could not be
+// read; nothing is printed, so reporting the error is up to the caller.
+bool load_rom_file(const std::string& filepath, std::vector<uint8_t>& rom_data);
+
+#endif // ROM_H
@@ -0,0 +1,226 @@
+#include "rom_library.h"
+#include "input_source.h"
+
+#include <algorithm>  // For std::sort
+#include <cstdio>     // For snprintf
+#include <cstdlib>    // For strtoull and atoi
+#include <filesystem> // For walking ROM directories
+#include <fstream>    // For the database file and the read fallback
+#include <sstream>    // For parsing database lines
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CHIP8_MMAP_SUPPORTED 1
+#include <fcntl.h>    // For open
+#include <sys/mman.h> // For mmap
+#include <sys/stat.h> // For fstat
+#include <unistd.h>   // For close
+#else
+#define CHIP8_MMAP_SUPPORTED 0
+#endif
+
+MappedRom::MappedRom() {
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+}
+
+MappedRom::~MappedRom() {
+    close();
+}
+
+bool MappedRom::open(const std::string& filepath) {
+    close();
+
+#if CHIP8_MMAP_SUPPORTED
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    void* region = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps the file contents alive
+    if (region == MAP_FAILED) {
+        return false;
+    }
+    bytes = static_cast<const uint8_t*>(region);
+    length = static_cast<size_t>(info.st_size);
+    mapped = true;
+    return true;
+#else
+    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::streamsize file_size = file.tellg();
+    if (file_size <= 0) {
+        return false;
+    }
+    file.seekg(0, std::ios::beg);
+    buffer.resize(static_cast<size_t>(file_size));
+    if (!file.read(reinterpret_cast<char*>(buffer.data()), file_size)) {
+        buffer.clear();
+        return false;
+    }
+    bytes = buffer.data();
+    length = buffer.size();
+    return true;
+#endif
+}
+
+void MappedRom::close() {
+#if CHIP8_MMAP_SUPPORTED
+    if (mapped) {
+        munmap(const_cast<uint8_t*>(bytes), length);
+    }
+#endif
+    buffer.clear();
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+}
+
+const uint8_t* MappedRom::data() const { return bytes; }
+size_t MappedRom::size() const { return length; }
+
+uint64_t hash_rom(const uint8_t* data, size_t size) {
+    const uint64_t FNV_OFFSET = 0xCBF29CE484222325ULL;
+    const uint64_t FNV_PRIME = 0x100000001B3ULL;
+
+    uint64_t hash = FNV_OFFSET;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+std::string format_rom_hash(uint64_t hash) {
+    char text[17];
+    snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+}
+
+bool RomDatabase::load(const std::string& filepath) {
+    std::ifstream file(filepath);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string hash_text;
+        if (!(fields >> hash_text) || hash_text[0] == '#') {
+            continue;
+        }
+
+        RomProfile profile;
+        std::string field;
+        while (fields >> field) {
+            size_t equals = field.find('=');
+            if (equals == std::string::npos) {
+                continue;
+            }
+            std::string key = field.substr(0, equals);
+            std::string value = field.substr(equals + 1);
+            if (key == "name") {
+                profile.name = value;
+            } else if (key == "quirks") {
+                profile.has_quirks = true;
+                profile.new_functionality = value == "new";
+            } else if (key == "variant") {
+                profile.has_variant = parse_variant(value.c_str(), profile.variant);
+            } else if (key == "cycles") {
+                profile.cycles_per_frame = atoi(value.c_str());
+            } else if (key == "keys" && value.size() == CHIP8_KEY_COUNT) {
+                profile.key_map = value;
+            }
+        }
+        profiles[strtoull(hash_text.c_str(), nullptr, 16)] = profile;
+    }
+    return true;
+}
+
+bool RomDatabase::save(const std::string& filepath) const {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // Sorted by hash so the file diffs cleanly
+    std::vector<uint64_t> hashes;
+    for (const auto& entry : profiles) {
+        hashes.push_back(entry.first);
+    }
+    std::sort(hashes.begin(), hashes.end());
+
+    file << "# hash name=NAME quirks=old|new variant=chip8|schip|xochip cycles=N keys=16KEYS\n";
+    for (uint64_t hash : hashes) {
+        const RomProfile& profile = profiles.at(hash);
+        file << format_rom_hash(hash);
+        if (!profile.name.empty()) { file << " name=" << profile.name; }
+        if (profile.has_quirks) { file << " quirks=" << (profile.new_functionality ? "new" : "old"); }
+        if (profile.has_variant) { file << " variant=" << variant_name(profile.variant); }
+        if (profile.cycles_per_frame > 0) { file << " cycles=" << profile.cycles_per_frame; }
+        if (!profile.key_map.empty()) { file << " keys=" << profile.key_map; }
+        file << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+const RomProfile* RomDatabase::find(uint64_t hash) const {
+    auto found = profiles.find(hash);
+    return found != profiles.end() ? &found->second : nullptr;
+}
+
+void RomDatabase::set(uint64_t hash, const RomProfile& profile) { profiles[hash] = profile; }
+size_t RomDatabase::size() const { return profiles.size(); }
+
+size_t RomLibrary::index_directory(const std::string& directory) {
+    std::error_code error;
+    std::filesystem::recursive_directory_iterator walk(directory, std::filesystem::directory_options::skip_permission_denied, error);
+    if (error) {
+        return 0;
+    }
+
+    // Sizes come from the directory walk, so files that cannot be programs are never opened
+    size_t added = 0;
+    MappedRom rom;
+    // Advance with the error_code overload: the throwing one would let an I/O error part way
+    // through (say a directory removed during the walk) escape. Such an error ends the walk.
+    std::error_code walk_error;
+    for (; walk != std::filesystem::recursive_directory_iterator(); walk.increment(walk_error)) {
+        if (walk_error) {
+            break;
+        }
+        const std::filesystem::directory_entry& file = *walk;
+        if (!file.is_regular_file(error)) {
+            continue;
+        }
+        uintmax_t file_size = file.file_size(error);
+        if (error || file_size == 0 || file_size > static_cast<uintmax_t>(MAX_PROGRAM_SIZE)) {
+            continue;
+        }
+        if (!rom.open(file.path().string())) {
+            continue;
+        }
+
+        RomEntry entry = {file.path().string(), hash_rom(rom.data(), rom.size()), rom.size()};
+        by_hash.emplace(entry.hash, entries.size()); // Keeps the first copy of duplicates
+        entries.push_back(entry);
+        added += 1;
+    }
+    rom.close();
+    return added;
+}
+
+const std::vector<RomEntry>& RomLibrary::get_entries() const { return entries; }
+
+const RomEntry* RomLibrary::find(uint64_t hash) const {
+    auto found = by_hash.find(hash);
+    return found != by_hash.end() ? &entries[found->second] : nullptr;
+}
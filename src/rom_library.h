@@ -0,0 +1,94 @@
+#ifndef ROM_LIBRARY_H
+#define ROM_LIBRARY_H
+
+#include <cstddef>       // For size_t
+#include <cstdint>       // For uint8_t and uint64_t
+#include <string>        // For paths and names
+#include <unordered_map> // For hash lookups
+#include <vector>        // For the index and the read fallback
+#include "cpu.h"
+
+// Largest program that fits in memory above 0x200 (XO-CHIP; CHIP-8 and SUPER-CHIP programs
+// must fit in CHIP8_MEMORY_SIZE)
+const int MAX_PROGRAM_SIZE = MEMORY_COUNT - PROGRAM_BUFFER;
+
+// Read-only view of a ROM file. The file is memory-mapped where the platform allows it
+// (POSIX), so loading it into the CPU is the only copy; elsewhere it is read into a buffer.
+class MappedRom {
+public:
+    MappedRom();
+    ~MappedRom();
+    MappedRom(const MappedRom&) = delete;
+    MappedRom& operator=(const MappedRom&) = delete;
+
+    // Map a file, replacing any previous one. Returns false if it cannot be opened or is empty.
+    bool open(const std::string& filepath);
+    void close();
+
+    const uint8_t* data() const;
+    size_t size() const;
+
+private:
+    const uint8_t* bytes;
+    size_t length;
+    bool mapped;                 // bytes points at an mmap'ed region
+    std::vector<uint8_t> buffer; // Holds the contents when mapping is not available
+};
+
+// 64-bit FNV-1a of the ROM contents; identifies a ROM regardless of its file name
+uint64_t hash_rom(const uint8_t* data, size_t size);
+std::string format_rom_hash(uint64_t hash); // 16 lower-case hex digits
+
+// Per-ROM settings. Fields that were not given keep the front end's defaults.
+struct RomProfile {
+    std::string name;
+    bool has_quirks = false;
+    bool new_functionality = false; // quirks=new (CHIP-48) or quirks=old
+    bool has_variant = false;
+    Chip8Variant variant = Chip8Variant::Chip8; // variant=chip8|schip|xochip
+    int cycles_per_frame = 0;       // 0 = not set
+    std::string key_map;            // 16 keyboard keys for Chip-8 keys 0-F, empty = not set
+};
+
+// Local text database of ROM profiles, one line per ROM:
+//   <hash> [name=NAME] [quirks=old|new] [variant=chip8|schip|xochip] [cycles=N] [keys=16KEYS]
+// Blank lines and lines starting with # are ignored. Names cannot contain spaces.
+class RomDatabase {
+public:
+    // Add the entries in a file to the database. Returns false if the file cannot be read.
+    bool load(const std::string& filepath);
+    bool save(const std::string& filepath) const;
+
+    const RomProfile* find(uint64_t hash) const;
+    void set(uint64_t hash, const RomProfile& profile);
+    size_t size() const;
+
+private:
+    std::unordered_map<uint64_t, RomProfile> profiles;
+};
+
+// A ROM found while indexing a directory
+struct RomEntry {
+    std::string path;
+    uint64_t hash;
+    size_t size;
+};
+
+// Content-hash index of a directory tree of ROM files
+class RomLibrary {
+public:
+    // Hash every regular file that could be a program (1 to MAX_PROGRAM_SIZE bytes) below a
+    // directory. Returns the number of ROMs added.
+    size_t index_directory(const std::string& directory);
+
+    const std::vector<RomEntry>& get_entries() const;
+
+    // First indexed ROM with the given contents, or nullptr
+    const RomEntry* find(uint64_t hash) const;
+
+private:
+    std::vector<RomEntry> entries;
+    std::unordered_map<uint64_t, size_t> by_hash; // Hash -> index into entries
+};
+
+#endif // ROM_LIBRARY_H
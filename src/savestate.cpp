@@ -0,0 +1,63 @@
+#include "savestate.h"
+
+#include <fstream> // For reading and writing state files
+
+int savestate_size(Chip8Variant variant) {
+    int memory_size = variant == Chip8Variant::XoChip ? MEMORY_COUNT : CHIP8_MEMORY_SIZE;
+    return SAVESTATE_CPU_OFFSET + CPU_STATE_HEADER_SIZE + memory_size;
+}
+
+void write_savestate_header(SaveState& state, Chip8Variant variant) {
+    state[0] = 'C';
+    state[1] = '8';
+    state[2] = 'S';
+    state[3] = 'S';
+    state[4] = SAVESTATE_VERSION & 0xFF;
+    state[5] = SAVESTATE_VERSION >> 8;
+    state[6] = static_cast<uint8_t>(variant);
+    state[7] = 0;
+    int size = savestate_size(variant);
+    for (int b = 0; b < 4; b++) {
+        state[8 + b] = (size >> (b * 8)) & 0xFF;
+    }
+}
+
+bool is_valid_savestate(const SaveState& state) {
+    return state[0] == 'C' && state[1] == '8' && state[2] == 'S' && state[3] == 'S' &&
+           (state[4] | (state[5] << 8)) == SAVESTATE_VERSION &&
+           state[6] <= static_cast<uint8_t>(Chip8Variant::XoChip) && state[7] == 0 &&
+           (state[8] | (state[9] << 8) | (state[10] << 16) | ((uint32_t) state[11] << 24)) ==
+               (uint32_t) savestate_size(savestate_variant(state));
+}
+
+Chip8Variant savestate_variant(const SaveState& state) { return static_cast<Chip8Variant>(state[6]); }
+
+bool save_state_file(const std::string& filepath, const SaveState& state) {
+    std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(state.data()), savestate_size(savestate_variant(state)));
+    return static_cast<bool>(file);
+}
+
+bool load_state_file(const std::string& filepath, SaveState& state) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    // The header says how much follows
+    if (!file.read(reinterpret_cast<char*>(state.data()), SAVESTATE_HEADER_SIZE) ||
+        state[6] > static_cast<uint8_t>(Chip8Variant::XoChip)) {
+        return false;
+    }
+    int size = savestate_size(savestate_variant(state));
+    if (!file.read(reinterpret_cast<char*>(state.data()) + SAVESTATE_HEADER_SIZE, size - SAVESTATE_HEADER_SIZE)) {
+        return false;
+    }
+    // Trailing bytes mean the file is something else
+    if (file.peek() != std::ifstream::traits_type::eof()) {
+        return false;
+    }
+    return is_valid_savestate(state);
+}
@@ -0,0 +1,40 @@
+#ifndef SAVESTATE_H
+#define SAVESTATE_H
+
+#include <array>   // For the fixed-size state image
+#include <cstdint> // For uint8_t
+#include <string>  // For file paths
+#include "cpu.h"
+#include "display.h"
+
+// Savestate image: a 12-byte header ("C8SS", u16 format version, variant, a zero byte, u32
+// total size, all little-endian) followed by the display state and the CPU state, which ends
+// with the variant's memory. The size depends only on the variant, so capturing a state is a
+// handful of copies and two states can be compared or XORed byte for byte. A SaveState has
+// room for the largest variant; only the first savestate_size() bytes are used.
+// 2: CPU block carries the RNG state
+// 3: 64 KB memory image, SUPER-CHIP / XO-CHIP registers, two 128x64 display planes
+// 4: header records the variant; states only load into a machine running the same one
+// 5: display before CPU, memory image only as large as the variant's memory
+const uint16_t SAVESTATE_VERSION = 5;
+const int SAVESTATE_HEADER_SIZE = 12;
+const int SAVESTATE_DISPLAY_OFFSET = SAVESTATE_HEADER_SIZE;
+const int SAVESTATE_CPU_OFFSET = SAVESTATE_DISPLAY_OFFSET + DISPLAY_STATE_SIZE;
+const int SAVESTATE_MAX_SIZE = SAVESTATE_CPU_OFFSET + CPU_STATE_MAX_SIZE;
+
+typedef std::array<uint8_t, SAVESTATE_MAX_SIZE> SaveState;
+
+// Bytes used by a state of the variant
+int savestate_size(Chip8Variant variant);
+
+// Fill in / check the header
+void write_savestate_header(SaveState& state, Chip8Variant variant);
+bool is_valid_savestate(const SaveState& state);
+Chip8Variant savestate_variant(const SaveState& state); // Only meaningful for a valid state
+
+// Write a state's used bytes to disk / read one back. Both return false on I/O errors, and
+// reading also fails if the file is not a savestate of this version.
+bool save_state_file(const std::string& filepath, const SaveState& state);
+bool load_state_file(const std::string& filepath, SaveState& state);
+
+#endif // SAVESTATE_H
@@ -0,0 +1,35 @@
+#include "scheduler.h"
+#include <thread> // For std::this_thread::sleep_until
+
+FrameScheduler::FrameScheduler(int frames_per_second, int max_catch_up) {
+    frame_duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::nanoseconds(1000000000 / frames_per_second));
+    max_catch_up_frames = max_catch_up > 0 ? max_catch_up : 1;
+    dropped_frames = 0;
+    reset();
+}
+
+void FrameScheduler::reset() { next_deadline = std::chrono::steady_clock::now(); }
+
+int FrameScheduler::frames_due() {
+    auto now = std::chrono::steady_clock::now();
+    if (now < next_deadline) {
+        return 0;
+    }
+
+    // Every whole frame period that has passed since the deadline is owed
+    int64_t due = 1 + (now - next_deadline) / frame_duration;
+    if (due > max_catch_up_frames) {
+        // Too far behind: run what the cap allows and re-anchor on the current time
+        dropped_frames += due - max_catch_up_frames;
+        next_deadline = now + frame_duration;
+        return max_catch_up_frames;
+    }
+
+    next_deadline += due * frame_duration;
+    return static_cast<int>(due);
+}
+
+void FrameScheduler::wait_for_next_frame() { std::this_thread::sleep_until(next_deadline); }
+
+uint64_t FrameScheduler::get_dropped_frames() const { return dropped_frames; }
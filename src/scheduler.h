@@ -0,0 +1,35 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <chrono>  // For frame deadlines
+#include <cstdint> // For uint64_t
+
+// Most frames run back to back to catch up after a stall before the rest are dropped
+const int DEFAULT_MAX_CATCH_UP_FRAMES = 5;
+
+// Paces emulation in whole frames. Each frame the caller runs a batch of cycles and ticks
+// the timers once, then sleeps until the next deadline instead of spinning on the clock.
+class FrameScheduler {
+public:
+    explicit FrameScheduler(int frames_per_second, int max_catch_up_frames = DEFAULT_MAX_CATCH_UP_FRAMES);
+
+    // Number of frames that should be emulated now. Normally 1; more after a stall
+    // (up to the catch-up cap, the rest are dropped); 0 if called before the deadline.
+    int frames_due();
+
+    // Sleep until the next frame deadline
+    void wait_for_next_frame();
+
+    // Start pacing again from now (e.g. after the window was minimised or paused)
+    void reset();
+
+    uint64_t get_dropped_frames() const;
+
+private:
+    std::chrono::steady_clock::duration frame_duration;
+    std::chrono::steady_clock::time_point next_deadline;
+    int max_catch_up_frames;
+    uint64_t dropped_frames;
+};
+
+#endif // SCHEDULER_H
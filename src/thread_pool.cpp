@@ -0,0 +1,116 @@
+#include "thread_pool.h"
+
+namespace {
+// Index of the pool worker running on this thread, or -1 for outside threads
+thread_local int current_worker = -1;
+}
+
+WorkStealingPool::WorkStealingPool(int thread_count) : pending(0), next_queue(0), stopping(false) {
+    if (thread_count <= 0) {
+        thread_count = static_cast<int>(std::thread::hardware_concurrency());
+        if (thread_count <= 0) { thread_count = 1; }
+    }
+
+    for (int i = 0; i < thread_count; i++) {
+        queues.emplace_back(new WorkerQueue());
+    }
+    for (int i = 0; i < thread_count; i++) {
+        workers.emplace_back(&WorkStealingPool::worker_loop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait_idle();
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        stopping = true;
+    }
+    work_available.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+int WorkStealingPool::get_thread_count() const { return static_cast<int>(workers.size()); }
+
+void WorkStealingPool::submit(std::function<void()> task) {
+    int index = current_worker;
+    if (index < 0) {
+        index = next_queue.fetch_add(1) % queues.size();
+    }
+
+    pending.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+
+    // Take the wake lock so a worker that just found nothing cannot miss this notification
+    std::lock_guard<std::mutex> lock(wake_mutex);
+    work_available.notify_one();
+}
+
+void WorkStealingPool::wait_idle() {
+    std::unique_lock<std::mutex> lock(wake_mutex);
+    all_done.wait(lock, [this] { return pending.load() == 0; });
+}
+
+bool WorkStealingPool::take_task(int index, std::function<void()>& task) {
+    // Own queue first, newest task (it is most likely to have warm data)
+    {
+        WorkerQueue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Then steal the oldest task from the other workers
+    int count = static_cast<int>(queues.size());
+    for (int offset = 1; offset < count; offset++) {
+        WorkerQueue& victim = *queues[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::worker_loop(int index) {
+    current_worker = index;
+    std::function<void()> task;
+
+    while (true) {
+        if (take_task(index, task)) {
+            task();
+            task = nullptr;
+            if (pending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(wake_mutex);
+                all_done.notify_all();
+            }
+            continue;
+        }
+
+        // Nothing anywhere: sleep until new work arrives or the pool shuts down
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        if (stopping) {
+            return;
+        }
+        work_available.wait(lock, [&] {
+            if (stopping) { return true; }
+            for (auto& queue : queues) {
+                std::lock_guard<std::mutex> queue_lock(queue->mutex);
+                if (!queue->tasks.empty()) { return true; }
+            }
+            return false;
+        });
+        if (stopping && pending.load() == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>             // For the pending task count
+#include <condition_variable> // For sleeping idle workers
+#include <deque>              // For per-worker task queues
+#include <functional>         // For std::function
+#include <memory>             // For std::unique_ptr
+#include <mutex>              // For queue locks
+#include <thread>             // For std::thread
+#include <vector>             // For the worker list
+
+// Fixed-size thread pool where every worker owns a task deque. Workers take their own newest
+// task first and, when empty, steal the oldest task from another worker, so uneven jobs
+// (short and long ROM runs mixed together) still keep every core busy.
+class WorkStealingPool {
+public:
+    // thread_count of 0 uses one worker per hardware thread
+    explicit WorkStealingPool(int thread_count = 0);
+    ~WorkStealingPool();
+
+    // Queue a task. Tasks submitted from a worker go on that worker's own deque.
+    void submit(std::function<void()> task);
+
+    // Block until every submitted task has finished
+    void wait_idle();
+
+    int get_thread_count() const;
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<int> pending;      // Submitted but not yet finished
+    std::atomic<unsigned> next_queue; // Round-robin target for external submissions
+    bool stopping;
+
+    std::mutex wake_mutex;
+    std::condition_variable work_available;
+    std::condition_variable all_done;
+
+    bool take_task(int index, std::function<void()>& task);
+    void worker_loop(int index);
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,284 @@
+#include "trace.h"
+#include <cstring> // For memcpy and memset
+
+static const uint8_t TRACE_MAGIC[4] = {'C', '8', 'T', 'R'};
+
+TraceWriter::TraceWriter() {
+    stopping = false;
+    failed = false;
+    next_pc = PROGRAM_BUFFER;
+    index_register = 0;
+    stack_pointer = 0;
+    memset(registers, 0, sizeof(registers));
+    records = 0;
+    bytes = 0;
+}
+
+TraceWriter::~TraceWriter() {
+    close();
+}
+
+bool TraceWriter::open(const std::string& filepath) {
+    close();
+    file.open(filepath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    stopping = false;
+    failed = false;
+    next_pc = PROGRAM_BUFFER;
+    index_register = 0;
+    stack_pointer = 0;
+    memset(registers, 0, sizeof(registers));
+    records = 0;
+
+    free.clear();
+    for (int i = 1; i < TRACE_BUFFER_COUNT; i++) {
+        free.emplace_back();
+        free.back().reserve(TRACE_BUFFER_SIZE);
+    }
+    buffer.clear();
+    buffer.reserve(TRACE_BUFFER_SIZE);
+    buffer.insert(buffer.end(), TRACE_MAGIC, TRACE_MAGIC + 4);
+    buffer.push_back(TRACE_VERSION & 0xFF);
+    buffer.push_back(TRACE_VERSION >> 8);
+    buffer.push_back(0);
+    buffer.push_back(0);
+    bytes = TRACE_HEADER_SIZE;
+
+    writer = std::thread(&TraceWriter::write_loop, this);
+    return true;
+}
+
+void TraceWriter::record(uint16_t pc, uint16_t opcode, uint16_t new_index, uint8_t new_stack_pointer,
+                         const uint8_t new_registers[REGISTER_COUNT]) {
+    if (buffer.size() > TRACE_BUFFER_SIZE - TRACE_MAX_RECORD_SIZE) {
+        submit_buffer();
+    }
+
+    // Reserve the tag and fill it in once the changes are known
+    size_t start = buffer.size();
+    buffer.push_back(0);
+    uint8_t tag = 0;
+    if (pc != next_pc) {
+        tag |= TRACE_PC;
+        buffer.push_back(pc & 0xFF);
+        buffer.push_back(pc >> 8);
+    }
+    buffer.push_back(opcode & 0xFF);
+    buffer.push_back(opcode >> 8);
+    next_pc = pc + 2;
+
+    if (new_index != index_register) {
+        tag |= TRACE_I;
+        buffer.push_back(new_index & 0xFF);
+        buffer.push_back(new_index >> 8);
+        index_register = new_index;
+    }
+    if (new_stack_pointer != stack_pointer) {
+        tag |= TRACE_SP;
+        buffer.push_back(new_stack_pointer);
+        stack_pointer = new_stack_pointer;
+    }
+
+    uint16_t changed_mask = 0;
+    int changed_count = 0;
+    int last_changed = 0;
+    for (int r = 0; r < REGISTER_COUNT; r++) {
+        uint8_t value = new_registers[r];
+        if (value != registers[r]) {
+            changed_mask |= 1 << r;
+            changed_count += 1;
+            last_changed = r;
+            registers[r] = value;
+        }
+    }
+    if (changed_count == 1) {
+        tag |= TRACE_ONE_REGISTER;
+        buffer.push_back(last_changed);
+        buffer.push_back(registers[last_changed]);
+    } else if (changed_count > 1) {
+        tag |= TRACE_REGISTERS;
+        buffer.push_back(changed_mask & 0xFF);
+        buffer.push_back(changed_mask >> 8);
+        for (int r = 0; r < REGISTER_COUNT; r++) {
+            if (changed_mask & (1 << r)) {
+                buffer.push_back(registers[r]);
+            }
+        }
+    }
+
+    buffer[start] = tag;
+    bytes += buffer.size() - start;
+    records += 1;
+}
+
+void TraceWriter::mark_frame() {
+    if (buffer.size() > TRACE_BUFFER_SIZE - TRACE_MAX_RECORD_SIZE) {
+        submit_buffer();
+    }
+    buffer.push_back(TRACE_FRAME);
+    bytes += 1;
+}
+
+void TraceWriter::submit_buffer() {
+    std::unique_lock<std::mutex> lock(mutex);
+    full.push_back(std::move(buffer));
+    changed.notify_all();
+    // Every spare buffer is queued for writing: wait for the disk to catch up
+    changed.wait(lock, [this]() { return !free.empty(); });
+    buffer = std::move(free.back());
+    free.pop_back();
+}
+
+void TraceWriter::write_loop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        changed.wait(lock, [this]() { return stopping || !full.empty(); });
+        if (full.empty()) {
+            return; // Stopping with nothing left to write
+        }
+        std::vector<uint8_t> data = std::move(full.front());
+        full.pop_front();
+
+        lock.unlock();
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        bool ok = static_cast<bool>(file);
+        data.clear();
+        lock.lock();
+
+        failed = failed || !ok;
+        free.push_back(std::move(data));
+        changed.notify_all();
+    }
+}
+
+bool TraceWriter::close() {
+    if (!writer.joinable()) {
+        return !failed;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        full.push_back(std::move(buffer));
+        stopping = true;
+        changed.notify_all();
+    }
+    writer.join();
+    buffer.clear();
+    file.close();
+    return !failed && !file.fail();
+}
+
+uint64_t TraceWriter::get_records() const { return records; }
+uint64_t TraceWriter::get_bytes() const { return bytes; }
+
+TraceReader::TraceReader() {
+    position = 0;
+    length = 0;
+    damaged = false;
+    memset(&state, 0, sizeof(state));
+}
+
+bool TraceReader::open(const std::string& filepath) {
+    file.open(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    buffer.resize(TRACE_BUFFER_SIZE);
+    position = 0;
+    length = 0;
+    damaged = false;
+    memset(&state, 0, sizeof(state));
+    state.pc = PROGRAM_BUFFER - 2;
+
+    uint8_t header[TRACE_HEADER_SIZE];
+    for (int i = 0; i < TRACE_HEADER_SIZE; i++) {
+        if (!read_byte(header[i])) {
+            return false;
+        }
+    }
+    return memcmp(header, TRACE_MAGIC, 4) == 0 && (header[4] | (header[5] << 8)) == TRACE_VERSION;
+}
+
+bool TraceReader::fill() {
+    file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+    length = static_cast<size_t>(file.gcount());
+    position = 0;
+    return length > 0;
+}
+
+bool TraceReader::read_byte(uint8_t& value) {
+    if (position == length && !fill()) {
+        return false;
+    }
+    value = buffer[position++];
+    return true;
+}
+
+bool TraceReader::read_u16(uint16_t& value) {
+    uint8_t low = 0;
+    uint8_t high = 0;
+    if (!read_byte(low) || !read_byte(high)) {
+        return false;
+    }
+    value = low | (high << 8);
+    return true;
+}
+
+bool TraceReader::next(TraceRecord& record) {
+    uint8_t tag = 0;
+    while (true) {
+        if (!read_byte(tag)) {
+            return false; // Clean end of the trace
+        }
+        if (tag != TRACE_FRAME) {
+            break;
+        }
+        state.frame += 1;
+    }
+
+    // From here on the stream must hold the whole record
+    damaged = true;
+    if (tag & ~(TRACE_PC | TRACE_I | TRACE_SP | TRACE_ONE_REGISTER | TRACE_REGISTERS)) {
+        return false;
+    }
+    uint16_t pc = state.pc + 2;
+    if ((tag & TRACE_PC) && !read_u16(pc)) {
+        return false;
+    }
+    if (!read_u16(state.opcode)) {
+        return false;
+    }
+    state.pc = pc;
+    if ((tag & TRACE_I) && !read_u16(state.index_register)) {
+        return false;
+    }
+    if ((tag & TRACE_SP) && !read_byte(state.stack_pointer)) {
+        return false;
+    }
+    if (tag & TRACE_ONE_REGISTER) {
+        uint8_t index = 0;
+        if (!read_byte(index) || index >= REGISTER_COUNT || !read_byte(state.registers[index])) {
+            return false;
+        }
+    }
+    if (tag & TRACE_REGISTERS) {
+        uint16_t mask = 0;
+        if (!read_u16(mask)) {
+            return false;
+        }
+        for (int r = 0; r < REGISTER_COUNT; r++) {
+            if ((mask & (1 << r)) && !read_byte(state.registers[r])) {
+                return false;
+            }
+        }
+    }
+    damaged = false;
+
+    record = state;
+    state.index += 1;
+    return true;
+}
+
+bool TraceReader::is_damaged() const { return damaged; }
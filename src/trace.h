@@ -0,0 +1,125 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <condition_variable> // For handing buffers to the writer thread
+#include <cstddef>            // For size_t
+#include <cstdint>            // For uint8_t, uint16_t and uint64_t
+#include <deque>              // For the queue of full buffers
+#include <fstream>            // For the trace files
+#include <mutex>              // For the buffer queues
+#include <string>             // For file paths
+#include <thread>             // For the writer thread
+#include <vector>             // For the buffers
+#include "cpu.h" // For REGISTER_COUNT and PROGRAM_BUFFER
+
+// Execution trace: the 4-byte magic "C8TR" and a u16 format version (little-endian) padded to
+// 8 bytes, then one record per executed instruction describing the state right after it, as a
+// delta against the record before. A record is a tag byte, the instruction (u16) and the
+// fields the tag announces, in this order:
+//   0x01 PC (u16), given when the instruction was not at the previous one's PC + 2
+//   0x02 I (u16)
+//   0x04 SP (u8)
+//   0x08 one register changed: index (u8), value (u8)
+//   0x10 several registers changed: mask (u16, bit n = Vn), then each new value in order
+// A lone tag of 0x80 marks the end of a frame. All multi-byte fields are little-endian.
+// Before the first record every field is zero and the expected PC is 0x200.
+const uint16_t TRACE_VERSION = 1;
+const int TRACE_HEADER_SIZE = 8;
+const uint8_t TRACE_PC = 0x01;
+const uint8_t TRACE_I = 0x02;
+const uint8_t TRACE_SP = 0x04;
+const uint8_t TRACE_ONE_REGISTER = 0x08;
+const uint8_t TRACE_REGISTERS = 0x10;
+const uint8_t TRACE_FRAME = 0x80;
+
+// Size of the buffers the writer thread flushes, and how many exist; when all of them are
+// waiting for the disk, emulation waits too rather than dropping records
+const size_t TRACE_BUFFER_SIZE = 1 << 20;
+const int TRACE_BUFFER_COUNT = 4;
+const size_t TRACE_MAX_RECORD_SIZE = 1 + 2 + 2 + 2 + 1 + 2 + REGISTER_COUNT;
+
+// State after one traced instruction, as rebuilt by TraceReader
+struct TraceRecord {
+    uint64_t index; // Instructions before this one in the trace
+    uint64_t frame; // Frame markers before this one
+    uint16_t pc;    // Address the instruction was fetched from
+    uint16_t opcode;
+    uint16_t index_register;
+    uint8_t stack_pointer;
+    uint8_t registers[REGISTER_COUNT];
+};
+
+// Encodes records into large buffers that a background thread writes to disk, so the
+// emulation thread only pays for the delta encoding.
+class TraceWriter {
+public:
+    TraceWriter();
+    ~TraceWriter();
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    // Start a trace file. Returns false if it cannot be created.
+    bool open(const std::string& filepath);
+
+    // Record the state after the instruction fetched at pc
+    void record(uint16_t pc, uint16_t opcode, uint16_t new_index, uint8_t new_stack_pointer,
+                const uint8_t new_registers[REGISTER_COUNT]);
+    void mark_frame();
+
+    // Flush everything and stop the writer thread. Returns false if any write failed.
+    bool close();
+
+    uint64_t get_records() const;
+    uint64_t get_bytes() const; // Including the header
+
+private:
+    std::ofstream file;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> full;  // Waiting to be written, oldest first
+    std::vector<std::vector<uint8_t>> free; // Written and ready for reuse
+    bool stopping;
+    bool failed;
+
+    // Owned by the emulation thread
+    std::vector<uint8_t> buffer;
+    uint16_t next_pc;
+    uint16_t index_register;
+    uint8_t stack_pointer;
+    uint8_t registers[REGISTER_COUNT];
+    uint64_t records;
+    uint64_t bytes;
+
+    void submit_buffer();
+    void write_loop();
+};
+
+// Reads a trace back one instruction at a time through a fixed-size buffer, so traces of any
+// length can be walked without loading them.
+class TraceReader {
+public:
+    TraceReader();
+
+    // Returns false if the file cannot be read or is not a trace of this version
+    bool open(const std::string& filepath);
+
+    // Decode the next instruction record, skipping frame markers. Returns false at the end of
+    // the trace or on a damaged record (see is_damaged()).
+    bool next(TraceRecord& record);
+    bool is_damaged() const;
+
+private:
+    std::ifstream file;
+    std::vector<uint8_t> buffer;
+    size_t position;
+    size_t length;
+    bool damaged;
+    TraceRecord state;
+
+    bool read_byte(uint8_t& value);
+    bool read_u16(uint16_t& value);
+    bool fill();
+};
+
+#endif // TRACE_H
@@ -0,0 +1,116 @@
+// trace_diff.cpp
+//
+// Finds the first instruction where two execution traces (chip8-headless --trace=FILE) part
+// ways. Both traces are streamed through small buffers, so they can be far larger than memory.
+// Usage: chip8-trace-diff [--context=N] <a.trace> <b.trace>
+//   --context=N   Also print the last N instructions both traces agree on (default 4)
+// Exit status: 0 if the traces are identical, 1 if they differ, 2 if one cannot be read.
+
+#include "trace.h"
+
+#include <cstdio>   // For printf
+#include <cstdlib>  // For atoi
+#include <cstring>  // For strncmp and memcmp
+#include <deque>    // For the context window
+#include <iostream> // For errors
+#include <string>   // For field lists
+
+static void print_record(const char* label, const TraceRecord& record) {
+    printf("%s #%llu frame %llu  PC=%03X op=%04X I=%03X SP=%X  V:",
+           label, (unsigned long long) record.index, (unsigned long long) record.frame,
+           record.pc, record.opcode, record.index_register, record.stack_pointer);
+    for (int r = 0; r < REGISTER_COUNT; r++) {
+        printf(" %02X", record.registers[r]);
+    }
+    printf("\n");
+}
+
+// Names of the fields that differ between two records of the same index
+static std::string differing_fields(const TraceRecord& a, const TraceRecord& b) {
+    std::string fields;
+    auto add = [&fields](const std::string& name) { fields += (fields.empty() ? "" : ", ") + name; };
+    if (a.frame != b.frame) { add("frame"); }
+    if (a.pc != b.pc) { add("PC"); }
+    if (a.opcode != b.opcode) { add("opcode"); }
+    if (a.index_register != b.index_register) { add("I"); }
+    if (a.stack_pointer != b.stack_pointer) { add("SP"); }
+    for (int r = 0; r < REGISTER_COUNT; r++) {
+        if (a.registers[r] != b.registers[r]) { add("V" + std::string(1, "0123456789ABCDEF"[r])); }
+    }
+    return fields;
+}
+
+static bool same_record(const TraceRecord& a, const TraceRecord& b) {
+    return a.pc == b.pc && a.opcode == b.opcode && a.index_register == b.index_register &&
+           a.stack_pointer == b.stack_pointer && memcmp(a.registers, b.registers, REGISTER_COUNT) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    const char* paths[2] = {nullptr, nullptr};
+    int path_count = 0;
+    size_t context = 4;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--context=", 10) == 0) {
+            context = static_cast<size_t>(atoi(argv[i] + 10));
+        } else if (path_count < 2) {
+            paths[path_count++] = argv[i];
+        }
+    }
+    if (path_count != 2) {
+        std::cerr << "Usage: " << argv[0] << " [--context=N] <a.trace> <b.trace>" << std::endl;
+        return 2;
+    }
+
+    TraceReader readers[2];
+    for (int t = 0; t < 2; t++) {
+        if (!readers[t].open(paths[t])) {
+            std::cerr << "Not a readable trace: " << paths[t] << std::endl;
+            return 2;
+        }
+    }
+
+    std::deque<TraceRecord> recent; // Last records both traces agree on
+    TraceRecord a;
+    TraceRecord b;
+    while (true) {
+        bool has_a = readers[0].next(a);
+        bool has_b = readers[1].next(b);
+        for (int t = 0; t < 2; t++) {
+            if (readers[t].is_damaged()) {
+                std::cerr << "Damaged trace: " << paths[t] << std::endl;
+                return 2;
+            }
+        }
+
+        if (!has_a && !has_b) {
+            printf("Traces are identical (%llu instructions)\n",
+                   (unsigned long long) (recent.empty() ? 0 : recent.back().index + 1));
+            return 0;
+        }
+
+        if (has_a && has_b && same_record(a, b)) {
+            // Frame boundaries may legitimately fall elsewhere (e.g. other cycles per frame)
+            recent.push_back(a);
+            if (recent.size() > context) {
+                recent.pop_front();
+            }
+            continue;
+        }
+
+        for (const TraceRecord& record : recent) {
+            print_record("  both", record);
+        }
+        if (!has_a || !has_b) {
+            const TraceRecord& longer = has_a ? a : b;
+            printf("%s ends after %llu instructions; the other continues:\n",
+                   has_a ? paths[1] : paths[0], (unsigned long long) longer.index);
+            print_record(has_a ? "  a" : "  b", longer);
+            return 1;
+        }
+        printf("First divergence at instruction %llu (%s):\n", (unsigned long long) a.index,
+               differing_fields(a, b).c_str());
+        print_record("  a", a);
+        print_record("  b", b);
+        return 1;
+    }
+}
@@ -0,0 +1,40 @@
+#include "triple_buffer.h"
+#include <cstring> // For memset
+
+static const uint8_t SLOT_MASK = 0x03;
+static const uint8_t FRESH = 0x04;
+
+FrameTripleBuffer::FrameTripleBuffer() {
+    memset(slots, 0, sizeof(slots));
+    back_index = 0;
+    middle.store(1, std::memory_order_relaxed);
+    front_index = 2;
+    published.store(0, std::memory_order_relaxed);
+    overwritten.store(0, std::memory_order_relaxed);
+}
+
+PublishedFrame& FrameTripleBuffer::back() { return slots[back_index]; }
+
+void FrameTripleBuffer::publish() {
+    // Release makes the slot contents visible to the consumer that acquires it
+    uint8_t previous = middle.exchange(static_cast<uint8_t>(back_index) | FRESH, std::memory_order_acq_rel);
+    back_index = previous & SLOT_MASK;
+    published.fetch_add(1, std::memory_order_relaxed);
+    if (previous & FRESH) {
+        overwritten.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool FrameTripleBuffer::take() {
+    if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+        return false;
+    }
+    uint8_t previous = middle.exchange(static_cast<uint8_t>(front_index), std::memory_order_acq_rel);
+    front_index = previous & SLOT_MASK;
+    return true;
+}
+
+const PublishedFrame& FrameTripleBuffer::front() const { return slots[front_index]; }
+
+uint64_t FrameTripleBuffer::get_published() const { return published.load(std::memory_order_relaxed); }
+uint64_t FrameTripleBuffer::get_overwritten() const { return overwritten.load(std::memory_order_relaxed); }
@@ -0,0 +1,44 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>  // For the shared slot index
+#include <cstdint> // For uint8_t and uint64_t
+#include "display.h"
+
+// A finished frame as handed from the emulation thread to the render thread
+struct PublishedFrame {
+    uint8_t display_state[DISPLAY_STATE_SIZE]; // Display::save_state image
+    uint64_t frame;                            // Machine frame number it was taken at
+};
+
+// Lock-free triple buffer for one producer and one consumer. The producer always has a
+// slot to write and the consumer always has a slot to read, so neither ever waits on the
+// other; a frame the consumer did not get to in time is simply replaced by a newer one.
+class FrameTripleBuffer {
+public:
+    FrameTripleBuffer();
+
+    // Producer: fill back(), then publish() it as the newest frame
+    PublishedFrame& back();
+    void publish();
+
+    // Consumer: swap in the newest published frame. Returns false (keeping the current
+    // front()) if nothing was published since the last take.
+    bool take();
+    const PublishedFrame& front() const;
+
+    // Frames published, and frames replaced before the consumer took them
+    uint64_t get_published() const;
+    uint64_t get_overwritten() const;
+
+private:
+    PublishedFrame slots[3];
+    int back_index;  // Owned by the producer
+    int front_index; // Owned by the consumer
+    // Index of the middle slot, with FRESH set while it holds a frame not yet taken
+    std::atomic<uint8_t> middle;
+    std::atomic<uint64_t> published;
+    std::atomic<uint64_t> overwritten;
+};
+
+#endif // TRIPLE_BUFFER_H